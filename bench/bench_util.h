@@ -0,0 +1,74 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Helpers shared by the benchmarks: timing, test frames and the comparison of
+// outputs that must match. A benchmark whose outputs differ by more than
+// their tolerance exits with 1, so that running it also checks correctness.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace gpupixel {
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double Milliseconds(Clock::time_point from,
+                           Clock::time_point to = Clock::now()) {
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// RGBA gradients across and down the frame, with the coordinates XORed into
+// blue so that neighboring pixels differ. `frame` shifts blue, so that
+// consecutive frames differ too.
+inline std::vector<uint8_t> TestPattern(int width, int height, int frame = 0) {
+  std::vector<uint8_t> pixels((size_t)width * height * 4);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      uint8_t* pixel = &pixels[((size_t)y * width + x) * 4];
+      pixel[0] = (uint8_t)(x * 255 / width);
+      pixel[1] = (uint8_t)(y * 255 / height);
+      pixel[2] = (uint8_t)((x ^ y) + frame * 64);
+      pixel[3] = 255;
+    }
+  }
+  return pixels;
+}
+
+// Largest difference between the bytes of a and b; 255 when their sizes
+// differ, e.g. because one of the outputs is missing
+inline int MaxDifference(const std::vector<uint8_t>& a,
+                         const std::vector<uint8_t>& b) {
+  if (a.size() != b.size()) {
+    return 255;
+  }
+  int max_difference = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    max_difference = std::max(max_difference, abs((int)a[i] - (int)b[i]));
+  }
+  return max_difference;
+}
+
+// False, reporting what differs on stderr, when difference is above
+// tolerance
+inline bool CheckDifference(const char* what, int difference, int tolerance) {
+  if (difference <= tolerance) {
+    return true;
+  }
+  fprintf(stderr, "FAILED: %s differs by %d, more than %d\n", what, difference,
+          tolerance);
+  return false;
+}
+
+}  // namespace bench
+}  // namespace gpupixel
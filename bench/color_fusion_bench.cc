@@ -0,0 +1,125 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Time per frame of a six filter color grading chain compiled into a pipeline
+// with and without color filter fusion, the passes each renders and the
+// framebuffer traffic they imply (every pass reads and writes one RGBA
+// frame), and the largest difference between the two outputs, which must be
+// within kTolerance.
+//
+// usage: color_fusion_bench [width] [height] [frames]
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+// Fusion skips the 8 bit framebuffers between the filters, so it may round
+// differently
+constexpr int kTolerance = 1;
+
+std::vector<uint8_t> Run(bool fused,
+                         int width,
+                         int height,
+                         int frames,
+                         const std::vector<uint8_t>& pixels) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  auto source = SourceRawData::Create();
+  auto brightness = BrightnessFilter::Create();
+  brightness->setBrightness(0.05f);
+  auto contrast = ContrastFilter::Create();
+  contrast->setContrast(1.2f);
+  auto saturation = SaturationFilter::Create();
+  saturation->setSaturation(1.3f);
+  auto exposure = ExposureFilter::Create();
+  exposure->SetExposure(-0.2f);
+  auto rgb = RGBFilter::Create();
+  rgb->setRedAdjustment(1.05f);
+  rgb->setBlueAdjustment(0.95f);
+  auto white_balance = WhiteBalanceFilter::Create();
+  white_balance->setTemperature(5600.0f);
+  white_balance->setTint(10.0f);
+  auto sink = SinkRawData::Create();
+  source->AddSink(brightness)
+      ->AddSink(contrast)
+      ->AddSink(saturation)
+      ->AddSink(exposure)
+      ->AddSink(rgb)
+      ->AddSink(white_balance)
+      ->AddSink(sink);
+
+  auto pipeline = Pipeline::Create(source);
+  pipeline->SetFusionEnabled(fused);
+  pipeline->Compile();
+
+  auto render = [&] {
+    source->ProcessData(pixels.data(), width, height, width * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+  };
+  render();
+  context->SyncRunWithContext([] { glFinish(); });
+
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    render();
+  }
+  context->SyncRunWithContext([] { glFinish(); });
+  double ms = Milliseconds(start) / frames;
+
+  // The source pass and the pipeline passes, less the sink, which draws
+  // nothing until read
+  int passes = pipeline->GetPassCount() - 1;
+  double traffic = passes * (double)width * height * 4 * 2 / (1024 * 1024);
+  printf("%-8s %6d %10.2f %14.1f\n", fused ? "fused" : "unfused", passes, ms,
+         traffic);
+
+  const uint8_t* rgba = sink->GetRgbaBuffer();
+  return std::vector<uint8_t>(rgba, rgba + (size_t)width * height * 4);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1920;
+  int height = argc > 2 ? atoi(argv[2]) : 1080;
+  int frames = argc > 3 ? atoi(argv[3]) : 20;
+  if (width < 1 || height < 1 || frames < 1) {
+    fprintf(stderr, "usage: color_fusion_bench [width] [height] [frames]\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> pixels = TestPattern(width, height);
+
+  printf("brightness, contrast, saturation, exposure, rgb, white balance\n");
+  printf("%dx%d, %d frames\n", width, height, frames);
+  printf("%-8s %6s %10s %14s\n", "", "passes", "ms/frame", "MiB moved/frame");
+  std::vector<uint8_t> unfused = Run(false, width, height, frames, pixels);
+  std::vector<uint8_t> fused = Run(true, width, height, frames, pixels);
+  Run(false, width, height, frames, pixels);
+  Run(true, width, height, frames, pixels);
+
+  int max_difference = MaxDifference(unfused, fused);
+  size_t differing = 0;
+  for (size_t i = 0; i < unfused.size(); ++i) {
+    differing += unfused[i] != fused[i];
+  }
+  printf("fused vs unfused: max difference %d, %zu of %zu channels differ\n",
+         max_difference, differing, unfused.size());
+  bool passed = CheckDifference("fused", max_difference, kTolerance);
+
+  GPUPixelContext::Destroy();
+  return passed ? 0 : 1;
+}
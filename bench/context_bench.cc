@@ -0,0 +1,84 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Measures GL context startup and per-frame throughput of a minimal
+// SourceRawData -> BrightnessFilter -> SinkRawData chain including readback.
+// Build with GPUPIXEL_LINUX_HEADLESS=ON to run without a display, e.g. under
+// Mesa llvmpipe in a container.
+//
+// usage: context_bench [width] [height] [frames]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1280;
+  int height = argc > 2 ? atoi(argv[2]) : 720;
+  int frames = argc > 3 ? atoi(argv[3]) : 200;
+  const int warmup = 10;
+
+  auto start = Clock::now();
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  double startup_ms = Milliseconds(start);
+
+  const char* renderer = nullptr;
+  context->SyncRunWithContext(
+      [&] { renderer = (const char*)glGetString(GL_RENDERER); });
+
+  start = Clock::now();
+  auto source = SourceRawData::Create();
+  auto filter = BrightnessFilter::Create(0.1f);
+  auto sink = SinkRawData::Create();
+  source->AddSink(filter)->AddSink(sink);
+  double graph_ms = Milliseconds(start);
+
+  std::vector<uint8_t> pixels((size_t)width * height * 4);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = (uint8_t)(i * 31);
+  }
+
+  FramebufferPoolStats stats;
+  for (int i = 0; i < warmup + frames; ++i) {
+    if (i == warmup) {
+      context->SyncRunWithContext(
+          [&] { context->GetFramebufferFactory()->ResetStats(); });
+      start = Clock::now();
+    }
+    source->ProcessData(pixels.data(), width, height, width * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+    sink->GetRgbaBuffer();
+  }
+  double frame_ms = Milliseconds(start) / frames;
+  context->SyncRunWithContext(
+      [&] { stats = context->GetFramebufferFactory()->GetStats(); });
+
+  printf("renderer:       %s\n", renderer ? renderer : "unknown");
+  printf("context startup %8.2f ms\n", startup_ms);
+  printf("graph setup     %8.2f ms\n", graph_ms);
+  printf("frame %dx%d  %8.2f ms  (%.1f fps, %d frames)\n", width, height,
+         frame_ms, 1000.0 / frame_ms, frames);
+  printf("framebuffer pool  %.2f hits/frame  %.2f misses/frame\n",
+         (double)stats.hits / frames, (double)stats.misses / frames);
+
+  sink.reset();
+  filter.reset();
+  source.reset();
+  GPUPixelContext::Destroy();
+  return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Compares the ring-buffer DispatchQueue against the previous mutex +
+// std::queue + promise implementation:
+//   - synchronous round-trip latency (p50 / p99)
+//   - synchronous and fire-and-forget throughput
+//   - heap allocations per submitted task
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <new>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "utils/dispatch_queue.h"
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+// The queue as it was before the ring buffer, kept here as the baseline
+class LegacyDispatchQueue {
+ public:
+  LegacyDispatchQueue() : running_(true) {
+    worker_ = std::thread([this]() {
+      worker_id_ = std::this_thread::get_id();
+      while (true) {
+        std::function<void()> task;
+        {
+          std::unique_lock<std::mutex> lk(m_);
+          cv_.wait(lk, [this]() { return !queue_.empty() || !running_; });
+          if (!running_ && queue_.empty()) {
+            return;
+          }
+          task = queue_.front();
+          queue_.pop();
+        }
+        task();
+      }
+    });
+  }
+
+  ~LegacyDispatchQueue() {
+    {
+      std::unique_lock<std::mutex> lk(m_);
+      running_ = false;
+    }
+    cv_.notify_one();
+    worker_.join();
+  }
+
+  void runTask(std::function<void()> task) {
+    std::promise<void> promise;
+    std::future<void> future = promise.get_future();
+    auto wrapped = [task, &promise]() {
+      task();
+      promise.set_value();
+    };
+    {
+      std::unique_lock<std::mutex> lk(m_);
+      queue_.push(wrapped);
+    }
+    cv_.notify_one();
+    future.wait();
+  }
+
+  void postTask(std::function<void()> task) {
+    {
+      std::unique_lock<std::mutex> lk(m_);
+      queue_.push(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+ private:
+  std::queue<std::function<void()>> queue_;
+  std::mutex m_;
+  std::condition_variable cv_;
+  std::thread worker_;
+  bool running_;
+  std::thread::id worker_id_;
+};
+
+using gpupixel::bench::Clock;
+
+constexpr int kWarmup = 2000;
+constexpr int kSyncIterations = 100000;
+constexpr int kPostIterations = 1000000;
+
+template <typename Queue>
+void RunSync(Queue& queue, const char* name) {
+  volatile int sink = 0;
+  for (int i = 0; i < kWarmup; ++i) {
+    queue.runTask([&]() { sink = sink + 1; });
+  }
+
+  std::vector<double> samples;
+  samples.reserve(kSyncIterations);
+  size_t allocations = g_allocations.load();
+  auto start = Clock::now();
+  for (int i = 0; i < kSyncIterations; ++i) {
+    auto t0 = Clock::now();
+    queue.runTask([&]() { sink = sink + 1; });
+    samples.push_back(
+        std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+  }
+  double total = std::chrono::duration<double>(Clock::now() - start).count();
+  allocations = g_allocations.load() - allocations;
+
+  std::sort(samples.begin(), samples.end());
+  printf("%-8s sync   p50 %8.0f ns  p99 %8.0f ns  %10.0f ops/s  "
+         "%.2f allocs/op\n",
+         name, samples[samples.size() / 2], samples[samples.size() * 99 / 100],
+         kSyncIterations / total, (double)allocations / kSyncIterations);
+}
+
+template <typename Queue>
+void RunPost(Queue& queue, const char* name) {
+  std::atomic<int> done{0};
+  size_t allocations = g_allocations.load();
+  auto start = Clock::now();
+  for (int i = 0; i < kPostIterations; ++i) {
+    queue.postTask([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+  }
+  queue.runTask([]() {});
+  double total = std::chrono::duration<double>(Clock::now() - start).count();
+  allocations = g_allocations.load() - allocations;
+
+  printf("%-8s post                                   %10.0f ops/s  %.2f "
+         "allocs/op\n",
+         name, kPostIterations / total, (double)allocations / kPostIterations);
+}
+
+}  // namespace
+
+int main() {
+  {
+    LegacyDispatchQueue legacy;
+    RunSync(legacy, "legacy");
+    RunPost(legacy, "legacy");
+  }
+  {
+    DispatchQueue ring;
+    RunSync(ring, "ring");
+    RunPost(ring, "ring");
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Per-pass CPU and GPU timings of the stages of composite filters, as
+// reported by GPUPixel::GetProfile, and the per-frame cost of profiling.
+//
+// usage: filter_profile_bench [frames] [size] [resource_dir]
+//   resource_dir holds res/, defaults to the directory above the executable
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+#include "utils/util.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+double RenderFrames(const std::shared_ptr<SourceRawData>& source,
+                    const std::vector<uint8_t>& pixels,
+                    int size,
+                    int frames) {
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    source->ProcessData(pixels.data(), size, size, size * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+  }
+  GPUPixelContext::GetInstance()->SyncRunWithContext([] { glFinish(); });
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+             .count() /
+         frames;
+}
+
+void Run(const char* name,
+         const std::function<std::shared_ptr<Filter>()>& create,
+         int frames,
+         int size) {
+  auto source = SourceRawData::Create();
+  auto filter = create();
+  auto sink = SinkRawData::Create();
+  source->AddSink(filter)->AddSink(sink);
+
+  std::vector<uint8_t> pixels(size * size * 4);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = (uint8_t)(i * 7 + i / (size * 4) * 13);
+  }
+
+  GPUPixel::SetProfilingEnabled(false);
+  RenderFrames(source, pixels, size, 3);
+  double off_us = RenderFrames(source, pixels, size, frames);
+  GPUPixel::SetProfilingEnabled(true);
+  GPUPixel::ResetProfile();
+  double on_us = RenderFrames(source, pixels, size, frames);
+  // Collects the queries of the last frames
+  RenderFrames(source, pixels, size, 3);
+  GPUPixel::SetProfilingEnabled(false);
+
+  printf("%s, %dx%d: %.1f us/frame unprofiled, %.1f profiled\n", name, size,
+         size, off_us, on_us);
+  printf("  %-40s %8s %8s %8s %8s %8s %8s\n", "pass", "cpu min", "cpu avg",
+         "cpu p99", "gpu min", "gpu avg", "gpu p99");
+  for (const FilterProfile& pass : GPUPixel::GetProfile()) {
+    if (pass.gpu_samples > 0) {
+      printf("  %-40.40s %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+             pass.name.c_str(), pass.cpu_min_ms, pass.cpu_avg_ms,
+             pass.cpu_p99_ms, pass.gpu_min_ms, pass.gpu_avg_ms,
+             pass.gpu_p99_ms);
+    } else {
+      printf("  %-40.40s %8.3f %8.3f %8.3f %8s %8s %8s\n", pass.name.c_str(),
+             pass.cpu_min_ms, pass.cpu_avg_ms, pass.cpu_p99_ms, "-", "-",
+             "-");
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 100;
+  int size = argc > 2 ? atoi(argv[2]) : 512;
+  if (frames < 1) {
+    frames = 1;
+  }
+  if (size < 1) {
+    size = 1;
+  }
+  Util::SetResourcePath(argc > 3 ? fs::path(argv[3])
+                                 : fs::absolute(argv[0])
+                                       .parent_path()
+                                       .parent_path());
+
+  Run("canny edge", [] { return CannyEdgeDetectionFilter::Create(); }, frames,
+      size);
+  Run("beauty face", [] { return BeautyFaceFilter::Create(); }, frames, size);
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
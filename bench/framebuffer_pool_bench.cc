@@ -0,0 +1,128 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Acquire / return cycles against the FramebufferFactory pool, compared with
+// creating a fresh framebuffer per request, with heap allocations counted.
+// Then repeats the pooled cycles under a memory budget that only fits the
+// largest size, so switching sizes has to evict.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_framebuffer_factory.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+constexpr int kSizes[][2] = {{1280, 720}, {640, 360}, {320, 180}};
+constexpr int kIterations = 100000;
+constexpr int kFreshIterations = 2000;
+
+void Report(const char* name, Clock::time_point start, size_t allocations,
+            int iterations) {
+  double ns = std::chrono::duration<double, std::nano>(Clock::now() - start)
+                  .count() /
+              iterations;
+  printf("%-10s %10.0f ns/op  %.2f allocs/op\n", name, ns,
+         (double)(g_allocations.load() - allocations) / iterations);
+}
+
+}  // namespace
+
+int main() {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->SyncRunWithContext([&] {
+    FramebufferFactory* factory = context->GetFramebufferFactory();
+
+    // Every op leases two framebuffers of one size and drops both, like a
+    // filter chain ping-ponging at a given resolution
+    auto cycle = [&](int i) {
+      const int* size = kSizes[i % 3];
+      auto a = factory->CreateFramebuffer(size[0], size[1]);
+      auto b = factory->CreateFramebuffer(size[0], size[1]);
+    };
+
+    for (int i = 0; i < 3; ++i) {
+      cycle(i);
+    }
+
+    size_t allocations = g_allocations.load();
+    auto start = Clock::now();
+    for (int i = 0; i < kIterations; ++i) {
+      cycle(i);
+    }
+    Report("pooled", start, allocations, kIterations);
+
+    allocations = g_allocations.load();
+    start = Clock::now();
+    for (int i = 0; i < kFreshIterations; ++i) {
+      const int* size = kSizes[i % 3];
+      auto a = std::make_shared<GPUPixelFramebuffer>(size[0], size[1]);
+      auto b = std::make_shared<GPUPixelFramebuffer>(size[0], size[1]);
+    }
+    Report("fresh", start, allocations, kFreshIterations);
+
+    FramebufferPoolStats stats = factory->GetStats();
+    printf("pool hits %llu  misses %llu  idle %zu  %.1f MB\n",
+           (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+           stats.idle, factory->GetTotalBytes() / 1048576.0);
+
+    factory->SetMemoryBudget(
+        2 * FramebufferFactory::GetTextureBytes(
+                kSizes[0][0], kSizes[0][1],
+                GPUPixelFramebuffer::default_texture_attributes));
+    factory->ResetStats();
+    allocations = g_allocations.load();
+    start = Clock::now();
+    for (int i = 0; i < kFreshIterations; ++i) {
+      cycle(i);
+    }
+    Report("budget", start, allocations, kFreshIterations);
+    stats = factory->GetStats();
+    printf("pool hits %llu  misses %llu  evictions %llu  %.1f MB\n",
+           (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+           (unsigned long long)stats.evictions,
+           factory->GetTotalBytes() / 1048576.0);
+
+    size_t freed = factory->Trim(0);
+    printf("trim freed %.1f MB, %zu bytes left\n", freed / 1048576.0,
+           factory->GetTotalBytes());
+  });
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
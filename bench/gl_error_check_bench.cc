@@ -0,0 +1,103 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Time per frame of a chain of brightness filters under each GL error check
+// mode: off, sampled every frame and every 30 frames, debug through KHR_debug
+// and debug checking glGetError after every GL call. Frames are queued back to
+// back, so a check that makes the CPU wait for the driver shows up in the time.
+//
+// usage: gl_error_check_bench [frames] [size] [passes]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+struct Tier {
+  const char* name;
+  GPUPIXEL_GL_ERROR_CHECK mode;
+  int sample_interval;
+  bool debug_output_allowed;
+};
+
+void Run(const Tier& tier, int frames, int size, int passes) {
+  GPUPixel::SetGLErrorCheck(tier.mode, tier.sample_interval);
+  GLErrorCheck::SetDebugOutputAllowed(tier.debug_output_allowed);
+
+  auto source = SourceRawData::Create();
+  std::shared_ptr<Source> tail = source;
+  std::vector<std::shared_ptr<Filter>> filters;
+  for (int i = 0; i < passes; ++i) {
+    filters.push_back(BrightnessFilter::Create());
+    tail = tail->AddSink(filters.back());
+  }
+
+  std::vector<uint8_t> pixels(size * size * 4, 128);
+  auto render = [&] {
+    source->ProcessData(pixels.data(), size, size, size * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+  };
+  // The context switches modes at the end of a frame
+  render();
+  render();
+
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    render();
+  }
+  GPUPixelContext::GetInstance()->SyncRunWithContext([] { glFinish(); });
+  double us =
+      std::chrono::duration<double, std::micro>(Clock::now() - start).count() /
+      frames;
+  printf("%-18s %10.1f\n", tier.name, us);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 300;
+  int size = argc > 2 ? atoi(argv[2]) : 256;
+  int passes = argc > 3 ? atoi(argv[3]) : 10;
+  if (frames < 1) {
+    frames = 1;
+  }
+  if (size < 1) {
+    size = 1;
+  }
+  if (passes < 1) {
+    passes = 1;
+  }
+
+  const Tier tiers[] = {
+      {"off", GPUPIXEL_GL_ERROR_CHECK_OFF, 1, true},
+      {"sampled 1/1", GPUPIXEL_GL_ERROR_CHECK_SAMPLED, 1, true},
+      {"sampled 1/30", GPUPIXEL_GL_ERROR_CHECK_SAMPLED, 30, true},
+      {"debug KHR_debug", GPUPIXEL_GL_ERROR_CHECK_DEBUG, 1, true},
+      {"debug per call", GPUPIXEL_GL_ERROR_CHECK_DEBUG, 1, false},
+  };
+
+  printf("%d brightness passes, %dx%d input, %d frames\n", passes, size, size,
+         frames);
+  printf("%-18s %10s\n", "", "us/frame");
+  for (int round = 0; round < 2; ++round) {
+    for (const auto& tier : tiers) {
+      Run(tier, frames, size, passes);
+    }
+  }
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// CPU time per pass of a chain of brightness filters on a tiny input, with the
+// context's GL state cache on and off, and the state changes per pass that
+// reached the driver or were skipped.
+//
+// usage: gl_state_bench [passes] [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+constexpr int kSize = 16;
+
+void Run(bool cache_enabled, int passes, int frames) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->SyncRunWithContext(
+      [&] { context->SetGlStateCacheEnabled(cache_enabled); });
+
+  auto source = SourceRawData::Create();
+  std::shared_ptr<Source> tail = source;
+  std::vector<std::shared_ptr<Filter>> filters;
+  for (int i = 0; i < passes; ++i) {
+    filters.push_back(BrightnessFilter::Create());
+    tail = tail->AddSink(filters.back());
+  }
+
+  std::vector<uint8_t> pixels(kSize * kSize * 4, 128);
+  auto render = [&] {
+    source->ProcessData(pixels.data(), kSize, kSize, kSize * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+  };
+  render();
+
+  GlStateStats before;
+  context->SyncRunWithContext([&] { before = context->GetGlStateStats(); });
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    render();
+  }
+  // Waits for the last frame to finish on the GPU so that deferred driver
+  // work is not left out
+  context->SyncRunWithContext([] { glFinish(); });
+  double us =
+      std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+  GlStateStats after;
+  context->SyncRunWithContext([&] { after = context->GetGlStateStats(); });
+
+  // The source draws a pass of its own
+  double per_pass = (double)frames * (passes + 1);
+  printf("%-4s %12.2f %14.2f %14.2f\n", cache_enabled ? "on" : "off",
+         us / per_pass, (after.calls - before.calls) / per_pass,
+         (after.skipped - before.skipped) / per_pass);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int passes = argc > 1 ? atoi(argv[1]) : 20;
+  int frames = argc > 2 ? atoi(argv[2]) : 500;
+  if (passes < 1) {
+    passes = 1;
+  }
+  if (frames < 1) {
+    frames = 1;
+  }
+
+  printf("%d brightness passes, %dx%d input, %d frames\n", passes, kSize,
+         kSize, frames);
+  printf("%-4s %12s %14s %14s\n", "", "us/pass", "changes/pass",
+         "skipped/pass");
+  Run(false, passes, frames);
+  Run(true, passes, frames);
+  Run(false, passes, frames);
+  Run(true, passes, frames);
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
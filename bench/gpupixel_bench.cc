@@ -0,0 +1,417 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Release benchmark: frames per second, per-frame latency percentiles and
+// framebuffer pool memory of every registered filter, a few stock image
+// filters, the beauty chain of the desktop demo, SourceRawData upload and
+// SinkRawData RGBA / I420 readback, at 360p, 720p, 1080p and 4K. A frame is
+// timed from submitting its input until the GPU has finished it. Runs on a
+// headless context, including Mesa llvmpipe, and writes the results as JSON
+// for comparing releases.
+//
+// usage: gpupixel_bench [options]
+//   --frames N         frames timed per case (default 30)
+//   --max-seconds S    stop a case after S seconds, once 3 frames are timed
+//                      (default 2)
+//   --sizes LIST       comma separated subset of 360p,720p,1080p,4k
+//   --cases TEXT       only cases whose name contains TEXT
+//   --json PATH        write the results as JSON to PATH
+//   --resource-dir DIR directory holding res/, defaults to the directory
+//                      above the executable
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+#include "utils/util.h"
+
+#ifndef GPUPIXEL_VERSION
+#define GPUPIXEL_VERSION "unknown"
+#endif
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+struct Size {
+  const char* name;
+  int width;
+  int height;
+};
+
+const Size kSizes[] = {
+    {"360p", 640, 360},
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"4k", 3840, 2160},
+};
+
+struct Options {
+  int frames = 30;
+  double max_seconds = 2;
+  std::vector<std::string> sizes;
+  std::string cases;
+  std::string json_path;
+};
+
+// Builds the graph of a case; the returned function renders one frame
+using Setup = std::function<std::function<void()>(
+    const std::shared_ptr<SourceRawData>& source,
+    const std::vector<uint8_t>& pixels,
+    int width,
+    int height)>;
+
+struct Case {
+  std::string name;
+  std::string group;
+  Setup setup;
+};
+
+struct Result {
+  std::string name;
+  std::string group;
+  const Size* size;
+  int frames;
+  double fps;
+  double mean_ms;
+  double p50_ms;
+  double p90_ms;
+  double p99_ms;
+  double max_ms;
+  size_t framebuffer_bytes;
+};
+
+void Process(const std::shared_ptr<SourceRawData>& source,
+             const std::vector<uint8_t>& pixels,
+             int width,
+             int height) {
+  source->ProcessData(pixels.data(), width, height, width * 4,
+                      GPUPIXEL_FRAME_TYPE_RGBA);
+}
+
+// Input feeding one filter, rendered without reading the result back
+Case FilterCase(const std::string& name,
+                const std::string& group,
+                std::function<std::shared_ptr<Filter>()> create) {
+  return {name, group,
+          [create](const std::shared_ptr<SourceRawData>& source,
+                   const std::vector<uint8_t>& pixels, int width, int height) {
+            auto filter = create();
+            source->AddSink(filter);
+            return std::function<void()>([=, &pixels] {
+              (void)filter;
+              Process(source, pixels, width, height);
+            });
+          }};
+}
+
+std::vector<Case> MakeCases() {
+  std::vector<Case> cases;
+  for (const std::string& name : Filter::GetFilterClassNames()) {
+    // Renders nothing until given a makeup image, which its subclasses load
+    if (name == "FaceMakeupFilter") {
+      continue;
+    }
+    cases.push_back(
+        FilterCase(name, "filter", [name] { return Filter::Create(name); }));
+  }
+
+  cases.push_back(FilterCase("BrightnessFilter", "filter",
+                             [] { return BrightnessFilter::Create(); }));
+  cases.push_back(FilterCase("BoxBlurFilter", "filter",
+                             [] { return BoxBlurFilter::Create(); }));
+  cases.push_back(FilterCase("BilateralFilter", "filter",
+                             [] { return BilateralFilter::Create(); }));
+  cases.push_back(
+      FilterCase("SobelEdgeDetectionFilter", "filter",
+                 [] { return SobelEdgeDetectionFilter::Create(); }));
+  cases.push_back(
+      FilterCase("CannyEdgeDetectionFilter", "filter",
+                 [] { return CannyEdgeDetectionFilter::Create(); }));
+  cases.push_back(FilterCase("ToonFilter", "filter",
+                             [] { return ToonFilter::Create(); }));
+  cases.push_back(FilterCase("SketchFilter", "filter",
+                             [] { return SketchFilter::Create(); }));
+
+  // Same order as the desktop demo
+  cases.push_back(
+      {"beauty_chain", "chain",
+       [](const std::shared_ptr<SourceRawData>& source,
+          const std::vector<uint8_t>& pixels, int width, int height) {
+         auto lipstick = LipstickFilter::Create();
+         auto blusher = BlusherFilter::Create();
+         auto reshape = FaceReshapeFilter::Create();
+         auto beauty = BeautyFaceFilter::Create();
+         beauty->SetBlurAlpha(0.6f);
+         beauty->SetWhite(0.2f);
+         source->AddSink(lipstick)
+             ->AddSink(blusher)
+             ->AddSink(reshape)
+             ->AddSink(beauty);
+         return std::function<void()>([=, &pixels] {
+           (void)lipstick;
+           Process(source, pixels, width, height);
+         });
+       }});
+
+  cases.push_back({"upload", "io",
+                   [](const std::shared_ptr<SourceRawData>& source,
+                      const std::vector<uint8_t>& pixels, int width,
+                      int height) {
+                     return std::function<void()>([=, &pixels] {
+                       Process(source, pixels, width, height);
+                     });
+                   }});
+
+  cases.push_back({"readback_rgba", "io",
+                   [](const std::shared_ptr<SourceRawData>& source,
+                      const std::vector<uint8_t>& pixels, int width,
+                      int height) {
+                     auto sink = SinkRawData::Create();
+                     source->AddSink(sink);
+                     return std::function<void()>([=, &pixels] {
+                       Process(source, pixels, width, height);
+                       sink->GetRgbaBuffer();
+                     });
+                   }});
+
+  cases.push_back({"readback_i420", "io",
+                   [](const std::shared_ptr<SourceRawData>& source,
+                      const std::vector<uint8_t>& pixels, int width,
+                      int height) {
+                     auto sink = SinkRawData::Create();
+                     source->AddSink(sink);
+                     return std::function<void()>([=, &pixels] {
+                       Process(source, pixels, width, height);
+                       sink->GetI420Buffer();
+                     });
+                   }});
+  return cases;
+}
+
+double Percentile(const std::vector<double>& sorted, int percent) {
+  size_t index = (sorted.size() * percent + 99) / 100;
+  return sorted[index > 0 ? index - 1 : 0];
+}
+
+Result Run(const Case& test_case, const Size& size, const Options& options) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  // Only what this case keeps in the pool is counted
+  context->SyncRunWithContext(
+      [&] { context->GetFramebufferFactory()->Trim(0); });
+
+  // A gradient, so that filters do not see a flat image
+  std::vector<uint8_t> pixels((size_t)size.width * size.height * 4);
+  for (int y = 0; y < size.height; ++y) {
+    for (int x = 0; x < size.width; ++x) {
+      uint8_t* pixel = &pixels[((size_t)y * size.width + x) * 4];
+      pixel[0] = (uint8_t)(x * 255 / size.width);
+      pixel[1] = (uint8_t)(y * 255 / size.height);
+      pixel[2] = (uint8_t)((x + y) & 0xff);
+      pixel[3] = 255;
+    }
+  }
+
+  auto source = SourceRawData::Create();
+  std::function<void()> render =
+      test_case.setup(source, pixels, size.width, size.height);
+  auto frame = [&] {
+    render();
+    context->SyncRunWithContext([] { glFinish(); });
+  };
+  // Shader compilation, first allocations and pool warm-up
+  frame();
+  frame();
+
+  std::vector<double> latencies;
+  auto start = Clock::now();
+  for (int i = 0; i < options.frames; ++i) {
+    auto frame_start = Clock::now();
+    frame();
+    auto frame_end = Clock::now();
+    latencies.push_back(Milliseconds(frame_start, frame_end));
+    if (latencies.size() >= 3 &&
+        std::chrono::duration<double>(frame_end - start).count() >
+            options.max_seconds) {
+      break;
+    }
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  Result result;
+  result.name = test_case.name;
+  result.group = test_case.group;
+  result.size = &size;
+  result.frames = (int)latencies.size();
+  result.fps = latencies.size() / seconds;
+  std::sort(latencies.begin(), latencies.end());
+  double sum = 0;
+  for (double latency : latencies) {
+    sum += latency;
+  }
+  result.mean_ms = sum / latencies.size();
+  result.p50_ms = Percentile(latencies, 50);
+  result.p90_ms = Percentile(latencies, 90);
+  result.p99_ms = Percentile(latencies, 99);
+  result.max_ms = latencies.back();
+  context->SyncRunWithContext([&] {
+    result.framebuffer_bytes =
+        context->GetFramebufferFactory()->GetTotalBytes();
+  });
+  return result;
+}
+
+std::string JsonString(const std::string& text) {
+  std::string json = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      json += '\\';
+    }
+    json += c;
+  }
+  return json + "\"";
+}
+
+bool WriteJson(const std::string& path,
+               const Options& options,
+               const std::vector<Result>& results) {
+  std::string renderer;
+  std::string gl_version;
+  GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    const char* value = (const char*)glGetString(GL_RENDERER);
+    renderer = value ? value : "";
+    value = (const char*)glGetString(GL_VERSION);
+    gl_version = value ? value : "";
+  });
+
+  FILE* file = fopen(path.c_str(), "w");
+  if (!file) {
+    return false;
+  }
+  fprintf(file, "{\n  \"version\": %s,\n",
+          JsonString(GPUPIXEL_VERSION).c_str());
+  fprintf(file, "  \"renderer\": %s,\n", JsonString(renderer).c_str());
+  fprintf(file, "  \"gl_version\": %s,\n", JsonString(gl_version).c_str());
+  fprintf(file, "  \"frames\": %d,\n  \"max_seconds\": %g,\n", options.frames,
+          options.max_seconds);
+  fprintf(file, "  \"results\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& result = results[i];
+    fprintf(file,
+            "%s\n    {\"case\": %s, \"group\": %s, \"size\": %s, "
+            "\"width\": %d, \"height\": %d, \"frames\": %d, \"fps\": %.3f, "
+            "\"latency_ms\": {\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+            "\"p99\": %.3f, \"max\": %.3f}, \"framebuffer_bytes\": %zu}",
+            i ? "," : "", JsonString(result.name).c_str(),
+            JsonString(result.group).c_str(),
+            JsonString(result.size->name).c_str(), result.size->width,
+            result.size->height, result.frames, result.fps, result.mean_ms,
+            result.p50_ms, result.p90_ms, result.p99_ms, result.max_ms,
+            result.framebuffer_bytes);
+  }
+  fprintf(file, "\n  ]\n}\n");
+  return fclose(file) == 0;
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  fs::path resource_dir =
+      fs::absolute(argv[0]).lexically_normal().parent_path().parent_path();
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value) {
+      fprintf(stderr, "missing value for %s\n", arg.c_str());
+      return false;
+    }
+    ++i;
+    if (arg == "--frames") {
+      options->frames = std::max(1, atoi(value));
+    } else if (arg == "--max-seconds") {
+      options->max_seconds = atof(value);
+    } else if (arg == "--sizes") {
+      std::string list = value;
+      size_t begin = 0;
+      while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == std::string::npos) {
+          end = list.size();
+        }
+        options->sizes.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+      }
+    } else if (arg == "--cases") {
+      options->cases = value;
+    } else if (arg == "--json") {
+      options->json_path = value;
+    } else if (arg == "--resource-dir") {
+      resource_dir = value;
+    } else {
+      fprintf(stderr, "unknown option %s\n", arg.c_str());
+      return false;
+    }
+  }
+  Util::SetResourcePath(resource_dir);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    return 2;
+  }
+
+  std::vector<const Size*> sizes;
+  for (const Size& size : kSizes) {
+    if (options.sizes.empty() ||
+        std::find(options.sizes.begin(), options.sizes.end(), size.name) !=
+            options.sizes.end()) {
+      sizes.push_back(&size);
+    }
+  }
+
+  printf("%-26s %-6s %7s %9s %9s %9s %9s %10s\n", "case", "size", "frames",
+         "fps", "p50 ms", "p90 ms", "p99 ms", "fb MiB");
+  std::vector<Result> results;
+  for (const Case& test_case : MakeCases()) {
+    if (test_case.name.find(options.cases) == std::string::npos) {
+      continue;
+    }
+    for (const Size* size : sizes) {
+      Result result = Run(test_case, *size, options);
+      printf("%-26s %-6s %7d %9.2f %9.2f %9.2f %9.2f %10.1f\n",
+             result.name.c_str(), size->name, result.frames, result.fps,
+             result.p50_ms, result.p90_ms, result.p99_ms,
+             result.framebuffer_bytes / (1024.0 * 1024.0));
+      fflush(stdout);
+      results.push_back(result);
+    }
+  }
+
+  int status = 0;
+  if (!options.json_path.empty()) {
+    if (WriteJson(options.json_path, options, results)) {
+      printf("results written to %s\n", options.json_path.c_str());
+    } else {
+      fprintf(stderr, "failed to write %s\n", options.json_path.c_str());
+      status = 1;
+    }
+  }
+
+  GPUPixelContext::Destroy();
+  return status;
+}
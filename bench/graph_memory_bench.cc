@@ -0,0 +1,106 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Peak framebuffer memory of a few filter graphs fed by SourceRawData into
+// SinkRawData. The pool only grows when no idle framebuffer fits, so the bytes
+// it owns after a few frames are the peak the graph needed at once. Reported
+// in full RGBA frames of the input size.
+//
+// usage: graph_memory_bench [width] [height] [frames]
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_framebuffer_factory.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+
+namespace {
+
+struct Graph {
+  const char* name;
+  std::function<std::shared_ptr<Filter>()> build;
+};
+
+std::shared_ptr<Filter> BrightnessChain(int stages) {
+  auto group = FilterGroup::Create();
+  std::shared_ptr<Filter> head = BrightnessFilter::Create(0.01f);
+  std::shared_ptr<Filter> tail = head;
+  for (int i = 1; i < stages; ++i) {
+    auto next = BrightnessFilter::Create(0.01f);
+    tail->AddSink(next);
+    tail = next;
+  }
+  group->AddFilter(head);
+  return group;
+}
+
+void Run(const Graph& graph,
+         int width,
+         int height,
+         int frames,
+         const std::vector<uint8_t>& pixels) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  FramebufferFactory* factory = context->GetFramebufferFactory();
+  context->SyncRunWithContext([&] { factory->Clean(); });
+
+  auto source = SourceRawData::Create();
+  auto filter = graph.build();
+  auto sink = SinkRawData::Create();
+  source->AddSink(filter)->AddSink(sink);
+
+  for (int i = 0; i < frames; ++i) {
+    source->ProcessData(pixels.data(), width, height, width * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+    sink->GetRgbaBuffer();
+  }
+
+  size_t bytes = 0;
+  FramebufferPoolStats stats;
+  context->SyncRunWithContext([&] {
+    bytes = factory->GetTotalBytes();
+    stats = factory->GetStats();
+  });
+  printf("%-20s %3zu framebuffers  %7.1f MB  %5.2f frames\n", graph.name,
+         stats.in_use + stats.idle, bytes / 1048576.0,
+         (double)bytes / ((size_t)width * height * 4));
+
+  sink.reset();
+  filter.reset();
+  source.reset();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1280;
+  int height = argc > 2 ? atoi(argv[2]) : 720;
+  int frames = argc > 3 ? atoi(argv[3]) : 5;
+
+  std::vector<uint8_t> pixels((size_t)width * height * 4);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = (uint8_t)(i * 31);
+  }
+
+  const Graph graphs[] = {
+      {"brightness x5", [] { return BrightnessChain(5); }},
+      {"canny edge", [] { return CannyEdgeDetectionFilter::Create(); }},
+      {"ios blur", [] { return IOSBlurFilter::Create(); }},
+  };
+
+  printf("%dx%d, %d frames\n", width, height, frames);
+  for (const auto& graph : graphs) {
+    Run(graph, width, height, frames, pixels);
+  }
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
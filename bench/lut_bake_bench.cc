@@ -0,0 +1,159 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Time per frame of color adjustment chains of growing length, rendered as
+// one pass per filter and as a LutBakeFilter, the time of a frame that bakes
+// the LUT again after a setting changed, the bakes done in all (once before
+// the first frame, once after the change), and the largest difference between
+// the outputs of the two, which must be within kTolerance.
+//
+// usage: lut_bake_bench [width] [height] [frames]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+// Interpolating between the 64 levels of the LUT rounds differently from the
+// chain, the more the longer it is
+constexpr int kTolerance = 8;
+
+// Cycled through to build chains of any length
+std::shared_ptr<Filter> CreateStage(int index) {
+  switch (index % 6) {
+    case 0: {
+      auto filter = HueFilter::Create();
+      filter->setHueAdjustment(10.0f);
+      return filter;
+    }
+    case 1: {
+      auto filter = SaturationFilter::Create();
+      filter->setSaturation(1.1f);
+      return filter;
+    }
+    case 2: {
+      auto filter = ContrastFilter::Create();
+      filter->setContrast(1.1f);
+      return filter;
+    }
+    case 3: {
+      auto filter = ExposureFilter::Create();
+      filter->SetExposure(0.1f);
+      return filter;
+    }
+    case 4: {
+      auto filter = ColorMatrixFilter::Create();
+      filter->setIntensity(0.5f);
+      return filter;
+    }
+    default: {
+      auto filter = WhiteBalanceFilter::Create();
+      filter->setTemperature(5200.0f);
+      return filter;
+    }
+  }
+}
+
+struct Result {
+  double ms = 0;
+  // Frame after a setting changed, and LUT bakes; LutBakeFilter only
+  double rebake_ms = 0;
+  int bakes = 0;
+  std::vector<uint8_t> rgba;
+};
+
+Result Run(bool baked,
+           int stages,
+           int width,
+           int height,
+           int frames,
+           const std::vector<uint8_t>& pixels) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  std::vector<std::shared_ptr<Filter>> filters;
+  for (int i = 0; i < stages; ++i) {
+    filters.push_back(CreateStage(i));
+  }
+  auto source = SourceRawData::Create();
+  auto sink = SinkRawData::Create();
+  std::shared_ptr<LutBakeFilter> lut;
+  if (baked) {
+    lut = LutBakeFilter::Create(filters);
+    source->AddSink(lut)->AddSink(sink);
+  } else {
+    std::shared_ptr<Source> tail = source;
+    for (const auto& filter : filters) {
+      tail = tail->AddSink(filter);
+    }
+    tail->AddSink(sink);
+  }
+
+  auto render = [&] {
+    source->ProcessData(pixels.data(), width, height, width * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+    context->SyncRunWithContext([] { glFinish(); });
+  };
+  render();
+
+  Result result;
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    render();
+  }
+  result.ms = Milliseconds(start) / frames;
+  const uint8_t* rgba = sink->GetRgbaBuffer();
+  result.rgba.assign(rgba, rgba + (size_t)width * height * 4);
+
+  if (lut) {
+    // A slider move
+    filters[0]->SetProperty("hueAdjustment", 20.0f);
+    start = Clock::now();
+    render();
+    result.rebake_ms = Milliseconds(start);
+    result.bakes = lut->GetBakeCount();
+  }
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1280;
+  int height = argc > 2 ? atoi(argv[2]) : 720;
+  int frames = argc > 3 ? atoi(argv[3]) : 20;
+  if (width < 1 || height < 1 || frames < 1) {
+    fprintf(stderr, "usage: lut_bake_bench [width] [height] [frames]\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> pixels = TestPattern(width, height);
+
+  printf("%dx%d, %d frames\n", width, height, frames);
+  printf("%6s %14s %12s %10s %6s %9s\n", "stages", "chain ms/frame",
+         "lut ms/frame", "rebake ms", "bakes", "max diff");
+  bool passed = true;
+  for (int stages : {1, 2, 4, 8, 12}) {
+    Result chain = Run(false, stages, width, height, frames, pixels);
+    Result lut = Run(true, stages, width, height, frames, pixels);
+    int max_difference = MaxDifference(chain.rgba, lut.rgba);
+    printf("%6d %14.2f %12.2f %10.2f %6d %9d\n", stages, chain.ms, lut.ms,
+           lut.rebake_ms, lut.bakes, max_difference);
+    char name[32];
+    snprintf(name, sizeof(name), "%d stage lut", stages);
+    passed &= CheckDifference(name, max_difference, kTolerance);
+  }
+
+  GPUPixelContext::Destroy();
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Runs N independent SourceRawData -> BrightnessFilter -> SinkRawData streams
+// from N threads, first all on the default context (one GL thread) and then
+// each on its own GPUPixelContext, and reports aggregate throughput.
+//
+// usage: multi_context_bench [streams] [width] [height] [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+void RunStream(GPUPixelContext* context,
+               int width,
+               int height,
+               int frames,
+               const std::vector<uint8_t>& pixels) {
+  GPUPixelContext::Scope scope(context);
+  auto source = SourceRawData::Create();
+  auto filter = BrightnessFilter::Create(0.1f);
+  auto sink = SinkRawData::Create();
+  source->AddSink(filter)->AddSink(sink);
+
+  for (int i = 0; i < frames; ++i) {
+    source->ProcessData(pixels.data(), width, height, width * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+    sink->GetRgbaBuffer();
+  }
+}
+
+double RunAll(const std::vector<GPUPixelContext*>& contexts,
+              int width,
+              int height,
+              int frames,
+              const std::vector<uint8_t>& pixels) {
+  auto start = Clock::now();
+  std::vector<std::thread> threads;
+  for (auto* context : contexts) {
+    threads.emplace_back(RunStream, context, width, height, frames,
+                         std::cref(pixels));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return contexts.size() * frames / seconds;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int streams = argc > 1 ? atoi(argv[1]) : 4;
+  int width = argc > 2 ? atoi(argv[2]) : 640;
+  int height = argc > 3 ? atoi(argv[3]) : 360;
+  int frames = argc > 4 ? atoi(argv[4]) : 100;
+
+  std::vector<uint8_t> pixels((size_t)width * height * 4);
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = (uint8_t)(i * 31);
+  }
+
+  std::vector<GPUPixelContext*> shared(streams,
+                                       GPUPixelContext::GetInstance());
+  double shared_fps = RunAll(shared, width, height, frames, pixels);
+
+  std::vector<std::shared_ptr<GPUPixelContext>> owned;
+  std::vector<GPUPixelContext*> independent;
+  for (int i = 0; i < streams; ++i) {
+    owned.push_back(GPUPixelContext::Create());
+    independent.push_back(owned.back().get());
+  }
+  double independent_fps = RunAll(independent, width, height, frames, pixels);
+
+  printf("%d streams %dx%d, %d frames each, %u hardware threads\n", streams,
+         width, height, frames, std::thread::hardware_concurrency());
+  printf("default context      %8.1f frames/s\n", shared_fps);
+  printf("context per stream   %8.1f frames/s\n", independent_fps);
+
+  owned.clear();
+  GPUPixelContext::Destroy();
+  return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// CPU time per frame of 20 filter graph on a tiny input, rendered by the
+// recursive push from the source, by a compiled pipeline with color fusion
+// off, which only flattens the graph, and by one with fusion on, which also
+// merges the brightness filters into fewer passes. The graph is either one
+// chain of brightness filters or four branches of five.
+//
+// usage: pipeline_bench [frames]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+constexpr int kSize = 16;
+constexpr int kNodes = 20;
+
+enum Mode { kRecursive, kCompiled, kFused };
+
+void Run(const char* shape, int branches, Mode mode, int frames) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  auto source = SourceRawData::Create();
+  std::vector<std::shared_ptr<Filter>> filters;
+  for (int branch = 0; branch < branches; ++branch) {
+    std::shared_ptr<Source> tail = source;
+    for (int i = 0; i < kNodes / branches; ++i) {
+      filters.push_back(BrightnessFilter::Create());
+      tail = tail->AddSink(filters.back());
+    }
+  }
+  auto pipeline = Pipeline::Create(source);
+  // The source and every filter draw once when pushed recursively
+  int passes = kNodes + 1;
+  if (mode != kRecursive) {
+    pipeline->SetFusionEnabled(mode == kFused);
+    pipeline->Compile();
+    passes = pipeline->GetPassCount();
+  }
+
+  std::vector<uint8_t> pixels(kSize * kSize * 4, 128);
+  auto render = [&] {
+    source->ProcessData(pixels.data(), kSize, kSize, kSize * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+  };
+  render();
+  context->SyncRunWithContext([] { glFinish(); });
+
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    render();
+  }
+  // Waits for the last frame to finish on the GPU so that deferred driver
+  // work is not left out
+  context->SyncRunWithContext([] { glFinish(); });
+  double us =
+      std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+  const char* names[] = {"recursive", "compiled", "fused"};
+  printf("%-9s %-10s %6d %12.2f %12.2f\n", shape, names[mode], passes,
+         us / frames, us / frames / passes);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 500;
+  if (frames < 1) {
+    frames = 1;
+  }
+
+  printf("%d brightness filters, %dx%d input, %d frames\n", kNodes, kSize,
+         kSize, frames);
+  printf("%-9s %-10s %6s %12s %12s\n", "graph", "render", "passes",
+         "us/frame", "us/pass");
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    for (Mode mode : {kRecursive, kCompiled, kFused}) {
+      Run("chain", 1, mode, frames);
+    }
+    for (Mode mode : {kRecursive, kCompiled, kFused}) {
+      Run("branches", 4, mode, frames);
+    }
+  }
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Startup cost of creating a set of filters with the on-disk program binary
+// cache off, cold (compile, link and store) and warm (load the binaries).
+// Programs are released between phases so the in-memory program cache does
+// not serve any of them. Mesa keeps its own shader cache, which the first phase
+// fills; point MESA_SHADER_CACHE_DIR at an empty directory so that "off" is a
+// true cold start. Mesa only offers binary formats while its cache is enabled.
+//
+// usage: program_binary_cache_bench [cache_dir]
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_program_cache.h"
+#include "gpupixel/gpupixel.h"
+#include "utils/util.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+double CreateFilters() {
+  const std::function<std::shared_ptr<Filter>()> creators[] = {
+      [] { return CannyEdgeDetectionFilter::Create(); },
+      [] { return BilateralFilter::Create(); },
+      [] { return BoxHighPassFilter::Create(); },
+      [] { return GaussianBlurFilter::Create(4); },
+      [] { return GaussianBlurFilter::Create(8); },
+      [] { return SaturationFilter::Create(); },
+      [] { return ToonFilter::Create(); },
+      [] { return SketchFilter::Create(); },
+  };
+
+  auto start = Clock::now();
+  std::vector<std::shared_ptr<Filter>> filters;
+  for (const auto& create : creators) {
+    filters.push_back(create());
+  }
+  double ms = Milliseconds(start);
+  filters.clear();
+  return ms;
+}
+
+void Report(const char* phase, double ms) {
+  ProgramBinaryCacheStats stats = ProgramBinaryCache::GetStats();
+  printf("%-6s %9.2f ms   loads %llu  stores %llu  rejects %llu\n", phase, ms,
+         (unsigned long long)stats.loads, (unsigned long long)stats.stores,
+         (unsigned long long)stats.rejects);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  fs::path cache_dir = argc > 1 ? fs::path(argv[1])
+                                : fs::temp_directory_path() /
+                                      "gpupixel_program_binary_cache_bench";
+  std::error_code error;
+  fs::remove_all(cache_dir, error);
+
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  bool enabled = false;
+  GPUPixel::SetProgramCachePath(cache_dir.string());
+  context->SyncRunWithContext(
+      [&] { enabled = ProgramBinaryCache::IsEnabled(); });
+  GPUPixel::SetProgramCachePath("");
+  if (!enabled) {
+    printf("driver exposes no program binary formats, cache inactive\n");
+  }
+
+  Report("off", CreateFilters());
+
+  GPUPixel::SetProgramCachePath(cache_dir.string());
+  Report("cold", CreateFilters());
+  Report("warm", CreateFilters());
+
+  fs::remove_all(cache_dir, error);
+  GPUPixelContext::Destroy();
+  return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Creates several instances of a few composite filters and compares the first
+// instance, which compiles and links its programs, with the later ones served
+// by the program cache: creation time and, on Linux, resident memory growth,
+// which includes the driver's compiled shader code for software renderers.
+//
+// usage: program_cache_bench [instances]
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_program.h"
+#include "gpupixel/gpupixel.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+struct Kind {
+  const char* name;
+  std::function<std::shared_ptr<Filter>()> create;
+};
+
+// Resident set size in KB, 0 where unknown
+long ResidentKb() {
+#if defined(__linux__)
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (!file) {
+    return 0;
+  }
+  long pages = 0;
+  long resident = 0;
+  if (fscanf(file, "%ld %ld", &pages, &resident) != 2) {
+    resident = 0;
+  }
+  fclose(file);
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+  return 0;
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int instances = argc > 1 ? atoi(argv[1]) : 10;
+  if (instances < 2) {
+    instances = 2;
+  }
+
+  GPUPixelContext::GetInstance();
+
+  const Kind kinds[] = {
+      {"canny edge", [] { return CannyEdgeDetectionFilter::Create(); }},
+      {"box high pass", [] { return BoxHighPassFilter::Create(); }},
+      {"bilateral", [] { return BilateralFilter::Create(); }},
+      {"smooth toon", [] { return SmoothToonFilter::Create(); }},
+  };
+
+  printf("%d instances each\n", instances);
+  printf("%-14s %10s %10s %10s %10s\n", "", "first ms", "next ms", "first KB",
+         "next KB");
+  std::vector<std::shared_ptr<Filter>> filters;
+  for (const auto& kind : kinds) {
+    long rss = ResidentKb();
+    auto start = Clock::now();
+    filters.push_back(kind.create());
+    double first_ms = Milliseconds(start);
+    long first_kb = ResidentKb() - rss;
+
+    rss = ResidentKb();
+    start = Clock::now();
+    for (int i = 1; i < instances; ++i) {
+      filters.push_back(kind.create());
+    }
+    double next_ms = Milliseconds(start) / (instances - 1);
+    long next_kb = (ResidentKb() - rss) / (instances - 1);
+
+    printf("%-14s %10.3f %10.3f %10ld %10ld\n", kind.name, first_ms, next_ms,
+           first_kb, next_kb);
+  }
+
+  GPUPixelGLProgramCacheStats stats = GPUPixelGLProgram::GetCacheStats();
+  printf("programs linked %zu for %zu users (%llu hits, %llu misses)\n",
+         stats.programs, stats.references, (unsigned long long)stats.hits,
+         (unsigned long long)stats.misses);
+
+  filters.clear();
+  stats = GPUPixelGLProgram::GetCacheStats();
+  printf("after release: %zu programs, %zu users\n", stats.programs,
+         stats.references);
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Reads every frame of a stream back from SinkRawData, synchronously through
+// GetRgbaBuffer after each frame and asynchronously through readback rings of
+// 2 and 3 pixel pack buffers. Prints how long each frame holds the caller,
+// the latency from handing a frame in to getting its pixels, frames per
+// second until the last frame is read, the frames the rings dropped and the
+// largest difference between the last frame read each way, which must be
+// none.
+//
+// usage: readback_bench [width] [height] [frames]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+struct Result {
+  bool supported = true;
+  double caller_ms = 0;
+  double latency_ms = 0;
+  double fps = 0;
+  uint64_t dropped = 0;
+  // Every frame either delivered or dropped
+  bool complete = true;
+  std::vector<uint8_t> rgba;
+};
+
+Result Run(int ring_size,
+           int width,
+           int height,
+           int frames,
+           const std::vector<std::vector<uint8_t>>& pixels) {
+  auto source = SourceRawData::Create();
+  auto filter = BrightnessFilter::Create();
+  filter->setBrightness(0.1f);
+  auto sink = SinkRawData::Create();
+  source->AddSink(filter)->AddSink(sink);
+
+  Result result;
+  // Frames up to this one warm up and are not counted
+  constexpr uint64_t kWarmUpFrames = 3;
+  // When each counted frame was handed in
+  std::vector<Clock::time_point> submitted;
+  uint64_t delivered = 0;
+  if (ring_size > 0) {
+    bool supported = sink->SetAsyncReadback(
+        [&](const uint8_t* rgba, int, int, uint64_t frame) {
+          if (frame <= kWarmUpFrames) {
+            return;
+          }
+          auto now = Clock::now();
+          result.latency_ms +=
+              Milliseconds(submitted[frame - kWarmUpFrames - 1], now);
+          result.rgba.assign(rgba, rgba + (size_t)width * height * 4);
+          ++delivered;
+        },
+        ring_size);
+    if (!supported) {
+      result.supported = false;
+      return result;
+    }
+  }
+
+  for (uint64_t i = 0; i < kWarmUpFrames; ++i) {
+    source->ProcessData(pixels[0].data(), width, height, width * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+  }
+  if (ring_size > 0) {
+    sink->FlushAsyncReadback();
+  }
+  uint64_t warm_up_dropped = sink->GetDroppedReadbackFrames();
+
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    auto call = Clock::now();
+    submitted.push_back(call);
+    source->ProcessData(pixels[i % pixels.size()].data(), width, height,
+                        width * 4, GPUPIXEL_FRAME_TYPE_RGBA);
+    if (ring_size == 0) {
+      const uint8_t* rgba = sink->GetRgbaBuffer();
+      result.latency_ms += Milliseconds(call) / frames;
+      if (i == frames - 1) {
+        result.rgba.assign(rgba, rgba + (size_t)width * height * 4);
+      }
+    }
+    result.caller_ms += Milliseconds(call) / frames;
+  }
+  if (ring_size > 0) {
+    sink->FlushAsyncReadback();
+    result.dropped = sink->GetDroppedReadbackFrames() - warm_up_dropped;
+    if (delivered > 0) {
+      result.latency_ms /= delivered;
+    }
+    if (delivered + result.dropped != (uint64_t)frames) {
+      fprintf(stderr, "FAILED: delivered %llu and dropped %llu of %d frames\n",
+              (unsigned long long)delivered,
+              (unsigned long long)result.dropped, frames);
+      result.complete = false;
+    }
+  }
+  result.fps = frames / (Milliseconds(start) / 1000.0);
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1920;
+  int height = argc > 2 ? atoi(argv[2]) : 1080;
+  int frames = argc > 3 ? atoi(argv[3]) : 30;
+  if (width < 1 || height < 1 || frames < 1) {
+    fprintf(stderr, "usage: readback_bench [width] [height] [frames]\n");
+    return 2;
+  }
+
+  // Two frames alternated, so that consecutive reads differ
+  std::vector<std::vector<uint8_t>> pixels = {TestPattern(width, height, 0),
+                                              TestPattern(width, height, 1)};
+
+  printf("%dx%d, %d frames\n", width, height, frames);
+  printf("%-6s %5s %15s %11s %8s %8s %9s\n", "", "ring", "caller ms/frame",
+         "latency ms", "fps", "dropped", "max diff");
+  Result reference;
+  bool passed = true;
+  for (int ring_size : {0, 2, 3}) {
+    Result result = Run(ring_size, width, height, frames, pixels);
+    const char* mode = ring_size ? "async" : "sync";
+    if (!result.supported) {
+      printf("%-6s %5d %15s\n", mode, ring_size, "unsupported");
+      continue;
+    }
+    if (reference.rgba.empty()) {
+      reference = result;
+    }
+    int difference = MaxDifference(reference.rgba, result.rgba);
+    printf("%-6s %5d %15.2f %11.2f %8.1f %8llu %9d\n", mode, ring_size,
+           result.caller_ms, result.latency_ms, result.fps,
+           (unsigned long long)result.dropped, difference);
+    passed &= result.complete && CheckDifference(mode, difference, 0);
+  }
+
+  GPUPixelContext::Destroy();
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Time per frame of a filter chain fed from two application threads, with
+// tracing off and on, and the cost of recording one event. Writes the trace
+// of the traced run, which chrome://tracing and Perfetto open.
+//
+// usage: trace_bench [frames] [trace_path]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+#include "utils/trace.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+constexpr int kSize = 64;
+constexpr int kPasses = 5;
+
+// Two streams on the shared context, as a camera and a preview thread would
+double RunFrames(int frames) {
+  auto start = Clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 2; ++t) {
+    threads.emplace_back([frames] {
+      auto source = SourceRawData::Create();
+      std::shared_ptr<Source> tail = source;
+      std::vector<std::shared_ptr<Filter>> filters;
+      for (int i = 0; i < kPasses; ++i) {
+        filters.push_back(BrightnessFilter::Create());
+        tail = tail->AddSink(filters.back());
+      }
+      auto sink = SinkRawData::Create();
+      tail->AddSink(sink);
+
+      std::vector<uint8_t> pixels(kSize * kSize * 4, 128);
+      for (int i = 0; i < frames; ++i) {
+        source->ProcessData(pixels.data(), kSize, kSize, kSize * 4,
+                            GPUPIXEL_FRAME_TYPE_RGBA);
+        sink->GetRgbaBuffer();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return std::chrono::duration<double, std::micro>(Clock::now() - start)
+             .count() /
+         (frames * 2);
+}
+
+double RecordCost(int events) {
+  auto start = Clock::now();
+  for (int i = 0; i < events; ++i) {
+    TraceScope scope("event", "bench");
+  }
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+             .count() /
+         events;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 300;
+  std::string path = argc > 2 ? argv[2] : "gpupixel_trace.json";
+  if (frames < 1) {
+    frames = 1;
+  }
+
+  RunFrames(10);
+  double off_us = RunFrames(frames);
+  double off_ns = RecordCost(1000000);
+
+  GPUPixel::SetTracingEnabled(true);
+  GPUPixel::ClearTrace();
+  double on_us = RunFrames(frames);
+  double on_ns = RecordCost(1000000);
+  // The recording loop above is not worth keeping
+  GPUPixel::ClearTrace();
+  RunFrames(10);
+  GPUPixel::SetTracingEnabled(false);
+
+  printf("%d brightness passes, %dx%d input, 2 threads, %d frames each\n",
+         kPasses, kSize, kSize, frames);
+  printf("tracing off: %8.1f us/frame %8.1f ns/event\n", off_us, off_ns);
+  printf("tracing on:  %8.1f us/frame %8.1f ns/event\n", on_us, on_ns);
+  if (GPUPixel::WriteTrace(path)) {
+    printf("last 10 frames written to %s\n", path.c_str());
+  } else {
+    printf("failed to write %s\n", path.c_str());
+  }
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
@@ -0,0 +1,153 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// CPU time per frame of single filters on a tiny input, so that the cost of
+// setting up the draw dominates, the uniform / attribute location lookups that
+// reach the driver up to the first frame and on every later one, and the
+// glUniform* calls per frame made and skipped because the value is unchanged.
+// Also times a glGetUniformLocation call against a cached location.
+//
+// usage: uniform_bench [frames] [resource_dir]
+//   resource_dir holds res/, defaults to the directory above the executable
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_program.h"
+#include "gpupixel/gpupixel.h"
+#include "utils/util.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+constexpr int kSize = 16;
+
+struct Kind {
+  const char* name;
+  // Inputs the filter draws from, all fed from the same source
+  int inputs;
+  std::function<std::shared_ptr<Filter>()> create;
+};
+
+uint64_t LocationLookups() {
+  return GPUPixelGLProgram::GetCacheStats().location_lookups;
+}
+
+uint64_t UniformUploads() {
+  return GPUPixelGLProgram::GetCacheStats().uniform_uploads;
+}
+
+uint64_t UniformUploadsSkipped() {
+  return GPUPixelGLProgram::GetCacheStats().uniform_uploads_skipped;
+}
+
+void Run(const Kind& kind, int frames, const std::vector<uint8_t>& pixels) {
+  // Lookups made while creating the filter and drawing its first frame
+  uint64_t lookups = LocationLookups();
+  auto source = SourceRawData::Create();
+  auto filter = kind.create();
+  // A source feeds a sink through one input only, so further inputs come
+  // through pass-through filters
+  std::vector<std::shared_ptr<Filter>> copies;
+  source->AddSink(filter, 0);
+  for (int i = 1; i < kind.inputs; ++i) {
+    copies.push_back(
+        Filter::CreateWithFragmentShaderString(kDefaultFragmentShader));
+    source->AddSink(copies.back());
+    copies.back()->AddSink(filter, i);
+  }
+  source->ProcessData(pixels.data(), kSize, kSize, kSize * 4,
+                      GPUPIXEL_FRAME_TYPE_RGBA);
+  uint64_t setup_lookups = LocationLookups() - lookups;
+
+  lookups = LocationLookups();
+  uint64_t uploads = UniformUploads();
+  uint64_t skipped = UniformUploadsSkipped();
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    source->ProcessData(pixels.data(), kSize, kSize, kSize * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+  }
+  double us =
+      std::chrono::duration<double, std::micro>(Clock::now() - start).count() /
+      frames;
+  double next_lookups = (double)(LocationLookups() - lookups) / frames;
+  double next_uploads = (double)(UniformUploads() - uploads) / frames;
+  double next_skipped = (double)(UniformUploadsSkipped() - skipped) / frames;
+
+  printf("%-16s %10.1f %14llu %14.2f %14.2f %14.2f\n", kind.name, us,
+         (unsigned long long)setup_lookups, next_lookups, next_uploads,
+         next_skipped);
+}
+
+// Cost of one location lookup through the driver and through the cache
+void RunLookup(int calls) {
+  auto filter = BrightnessFilter::Create();
+  GPUPixelGLProgram* program = filter->GetGlProgram();
+  GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    volatile GLint sink = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < calls; ++i) {
+      sink = glGetUniformLocation(program->GetProgram(), "brightness_factor");
+    }
+    double driver_ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start)
+            .count() /
+        calls;
+
+    start = Clock::now();
+    for (int i = 0; i < calls; ++i) {
+      sink = program->GetUniformLocation("brightness_factor");
+    }
+    double cached_ns =
+        std::chrono::duration<double, std::nano>(Clock::now() - start)
+            .count() /
+        calls;
+    (void)sink;
+    printf("uniform location: driver %.1f ns, cached %.1f ns\n", driver_ns,
+           cached_ns);
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 1000;
+  if (frames < 1) {
+    frames = 1;
+  }
+  Util::SetResourcePath(argc > 2 ? fs::path(argv[2])
+                                 : fs::absolute(argv[0])
+                                       .parent_path()
+                                       .parent_path());
+
+  std::vector<uint8_t> pixels(kSize * kSize * 4, 128);
+
+  const Kind kinds[] = {
+      {"brightness", 1, [] { return BrightnessFilter::Create(); }},
+      {"sobel edge", 1, [] { return SobelEdgeDetectionFilter::Create(); }},
+      {"beauty face unit", 3, [] { return BeautyFaceUnitFilter::Create(); }},
+  };
+
+  printf("%dx%d input, %d frames\n", kSize, kSize, frames);
+  printf("%-16s %10s %14s %14s %14s %14s\n", "", "us/frame", "setup lookups",
+         "lookups/frame", "uploads/frame", "skipped/frame");
+  for (const auto& kind : kinds) {
+    Run(kind, frames, pixels);
+  }
+  RunLookup(frames * 10);
+
+  GPUPixelContext::Destroy();
+  return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Upload throughput of SourceRawData for RGBA and BGRA frames, with tightly
+// packed rows and with rows padded as camera and decoder buffers often are.
+// Prints the time per frame, the frame bytes uploaded per second and the
+// largest difference to the tightly packed RGBA frame, which padding and the
+// BGRA swizzle must not change; exits with 1 if they do.
+//
+// usage: upload_bench [width] [height] [frames]
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+// Rows padded to a multiple of this many bytes, plus one more block
+constexpr int kPaddingAlignment = 256;
+
+struct Result {
+  double ms;
+  std::vector<uint8_t> rgba;
+};
+
+Result Run(GPUPIXEL_FRAME_TYPE type,
+           int width,
+           int height,
+           int stride,
+           int frames,
+           const std::vector<uint8_t>& pixels) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  auto source = SourceRawData::Create();
+  auto render = [&] {
+    source->ProcessData(pixels.data(), width, height, stride, type);
+    context->SyncRunWithContext([] { glFinish(); });
+  };
+  render();
+
+  Result result;
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    render();
+  }
+  result.ms = Milliseconds(start) / frames;
+
+  // Read back outside the timed frames
+  auto sink = SinkRawData::Create();
+  source->AddSink(sink);
+  render();
+  const uint8_t* output = sink->GetRgbaBuffer();
+  result.rgba.assign(output, output + (size_t)width * height * 4);
+  return result;
+}
+
+// Copies tightly packed RGBA into rows `stride` bytes apart, swapping red and
+// blue for BGRA
+std::vector<uint8_t> Layout(const std::vector<uint8_t>& rgba,
+                            int width,
+                            int height,
+                            int stride,
+                            bool bgra) {
+  std::vector<uint8_t> pixels((size_t)stride * height, 0xcd);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const uint8_t* in = &rgba[((size_t)y * width + x) * 4];
+      uint8_t* out = &pixels[(size_t)y * stride + x * 4];
+      out[0] = bgra ? in[2] : in[0];
+      out[1] = in[1];
+      out[2] = bgra ? in[0] : in[2];
+      out[3] = in[3];
+    }
+  }
+  return pixels;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1920;
+  int height = argc > 2 ? atoi(argv[2]) : 1080;
+  int frames = argc > 3 ? atoi(argv[3]) : 30;
+  if (width < 1 || height < 1 || frames < 1) {
+    fprintf(stderr, "usage: upload_bench [width] [height] [frames]\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> rgba = TestPattern(width, height);
+
+  int tight = width * 4;
+  int padded =
+      (tight + kPaddingAlignment - 1) / kPaddingAlignment * kPaddingAlignment +
+      kPaddingAlignment;
+  double frame_mib = (double)tight * height / (1024.0 * 1024.0);
+
+  printf("%dx%d, %d frames, padded stride %d bytes\n", width, height, frames,
+         padded);
+  printf("%-14s %10s %10s %9s\n", "", "ms/frame", "MiB/s", "max diff");
+  Result reference;
+  bool passed = true;
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    for (bool bgra : {false, true}) {
+      for (int stride : {tight, padded}) {
+        GPUPIXEL_FRAME_TYPE type =
+            bgra ? GPUPIXEL_FRAME_TYPE_BGRA : GPUPIXEL_FRAME_TYPE_RGBA;
+        Result result = Run(type, width, height, stride, frames,
+                            Layout(rgba, width, height, stride, bgra));
+        if (reference.rgba.empty()) {
+          reference = result;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "%s %s", bgra ? "bgra" : "rgba",
+                 stride == tight ? "tight" : "padded");
+        int difference = MaxDifference(reference.rgba, result.rgba);
+        printf("%-14s %10.2f %10.1f %9d\n", name, result.ms,
+               frame_mib * 1000.0 / result.ms, difference);
+        passed &= CheckDifference(name, difference, 0);
+      }
+    }
+  }
+
+  GPUPixelContext::Destroy();
+  return passed ? 0 : 1;
+}
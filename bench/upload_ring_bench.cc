@@ -0,0 +1,137 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Streams RGBA frames through SourceRawData and a filter, uploading from the
+// caller's memory and through upload rings of 2 and 3 pixel buffers, at 1080p
+// and 4K. Prints how long ProcessData holds the producer (average and worst),
+// frames per second until the last frame is rendered, and the largest
+// difference between the last frame rendered with and without the ring, which
+// must be none.
+// With an interval the producer delivers a frame every `interval_ms` like a
+// camera would, otherwise as fast as frames are taken.
+//
+// usage: upload_ring_bench [frames] [interval_ms]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+struct Result {
+  bool supported = true;
+  double average_ms = 0;
+  double worst_ms = 0;
+  double fps = 0;
+  std::vector<uint8_t> rgba;
+};
+
+Result Run(int ring_size,
+           int width,
+           int height,
+           int frames,
+           int interval_ms,
+           const std::vector<std::vector<uint8_t>>& pixels) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  auto source = SourceRawData::Create();
+  auto filter = BrightnessFilter::Create();
+  filter->setBrightness(0.1f);
+  source->AddSink(filter);
+
+  Result result;
+  if (!source->SetUploadRingSize(ring_size)) {
+    result.supported = false;
+    return result;
+  }
+  auto finish = [&] { context->SyncRunWithContext([] { glFinish(); }); };
+  for (int i = 0; i < ring_size + 1; ++i) {
+    source->ProcessData(pixels[0].data(), width, height, width * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+  }
+  finish();
+
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    std::this_thread::sleep_until(start +
+                                  std::chrono::milliseconds(interval_ms * i));
+    auto call = Clock::now();
+    source->ProcessData(pixels[i % pixels.size()].data(), width, height,
+                        width * 4, GPUPIXEL_FRAME_TYPE_RGBA);
+    double ms = Milliseconds(call);
+    result.average_ms += ms / frames;
+    result.worst_ms = std::max(result.worst_ms, ms);
+  }
+  finish();
+  result.fps =
+      frames / std::chrono::duration<double>(Clock::now() - start).count();
+
+  // Read back outside the timed frames
+  auto sink = SinkRawData::Create();
+  filter->AddSink(sink);
+  source->ProcessData(pixels[0].data(), width, height, width * 4,
+                      GPUPIXEL_FRAME_TYPE_RGBA);
+  finish();
+  const uint8_t* output = sink->GetRgbaBuffer();
+  result.rgba.assign(output, output + (size_t)width * height * 4);
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int frames = argc > 1 ? atoi(argv[1]) : 30;
+  int interval_ms = argc > 2 ? atoi(argv[2]) : 0;
+  if (frames < 1 || interval_ms < 0) {
+    fprintf(stderr, "usage: upload_ring_bench [frames] [interval_ms]\n");
+    return 2;
+  }
+
+  printf("%d frames, %d ms apart\n", frames, interval_ms);
+  printf("%-10s %5s %13s %11s %8s %9s\n", "", "ring", "producer ms", "worst ms",
+         "fps", "max diff");
+  const int sizes[][2] = {{1920, 1080}, {3840, 2160}};
+  bool passed = true;
+  for (const auto& size : sizes) {
+    int width = size[0];
+    int height = size[1];
+    // Two frames alternated, so that no upload can be skipped as unchanged
+    std::vector<std::vector<uint8_t>> pixels = {
+        TestPattern(width, height, 0), TestPattern(width, height, 1)};
+
+    char name[32];
+    snprintf(name, sizeof(name), "%dx%d", width, height);
+    Result reference;
+    for (int ring_size : {0, 2, 3}) {
+      Result result =
+          Run(ring_size, width, height, frames, interval_ms, pixels);
+      if (!result.supported) {
+        printf("%-10s %5d %13s\n", name, ring_size, "unsupported");
+        continue;
+      }
+      if (reference.rgba.empty()) {
+        reference = result;
+      }
+      int difference = MaxDifference(reference.rgba, result.rgba);
+      printf("%-10s %5d %13.2f %11.2f %8.1f %9d\n", name, ring_size,
+             result.average_ms, result.worst_ms, result.fps, difference);
+      passed &= CheckDifference(name, difference, 0);
+    }
+  }
+
+  GPUPixelContext::Destroy();
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Time per frame of getting a frame out of SinkRawData as YUV 4:2:0: read
+// back as RGBA and converted with libyuv, as GetI420Buffer used to, or
+// converted on the GPU by GetI420Buffer and GetNV12Buffer so that only the
+// planes are read back. Also prints the bytes each reads back and the
+// largest difference to the libyuv conversion, which must be within
+// kTolerance.
+//
+// usage: yuv_readback_bench [width] [height] [frames]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+#include "libyuv.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+// The GPU converts in floating point, libyuv in fixed point, so they may
+// round differently
+constexpr int kTolerance = 1;
+
+enum Mode { kCpuI420, kGpuI420, kGpuNV12 };
+
+struct Result {
+  double ms;
+  std::vector<uint8_t> yuv;
+};
+
+Result Run(Mode mode,
+           int width,
+           int height,
+           int frames,
+           const std::vector<uint8_t>& pixels) {
+  auto source = SourceRawData::Create();
+  auto sink = SinkRawData::Create();
+  source->AddSink(sink);
+  size_t size = (size_t)width * height * 3 / 2;
+  std::vector<uint8_t> cpu_yuv(size);
+
+  auto read = [&]() -> const uint8_t* {
+    if (mode == kGpuI420) {
+      return sink->GetI420Buffer();
+    }
+    if (mode == kGpuNV12) {
+      return sink->GetNV12Buffer();
+    }
+    const uint8_t* rgba = sink->GetRgbaBuffer();
+    uint8_t* y = cpu_yuv.data();
+    uint8_t* u = y + width * height;
+    uint8_t* v = u + width * height / 4;
+    libyuv::ABGRToI420(rgba, width * 4, y, width, u, width / 2, v, width / 2,
+                       width, height);
+    return cpu_yuv.data();
+  };
+  source->ProcessData(pixels.data(), width, height, width * 4,
+                      GPUPIXEL_FRAME_TYPE_RGBA);
+  read();
+
+  Result result;
+  double total_ms = 0;
+  for (int i = 0; i < frames; ++i) {
+    // The frame is rendered outside the timed readback
+    source->ProcessData(pixels.data(), width, height, width * 4,
+                        GPUPIXEL_FRAME_TYPE_RGBA);
+    GPUPixelContext::GetInstance()->SyncRunWithContext([] { glFinish(); });
+    auto start = Clock::now();
+    const uint8_t* yuv = read();
+    total_ms += Milliseconds(start);
+    if (i == frames - 1) {
+      result.yuv.assign(yuv, yuv + size);
+    }
+  }
+  result.ms = total_ms / frames;
+  return result;
+}
+
+// NV12 chroma laid out as I420's, to compare the two
+std::vector<uint8_t> NV12ToI420Layout(const std::vector<uint8_t>& nv12,
+                                      int width,
+                                      int height) {
+  std::vector<uint8_t> i420(nv12.size());
+  size_t luma_size = (size_t)width * height;
+  size_t chroma_size = luma_size / 4;
+  std::copy(nv12.begin(), nv12.begin() + luma_size, i420.begin());
+  for (size_t i = 0; i < chroma_size; ++i) {
+    i420[luma_size + i] = nv12[luma_size + i * 2];
+    i420[luma_size + chroma_size + i] = nv12[luma_size + i * 2 + 1];
+  }
+  return i420;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1920;
+  int height = argc > 2 ? atoi(argv[2]) : 1080;
+  int frames = argc > 3 ? atoi(argv[3]) : 30;
+  if (width < 8 || height < 4 || width % 8 || height % 4 || frames < 1) {
+    fprintf(stderr,
+            "usage: yuv_readback_bench [width] [height] [frames]\n"
+            "width a multiple of 8, height of 4\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> pixels = TestPattern(width, height);
+
+  printf("%dx%d, %d frames\n", width, height, frames);
+  printf("%-22s %10s %14s %9s\n", "", "ms/frame", "read back MiB",
+         "max diff");
+  double rgba_mib = (double)width * height * 4 / (1024.0 * 1024.0);
+  double yuv_mib = (double)width * height * 1.5 / (1024.0 * 1024.0);
+  bool passed = true;
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    Result cpu = Run(kCpuI420, width, height, frames, pixels);
+    Result gpu_i420 = Run(kGpuI420, width, height, frames, pixels);
+    Result gpu_nv12 = Run(kGpuNV12, width, height, frames, pixels);
+    printf("%-22s %10.2f %14.2f %9s\n", "rgba + libyuv i420", cpu.ms,
+           rgba_mib, "-");
+    int i420_difference = MaxDifference(cpu.yuv, gpu_i420.yuv);
+    int nv12_difference = MaxDifference(
+        cpu.yuv, NV12ToI420Layout(gpu_nv12.yuv, width, height));
+    printf("%-22s %10.2f %14.2f %9d\n", "gpu i420", gpu_i420.ms, yuv_mib,
+           i420_difference);
+    printf("%-22s %10.2f %14.2f %9d\n", "gpu nv12", gpu_nv12.ms, yuv_mib,
+           nv12_difference);
+    passed &= CheckDifference("i420", i420_difference, kTolerance);
+    passed &= CheckDifference("nv12", nv12_difference, kTolerance);
+  }
+
+  GPUPixelContext::Destroy();
+  return passed ? 0 : 1;
+}
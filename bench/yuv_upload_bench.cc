@@ -0,0 +1,167 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+// Time per frame of getting a YUV 4:2:0 frame into a source framebuffer:
+// converted to RGBA on the CPU (BT.601 limited range, fixed point as libyuv
+// does) and uploaded, or uploaded as I420 and NV12 planes and converted by
+// the source on the GPU. Also prints the bytes each uploads and the largest
+// difference between the RGBA the CPU and the GPU conversion give, which must
+// be within kTolerance.
+//
+// usage: yuv_upload_bench [width] [height] [frames]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "bench_util.h"
+#include "core/gpupixel_context.h"
+#include "gpupixel/gpupixel.h"
+
+using namespace gpupixel;
+using namespace gpupixel::bench;
+
+namespace {
+
+// Both take each chroma sample for its 2x2 block of Y, but the GPU converts
+// in floating point and the CPU in fixed point, so they may round differently
+constexpr int kTolerance = 1;
+
+uint8_t Clamp(int value) {
+  return (uint8_t)std::min(255, std::max(0, value));
+}
+
+void I420ToRGBA(const uint8_t* i420, int width, int height, uint8_t* rgba) {
+  const uint8_t* y_plane = i420;
+  const uint8_t* u_plane = y_plane + width * height;
+  const uint8_t* v_plane = u_plane + (width / 2) * (height / 2);
+  for (int y = 0; y < height; ++y) {
+    const uint8_t* y_row = y_plane + y * width;
+    const uint8_t* u_row = u_plane + (y / 2) * (width / 2);
+    const uint8_t* v_row = v_plane + (y / 2) * (width / 2);
+    uint8_t* out = rgba + (size_t)y * width * 4;
+    for (int x = 0; x < width; ++x) {
+      int c = 298 * (y_row[x] - 16) + 128;
+      int d = u_row[x / 2] - 128;
+      int e = v_row[x / 2] - 128;
+      out[0] = Clamp((c + 409 * e) >> 8);
+      out[1] = Clamp((c - 100 * d - 208 * e) >> 8);
+      out[2] = Clamp((c + 516 * d) >> 8);
+      out[3] = 255;
+      out += 4;
+    }
+  }
+}
+
+struct Result {
+  double ms;
+  std::vector<uint8_t> rgba;
+};
+
+Result Run(GPUPIXEL_FRAME_TYPE type,
+           bool cpu_convert,
+           int width,
+           int height,
+           int frames,
+           const std::vector<uint8_t>& yuv) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  auto source = SourceRawData::Create();
+  std::vector<uint8_t> rgba((size_t)width * height * 4);
+
+  auto render = [&] {
+    if (cpu_convert) {
+      I420ToRGBA(yuv.data(), width, height, rgba.data());
+      source->ProcessData(rgba.data(), width, height, width * 4,
+                          GPUPIXEL_FRAME_TYPE_RGBA);
+    } else {
+      source->ProcessData(yuv.data(), width, height, width, type);
+    }
+    context->SyncRunWithContext([] { glFinish(); });
+  };
+  render();
+
+  Result result;
+  auto start = Clock::now();
+  for (int i = 0; i < frames; ++i) {
+    render();
+  }
+  result.ms = Milliseconds(start) / frames;
+
+  // Read back outside the timed frames
+  auto sink = SinkRawData::Create();
+  source->AddSink(sink);
+  render();
+  const uint8_t* output = sink->GetRgbaBuffer();
+  result.rgba.assign(output, output + (size_t)width * height * 4);
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int width = argc > 1 ? atoi(argv[1]) : 1920;
+  int height = argc > 2 ? atoi(argv[2]) : 1080;
+  int frames = argc > 3 ? atoi(argv[3]) : 30;
+  if (width < 2 || height < 2 || width % 2 || height % 2 || frames < 1) {
+    fprintf(stderr, "usage: yuv_upload_bench [width] [height] [frames]\n");
+    return 2;
+  }
+
+  // Gradients in I420, and the same frame with the chroma planes interleaved
+  // as NV12
+  int chroma_width = width / 2;
+  int chroma_height = height / 2;
+  size_t luma_size = (size_t)width * height;
+  size_t chroma_size = (size_t)chroma_width * chroma_height;
+  std::vector<uint8_t> i420(luma_size + chroma_size * 2);
+  std::vector<uint8_t> nv12(i420.size());
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      i420[(size_t)y * width + x] = (uint8_t)(16 + (x * 219) / width);
+    }
+  }
+  for (int y = 0; y < chroma_height; ++y) {
+    for (int x = 0; x < chroma_width; ++x) {
+      size_t i = (size_t)y * chroma_width + x;
+      uint8_t u = (uint8_t)(16 + (y * 224) / chroma_height);
+      uint8_t v = (uint8_t)(16 + (x * 224) / chroma_width);
+      i420[luma_size + i] = u;
+      i420[luma_size + chroma_size + i] = v;
+      nv12[luma_size + i * 2] = u;
+      nv12[luma_size + i * 2 + 1] = v;
+    }
+  }
+  std::copy(i420.begin(), i420.begin() + luma_size, nv12.begin());
+
+  printf("%dx%d, %d frames\n", width, height, frames);
+  printf("%-22s %10s %16s %9s\n", "", "ms/frame", "uploaded MiB", "max diff");
+  double rgba_mib = luma_size * 4 / (1024.0 * 1024.0);
+  double yuv_mib = i420.size() / (1024.0 * 1024.0);
+  bool passed = true;
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    Result cpu =
+        Run(GPUPIXEL_FRAME_TYPE_RGBA, true, width, height, frames, i420);
+    Result gpu_i420 =
+        Run(GPUPIXEL_FRAME_TYPE_I420, false, width, height, frames, i420);
+    Result gpu_nv12 =
+        Run(GPUPIXEL_FRAME_TYPE_NV12, false, width, height, frames, nv12);
+    printf("%-22s %10.2f %16.2f %9s\n", "cpu convert + rgba", cpu.ms, rgba_mib,
+           "-");
+    int i420_difference = MaxDifference(cpu.rgba, gpu_i420.rgba);
+    int nv12_difference = MaxDifference(cpu.rgba, gpu_nv12.rgba);
+    printf("%-22s %10.2f %16.2f %9d\n", "i420 + gpu convert", gpu_i420.ms,
+           yuv_mib, i420_difference);
+    printf("%-22s %10.2f %16.2f %9d\n", "nv12 + gpu convert", gpu_nv12.ms,
+           yuv_mib, nv12_difference);
+    passed &= CheckDifference("i420", i420_difference, kTolerance);
+    passed &= CheckDifference("nv12", nv12_difference, kTolerance);
+  }
+
+  GPUPixelContext::Destroy();
+  return passed ? 0 : 1;
+}
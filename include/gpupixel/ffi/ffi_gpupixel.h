@@ -6,6 +6,32 @@
 extern "C" {
 #endif
 
+// Framebuffer cache memory for one GL internal format / pixel type pair. Live
+// framebuffers are in use by a pipeline, pooled ones are idle and reclaimable.
+typedef struct {
+  uint32_t internal_format;
+  uint32_t type;
+  uint64_t live_bytes;
+  uint64_t pooled_bytes;
+  uint32_t live_count;
+  uint32_t pooled_count;
+} GPUPixelFramebufferUsage;
+
+// Timings of one filter or source over its most recent frames, in
+// milliseconds; the gpu fields are only valid when gpu_samples > 0
+typedef struct {
+  uint64_t node_id;
+  char name[64];
+  int32_t cpu_samples;
+  double cpu_min_ms;
+  double cpu_avg_ms;
+  double cpu_p99_ms;
+  int32_t gpu_samples;
+  double gpu_min_ms;
+  double gpu_avg_ms;
+  double gpu_p99_ms;
+} GPUPixelFilterProfile;
+
 // Convert YUV420 to RGBA, output to rgba_out, ensure rgba_out has enough space (width*height*4 bytes)
 void gpupixel_yuv420_to_rgba(const uint8_t* y, const uint8_t* u, const uint8_t* v,
 							 int width, int height,
@@ -22,6 +48,65 @@ void gpupixel_flip_rgba(uint8_t* rgba_in, int width, int height, int direction);
 
 void gpupixel_set_resource_path(const char* path);
 
+// Directory for caching linked shader programs across runs; NULL or "" turns
+// the cache off (the default)
+void gpupixel_set_program_cache_path(const char* path);
+
+// GL error reporting: mode is a GPUPIXEL_GL_ERROR_CHECK value, sample_interval
+// the frames per check in the sampled mode
+void gpupixel_set_gl_error_check(int mode, int sample_interval);
+
+// Create an independent context with its own GL thread and framebuffer pool,
+// sharing GL objects with share_context unless it is 0
+intptr_t gpupixel_context_create(intptr_t share_context);
+
+void gpupixel_context_destroy(intptr_t context);
+
+// Objects created on the calling thread afterwards are bound to context; 0
+// restores the default context
+void gpupixel_context_set_thread_context(intptr_t context);
+
+// The framebuffer cache functions below take a context handle, 0 selects the
+// default context
+
+// Soft limit on framebuffer cache bytes, 0 means unlimited. Idle framebuffers
+// are evicted least recently used first; framebuffers in use are kept.
+void gpupixel_framebuffer_cache_set_budget(intptr_t context, uint64_t bytes);
+
+// Frees idle framebuffers until the cache holds at most target_bytes and
+// returns the number of bytes freed. 0 frees every idle framebuffer.
+uint64_t gpupixel_framebuffer_cache_trim(intptr_t context,
+                                         uint64_t target_bytes);
+
+// Writes up to capacity per-format entries to usage and returns the total
+// number of formats, which may exceed capacity
+int gpupixel_framebuffer_cache_get_usage(intptr_t context,
+                                         GPUPixelFramebufferUsage* usage,
+                                         int capacity);
+
+// Times every filter and source pass on the CPU and, where the driver has
+// timer queries, the GPU; off by default
+void gpupixel_set_profiling_enabled(int enabled);
+
+// Writes up to capacity entries of the context's profile to profile and
+// returns the total number of entries, which may exceed capacity
+int gpupixel_get_profile(intptr_t context,
+                         GPUPixelFilterProfile* profile,
+                         int capacity);
+
+// Discards the timings collected on the context
+void gpupixel_reset_profile(intptr_t context);
+
+// Records filter passes, uploads, readbacks and context waits of all threads;
+// off by default
+void gpupixel_set_tracing_enabled(int enabled);
+
+// Writes the recorded events as Chrome trace-event JSON; returns 0 on failure
+int gpupixel_write_trace(const char* path);
+
+// Discards the recorded events
+void gpupixel_clear_trace(void);
+
 #ifdef __cplusplus
 }
 #endif
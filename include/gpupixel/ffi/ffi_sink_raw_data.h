@@ -27,6 +27,9 @@ int gpupixel_sink_raw_data_get_rgba_buffer(intptr_t sink_ptr, uint8_t** out_buff
 // Get I420 buffer data - returns buffer size, data output via out_buffer, caller is responsible for releasing
 int gpupixel_sink_raw_data_get_i420_buffer(intptr_t sink_ptr, uint8_t** out_buffer);
 
+// Get NV12 buffer data - returns buffer size, data output via out_buffer, caller is responsible for releasing
+int gpupixel_sink_raw_data_get_nv12_buffer(intptr_t sink_ptr, uint8_t** out_buffer);
+
 // Release buffer data
 void gpupixel_sink_raw_data_free_buffer(uint8_t* buffer);
 
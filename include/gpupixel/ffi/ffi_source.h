@@ -27,6 +27,21 @@ int gpupixel_source_get_rotated_framebuffer_width(intptr_t source_id, int is_sou
 // Get rotated framebuffer height
 int gpupixel_source_get_rotated_framebuffer_height(intptr_t source_id, int is_source_filter);
 
+// Get node id, which matches node_id in GPUPixelFilterProfile
+uint64_t gpupixel_source_get_node_id(intptr_t source_id, int is_source_filter);
+
+// Create a Pipeline rendering the graph below Source
+intptr_t gpupixel_pipeline_create(intptr_t source_id, int is_source_filter);
+
+// Destroy Pipeline, the graph renders recursively again
+void gpupixel_pipeline_destroy(intptr_t pipeline_id);
+
+// Compile the graph into a plan - returns 1 on success
+int gpupixel_pipeline_compile(intptr_t pipeline_id);
+
+// Get number of passes in the plan
+int gpupixel_pipeline_get_pass_count(intptr_t pipeline_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -21,6 +21,14 @@ void gpupixel_source_raw_data_process(intptr_t raw_ptr, const uint8_t* data, int
 // Set rotation mode
 void gpupixel_source_raw_data_set_rotation(intptr_t raw_ptr, int rotation);
 
+// Set the matrix (GPUPIXEL_YUV_MATRIX) and range (GPUPIXEL_YUV_RANGE) of YUV
+// frames
+void gpupixel_source_raw_data_set_yuv_color_space(intptr_t raw_ptr, int matrix, int range);
+
+// Stream frames through a ring of pixel buffers, 0 to turn it off. Returns 0
+// when the GL context has no pixel buffers.
+int gpupixel_source_raw_data_set_upload_ring_size(intptr_t raw_ptr, int buffers);
+
 #ifdef __cplusplus
 }
 #endif
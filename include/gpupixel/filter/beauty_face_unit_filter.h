@@ -9,6 +9,7 @@
 
 #include "gpupixel/filter/filter.h"
 #include "gpupixel/gpupixel_define.h"
+#include "gpupixel/utils/uniform_handle.h"
 
 namespace gpupixel {
 class SourceImage;
@@ -36,6 +37,19 @@ class GPUPIXEL_API BeautyFaceUnitFilter : public Filter {
   float sharpen_factor_ = 0.0;
   float blur_alpha_ = 0.0;
   float white_balance_ = 0.0;
+
+  // Resolved in Init
+  UniformHandle input_texture_uniforms_[3];
+  UniformHandle look_up_gray_uniform_;
+  UniformHandle look_up_origin_uniform_;
+  UniformHandle look_up_skin_uniform_;
+  UniformHandle look_up_custom_uniform_;
+  UniformHandle width_offset_uniform_;
+  UniformHandle height_offset_uniform_;
+  UniformHandle sharpen_uniform_;
+  UniformHandle blur_alpha_uniform_;
+  UniformHandle whiten_uniform_;
+  uint32_t tex_coord_attribute_ = 0;
 };
 
 }  // namespace gpupixel
@@ -17,6 +17,8 @@ class GPUPIXEL_API ColorInvertFilter : public Filter {
   bool Init();
 
   virtual bool DoRender(bool updateSinks = true) override;
+  virtual bool GetColorFunction(std::string& glsl,
+                                std::vector<std::string>& names) const override;
 
  protected:
   ColorInvertFilter() {};
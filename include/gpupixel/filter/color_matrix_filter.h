@@ -17,9 +17,21 @@ class GPUPIXEL_API ColorMatrixFilter : public Filter {
   bool Init();
 
   virtual bool DoRender(bool updateSinks = true) override;
+  virtual bool GetColorFunction(std::string& glsl,
+                                std::vector<std::string>& names) const override;
+  virtual std::vector<std::string> GetColorUniformNames() const override;
+  virtual void SetColorUniforms(
+      GPUPixelGLProgram* program,
+      const std::vector<UniformHandle>& uniforms) override;
 
-  void setIntensity(float intensity) { intensity_factor_ = intensity; }
-  void setColorMatrix(Matrix4 color_matrix) { color_matrix_ = color_matrix; }
+  void setIntensity(float intensity) {
+    intensity_factor_ = intensity;
+    OnColorChanged();
+  }
+  void setColorMatrix(Matrix4 color_matrix) {
+    color_matrix_ = color_matrix;
+    OnColorChanged();
+  }
 
  protected:
   ColorMatrixFilter();
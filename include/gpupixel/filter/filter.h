@@ -11,6 +11,7 @@
 #include "gpupixel/sink/sink.h"
 #include "gpupixel/source/source.h"
 #include "gpupixel/utils/math_toolbox.h"
+#include "gpupixel/utils/uniform_handle.h"
 
 #include <string>
 #include <vector>
@@ -48,6 +49,9 @@ class GPUPIXEL_API Filter : public Source, public Sink {
 
   static std::shared_ptr<Filter> Create(const std::string& filter_class_name);
 
+  // Class names Create accepts
+  static std::vector<std::string> GetFilterClassNames();
+
   static std::shared_ptr<Filter> CreateWithShaderString(
       const std::string& vertex_shader_source,
       const std::string& fragment_shader_source);
@@ -72,9 +76,38 @@ class GPUPIXEL_API Filter : public Source, public Sink {
   virtual void Render() override;
 
   virtual bool DoRender(bool update_sinks = true) override;
+  virtual void DoUpdateSinks() override;
 
   GPUPixelGLProgram* GetGlProgram() const { return filter_program_; };
 
+  // Point-wise color filters give the GLSL of their per-pixel work: uniform
+  // and constant declarations and `vec4 Apply(vec4 color)`, with the names
+  // declared outside Apply in `names`. Runs of such filters are fused into one
+  // pass by Pipeline. False for other filters.
+  virtual bool GetColorFunction(std::string& glsl,
+                                std::vector<std::string>& names) const {
+    return false;
+  }
+
+  // Uniforms the color function reads, in the order SetColorUniforms takes
+  // their handles
+  virtual std::vector<std::string> GetColorUniformNames() const { return {}; }
+
+  // Sets the uniforms the color function reads through their handles in the
+  // program drawing it, resolved once by ResolveColorUniforms
+  virtual void SetColorUniforms(GPUPixelGLProgram* program,
+                                const std::vector<UniformHandle>& uniforms) {}
+
+  // Handles of GetColorUniformNames in `program`, each name preceded by
+  // `prefix`
+  std::vector<UniformHandle> ResolveColorUniforms(
+      GPUPixelGLProgram* program,
+      const std::string& prefix) const;
+
+  // Changes whenever a setting the color function reads does, so that results
+  // baked from it can tell when they are stale
+  uint64_t GetColorVersion() const { return color_version_; }
+
   // property setters & getters
   bool RegisterProperty(const std::string& name,
                         int default_value,
@@ -124,6 +157,8 @@ class GPUPIXEL_API Filter : public Source, public Sink {
   GPUPixelGLProgram* filter_program_;
   uint32_t filter_position_attribute_;
   std::string filter_class_name_;
+  // Handles of GetColorUniformNames in filter_program_, for color filters
+  std::vector<UniformHandle> color_uniforms_;
   struct {
     float r;
     float g;
@@ -135,6 +170,16 @@ class GPUPIXEL_API Filter : public Source, public Sink {
 
   std::string GetVertexShaderString(int input_number) const;
 
+  // Called by the setters of color filters
+  void OnColorChanged() { ++color_version_; }
+
+  // Fragment shader applying a color function to the input
+  static std::string GetColorFunctionShaderString(
+      const std::string& color_function);
+
+  // Declarations every color function shader starts with
+  static std::string GetColorFunctionShaderHeader();
+
   const float* GetTextureCoordinate(const RotationMode& rotation_mode) const;
 
   // properties
@@ -172,6 +217,8 @@ class GPUPIXEL_API Filter : public Source, public Sink {
  private:
   static std::map<std::string, std::function<std::shared_ptr<Filter>()>>
       filter_factories_;
+
+  uint64_t color_version_;
 };
 
 }  // namespace gpupixel
@@ -34,8 +34,11 @@ class GPUPIXEL_API FilterGroup : public Filter {
   // manually, as the terminal filter will be specified automatically.
   void SetTerminalFilter(std::shared_ptr<Filter> filter) {
     terminal_filter_ = filter;
+    OnGraphChanged();
   }
 
+  std::shared_ptr<Filter> GetTerminalFilter() const { return terminal_filter_; }
+
   virtual std::shared_ptr<Source> AddSink(std::shared_ptr<Sink> sink) override;
   virtual std::shared_ptr<Source> AddSink(std::shared_ptr<Sink> sink,
                                           int inputNumber) override;
@@ -0,0 +1,57 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <vector>
+#include "gpupixel/filter/filter.h"
+#include "gpupixel/gpupixel_define.h"
+#include "gpupixel/utils/uniform_handle.h"
+
+namespace gpupixel {
+class FusedColorFilter;
+
+// Applies the color transform of a chain of point-wise color filters with one
+// lookup. The chain is rendered into a 512x512 LUT laid out like the
+// lookup_*.png images, 64 levels per channel, whenever a setting of one of
+// its filters has changed; frames in between cost the same however long the
+// chain is. Only color is looked up, alpha passes through. The stage filters
+// are not rendered themselves and need not be part of any graph.
+class GPUPIXEL_API LutBakeFilter : public Filter {
+ public:
+  static std::shared_ptr<LutBakeFilter> Create(
+      const std::vector<std::shared_ptr<Filter>>& stages);
+  ~LutBakeFilter();
+  bool Init(const std::vector<std::shared_ptr<Filter>>& stages);
+  bool DoRender(bool update_sinks = true) override;
+
+  const std::vector<std::shared_ptr<Filter>>& GetStages() const {
+    return stages_;
+  }
+
+  // Times the LUT has been rendered
+  int GetBakeCount() const { return bake_count_; }
+
+ private:
+  LutBakeFilter();
+
+  bool IsStale() const;
+  void Bake();
+
+  std::vector<std::shared_ptr<Filter>> stages_;
+  // Color versions of the stages the LUT was rendered with, empty before the
+  // first bake
+  std::vector<uint64_t> baked_versions_;
+  int bake_count_;
+  // Renders the stages into lut_, reading identity_lut_
+  std::shared_ptr<FusedColorFilter> bake_filter_;
+  std::shared_ptr<GPUPixelFramebuffer> identity_lut_;
+  std::shared_ptr<GPUPixelFramebuffer> lut_;
+  UniformHandle lookup_texture_uniform_;
+};
+
+}  // namespace gpupixel
@@ -16,6 +16,12 @@ class GPUPIXEL_API WhiteBalanceFilter : public Filter {
   static std::shared_ptr<WhiteBalanceFilter> Create();
   bool Init();
   virtual bool DoRender(bool updateSinks = true) override;
+  virtual bool GetColorFunction(std::string& glsl,
+                                std::vector<std::string>& names) const override;
+  virtual std::vector<std::string> GetColorUniformNames() const override;
+  virtual void SetColorUniforms(
+      GPUPixelGLProgram* program,
+      const std::vector<UniformHandle>& uniforms) override;
 
   void setTemperature(float temperature);
   void setTint(float tint);
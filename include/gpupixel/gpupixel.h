@@ -7,15 +7,19 @@
 
 #pragma once
 
+#include <vector>
+
 // core
 #include "gpupixel/gpupixel_define.h"
 // utils
+#include "gpupixel/utils/filter_profile.h"
 #include "gpupixel/utils/math_toolbox.h"
 
 // source
 #include "gpupixel/source/source.h"
 #include "gpupixel/source/source_image.h"
 #include "gpupixel/source/source_raw_data.h"
+#include "gpupixel/source/pipeline.h"
 
 // sink
 #include "gpupixel/sink/sink.h"
@@ -62,6 +66,7 @@
 #include "gpupixel/filter/hue_filter.h"
 #include "gpupixel/filter/ios_blur_filter.h"
 #include "gpupixel/filter/luminance_range_filter.h"
+#include "gpupixel/filter/lut_bake_filter.h"
 #include "gpupixel/filter/nearby_sampling3x3_filter.h"
 #include "gpupixel/filter/non_maximum_suppression_filter.h"
 #include "gpupixel/filter/pixellation_filter.h"
@@ -90,6 +95,65 @@ class GPUPIXEL_API GPUPixel {
    * @param root Root directory path
    */
   static void SetResourcePath(const std::string& path);
+
+  /**
+   * Enable the on-disk cache of linked shader programs, which skips shader
+   * compilation on later runs with the same driver
+   * @param path Cache directory, created on demand; empty disables the cache
+   */
+  static void SetProgramCachePath(const std::string& path);
+
+  /**
+   * Select how GL errors are reported. OFF checks nothing; SAMPLED reads the
+   * GL error flags once every sample_interval frames; DEBUG reports each
+   * error as it happens through KHR_debug, or by checking after every GL call
+   * where KHR_debug is missing. Contexts switch at their next frame. The
+   * default is set with the GPUPIXEL_GL_ERROR_CHECK CMake option.
+   * @param mode Error check mode
+   * @param sample_interval Frames per check in SAMPLED mode
+   */
+  static void SetGLErrorCheck(GPUPIXEL_GL_ERROR_CHECK mode,
+                              int sample_interval = 1);
+
+  /**
+   * Time every filter and source pass on the CPU and, where the driver has
+   * timer queries, on the GPU. Off by default.
+   * @param enabled Whether passes are timed
+   */
+  static void SetProfilingEnabled(bool enabled);
+
+  /**
+   * Timings of the passes rendered on the calling thread's context, over the
+   * most recent frames of each filter or source. GPU timings arrive a few
+   * frames after the pass.
+   * @return One entry per filter or source, in the order first rendered
+   */
+  static std::vector<FilterProfile> GetProfile();
+
+  /**
+   * Discard the timings of the calling thread's context
+   */
+  static void ResetProfile();
+
+  /**
+   * Record a timeline of filter passes, uploads, readbacks and waits for
+   * context threads, for chrome://tracing or Perfetto. Each thread keeps its
+   * most recent events only. Off by default.
+   * @param enabled Whether events are recorded
+   */
+  static void SetTracingEnabled(bool enabled);
+
+  /**
+   * Write the recorded events as Chrome trace-event JSON
+   * @param path Output file
+   * @return false if the file could not be written
+   */
+  static bool WriteTrace(const std::string& path);
+
+  /**
+   * Discard the recorded events
+   */
+  static void ClearTrace();
 };
 
 }  // namespace gpupixel
@@ -77,11 +77,36 @@ namespace gpupixel {
 typedef enum GPUPIXEL_API {
   GPUPIXEL_FRAME_TYPE_RGBA,
   GPUPIXEL_FRAME_TYPE_BGRA,
+  // YUV 4:2:0, the Y plane followed by the U and V planes
+  GPUPIXEL_FRAME_TYPE_I420,
+  // YUV 4:2:0, the Y plane followed by one plane of interleaved U and V
+  GPUPIXEL_FRAME_TYPE_NV12,
+  // As NV12 with V before U
+  GPUPIXEL_FRAME_TYPE_NV21,
 } GPUPIXEL_FRAME_TYPE;
 
+// Matrix converting YUV frames to RGB
+typedef enum GPUPIXEL_API {
+  GPUPIXEL_YUV_MATRIX_BT601,
+  GPUPIXEL_YUV_MATRIX_BT709,
+} GPUPIXEL_YUV_MATRIX;
+
+// Range of YUV frames: Y in 16-235 and U, V in 16-240, or all in 0-255
+typedef enum GPUPIXEL_API {
+  GPUPIXEL_YUV_RANGE_LIMITED,
+  GPUPIXEL_YUV_RANGE_FULL,
+} GPUPIXEL_YUV_RANGE;
+
 typedef enum GPUPIXEL_API {
   GPUPIXEL_MODE_FMT_VIDEO,
   GPUPIXEL_MODE_FMT_PICTURE,
 } GPUPIXEL_MODE_FMT;
 
+// How GL errors are reported, see GPUPixel::SetGLErrorCheck
+typedef enum GPUPIXEL_API {
+  GPUPIXEL_GL_ERROR_CHECK_OFF,
+  GPUPIXEL_GL_ERROR_CHECK_SAMPLED,
+  GPUPIXEL_GL_ERROR_CHECK_DEBUG,
+} GPUPIXEL_GL_ERROR_CHECK;
+
 }  // namespace gpupixel
@@ -9,10 +9,12 @@
 #pragma once
 
 #include <stdio.h>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "gpupixel/sink/sink.h"
 
@@ -22,6 +24,7 @@
 #endif
 
 namespace gpupixel {
+class GPUPixelContext;
 class GPUPixelGLProgram;
 class GPUPIXEL_API SinkRawData : public Sink {
  public:
@@ -30,27 +33,80 @@ class GPUPIXEL_API SinkRawData : public Sink {
   void Render() override;
 
   const uint8_t* GetRgbaBuffer();
+  // The frame as YUV 4:2:0, BT.601 limited range, converted on the GPU when
+  // the width is a multiple of 8 and the height of 4 so that only the planes
+  // are read back, and on the CPU otherwise
   const uint8_t* GetI420Buffer();
+  const uint8_t* GetNV12Buffer();
   int GetWidth() const { return width_; }
   int GetHeight() const { return height_; }
 
+  // Receives a frame read back asynchronously, on the GL thread. `rgba` is
+  // laid out as GetRgbaBuffer's and only valid during the call; `frame`
+  // counts the frames the sink has rendered, from 1, and skips dropped ones.
+  using ReadbackCallback = std::function<
+      void(const uint8_t* rgba, int width, int height, uint64_t frame)>;
+  // Reads every frame the sink renders back into one of `buffers` pixel pack
+  // buffers and hands it to callback once the GPU has finished it, typically
+  // one or two frames later, so the GL thread does not wait for the GPU. When
+  // the GPU is a whole ring behind, the new frame is dropped instead, see
+  // GetDroppedReadbackFrames. nullptr turns it off, delivering the frames in
+  // flight first. Returns false when the GL context has no pixel buffers or
+  // fences (GLES 2, WebGL, Apple desktop GL).
+  bool SetAsyncReadback(ReadbackCallback callback, int buffers = 3);
+  // Delivers the frames still in flight, waiting for the GPU
+  void FlushAsyncReadback();
+  // Frames not read back because every buffer of the ring was still in
+  // flight, since the sink was created
+  uint64_t GetDroppedReadbackFrames() const { return dropped_readbacks_; }
+
  private:
   int RenderToOutput();
+
+  // A pixel pack buffer of the readback ring
+  struct ReadbackBuffer {
+    uint32_t buffer = 0;
+    size_t size = 0;
+    // GLsync signalled once the read into buffer has completed, null while
+    // the buffer is free
+    void* fence = nullptr;
+    int width = 0;
+    int height = 0;
+    uint64_t frame = 0;
+  };
+  // Reads the frame just rendered into the next buffer of the ring, or drops
+  // it while that buffer is in flight
+  void IssueReadback();
+  // Hands completed frames to the callback, oldest first, stopping at the
+  // first one still on the GPU unless wait is set
+  void DeliverReadbacks(bool wait);
+  bool DeliverReadback(ReadbackBuffer& readback, bool wait);
+  void ReleaseReadbackRing();
   bool InitWithShaderString(const std::string& vertex_shader_source,
                             const std::string& fragment_shader_source);
   void InitTextureCache(int width, int height);
   void InitFramebuffer(int width, int height);
   void InitOutputBuffer(int width, int height);
+  // Renders the frame as packed I420 or NV12 planes and reads them into
+  // output; false when the GPU cannot convert this frame
+  bool ConvertToYUV(bool nv12, uint8_t* output);
 
  private:
   SinkRawData();
   std::mutex mutex_;
+  // Context the sink was created on
+  GPUPixelContext* context_;
   GPUPixelGLProgram* shader_program_;
   uint32_t position_attribute_;
   uint32_t tex_coord_attribute_;
 
   std::shared_ptr<GPUPixelFramebuffer> framebuffer_;
 
+  // Packs YUV planes into yuv_framebuffer_, null without highp floats
+  GPUPixelGLProgram* yuv_program_ = nullptr;
+  uint32_t yuv_position_attribute_;
+  std::shared_ptr<GPUPixelFramebuffer> yuv_framebuffer_;
+
   bool is_initialized_ = false;
 
   // Image dimensions
@@ -60,6 +116,14 @@ class GPUPIXEL_API SinkRawData : public Sink {
   // Frame buffers for pixel data
   uint8_t* rgba_buffer_ = nullptr;  // RGBA buffer
   uint8_t* yuv_buffer_ = nullptr;   // YUV buffer
+  uint8_t* nv12_buffer_ = nullptr;  // NV12 buffer
+
+  uint64_t frame_count_ = 0;
+  ReadbackCallback readback_callback_;
+  std::vector<ReadbackBuffer> readback_ring_;
+  // Buffer the next frame is read into, the oldest in flight when not free
+  size_t next_readback_ = 0;
+  std::atomic<uint64_t> dropped_readbacks_{0};
 };
 
 }  // namespace gpupixel
@@ -0,0 +1,100 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "gpupixel/gpupixel_define.h"
+#include "gpupixel/sink/sink.h"
+#include "gpupixel/source/source.h"
+
+namespace gpupixel {
+class GPUPixelContext;
+
+// Renders the graph below a source from a flat list of passes instead of
+// each node recursing into its sinks. Compile walks the graph once, orders
+// the nodes so that every pass comes after the passes it reads from and
+// resolves where each pass hands its output; a frame is then one loop over
+// that list. Filter groups are single passes, which render their own filters
+// as before.
+//
+// Runs of point-wise color filters, each feeding only the next, are fused
+// into one pass unless fusion is turned off.
+//
+// A node belongs to at most one pipeline. Nodes of the pipeline that are fed
+// from outside it must have their input before the source renders. A graph
+// changed after Compile is compiled again when the source next renders.
+class GPUPIXEL_API Pipeline {
+ public:
+  static std::shared_ptr<Pipeline> Create(std::shared_ptr<Source> source);
+
+  ~Pipeline();
+
+  // Builds the plan; false, leaving the graph to render recursively, if it
+  // has a cycle or shares nodes with another pipeline
+  bool Compile();
+
+  bool IsCompiled() const { return !passes_.empty(); }
+
+  // Whether Compile fuses color filters; on by default
+  void SetFusionEnabled(bool enabled) { fusion_enabled_ = enabled; }
+
+  // Passes of the plan, the source included
+  int GetPassCount() const { return (int)passes_.size(); }
+
+ private:
+  friend class Source;
+
+  struct Output {
+    Sink* sink;
+    int tex_idx;
+  };
+
+  // Node the plan was built from, with its graph version at the time
+  struct Watched {
+    std::shared_ptr<Source> node;
+    uint64_t graph_version;
+  };
+
+  struct Pass {
+    // Keeps the node alive for as long as the plan points at it
+    std::shared_ptr<Sink> node;
+    // Null for the source, whose pass is rendered by the caller
+    Sink* sink;
+    std::vector<Output> outputs;
+  };
+
+  Pipeline(std::shared_ptr<Source> source);
+
+  bool CompileOnContext();
+  void FuseColorFilters();
+  // Node rendering the pass
+  Source* SourceOf(size_t pass) const;
+  // Watches the node and, for a filter group, its terminal filters
+  void Watch(std::shared_ptr<Source> node);
+  // Whether an edge of a node the plan was built from has changed since
+  bool IsGraphChanged() const;
+  void Release();
+
+  // Hands the output of the node rendering the pass to its sinks. For the
+  // source, then renders the other passes. False if the node should update
+  // its sinks itself.
+  bool UpdateSinks(Source* node, int pass);
+
+  std::shared_ptr<Source> source_;
+  std::vector<Pass> passes_;
+  // Nodes whose output the passes hand on: the node itself, or the terminal
+  // filter of a filter group
+  std::vector<Source*> members_;
+  std::vector<Watched> watched_;
+  bool fusion_enabled_;
+  // Context the pipeline was created on
+  GPUPixelContext* context_;
+};
+
+}  // namespace gpupixel
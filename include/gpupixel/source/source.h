@@ -7,12 +7,15 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include "gpupixel/gpupixel_define.h"
 #include "gpupixel/sink/sink.h"
 
 namespace gpupixel {
+class Pipeline;
+
 class GPUPIXEL_API Source {
  public:
   Source();
@@ -28,23 +31,59 @@ class GPUPIXEL_API Source {
   virtual void SetFramebuffer(
       std::shared_ptr<GPUPixelFramebuffer> fb,
       RotationMode outputRotation = RotationMode::NoRotation);
+  // Null between frames for filters and raw data sources, whose output only
+  // lives until their sinks have drawn from it
   virtual std::shared_ptr<GPUPixelFramebuffer> GetFramebuffer() const;
   virtual void ReleaseFramebuffer(bool returnToCache = true);
 
   void SetFramebufferScale(float framebufferScale) {
     framebuffer_scale_ = framebufferScale;
   }
+  // Size of the output, still reported after a transient framebuffer has
+  // gone back to the pool
   int GetRotatedFramebufferWidth() const;
   int GetRotatedFramebufferHeight() const;
 
   virtual bool DoRender(bool updateSinks = true);
   virtual void DoUpdateSinks();
 
+  // Unique for the lifetime of the process, unlike the address; identifies
+  // the node in profiles
+  uint64_t GetNodeId() const { return node_id_; }
+
+  // Changes whenever an edge from this node is added or removed, so that
+  // compiled pipelines can tell that their graph may have changed
+  uint64_t GetGraphVersion() const {
+    return graph_version_.load(std::memory_order_relaxed);
+  }
+
  protected:
   std::shared_ptr<GPUPixelFramebuffer> framebuffer_;
   RotationMode output_rotation_;
   std::map<std::shared_ptr<Sink>, int> sinks_;
   float framebuffer_scale_;
+  // Output is produced anew every frame, so once it has been handed to the
+  // sinks only they keep it alive and the last one to draw from it returns it
+  // to the pool
+  bool transient_framebuffer_;
+
+  void OnGraphChanged();
+
+  // Drops a transient framebuffer, remembering its size for the getters
+  void ReleaseTransientFramebuffer();
+
+ private:
+  friend class Pipeline;
+
+  // Size of the last transient framebuffer released
+  int released_width_;
+  int released_height_;
+  uint64_t node_id_;
+  std::atomic<uint64_t> graph_version_;
+  // Set while a compiled pipeline renders the sinks: the node then only hands
+  // its output to them, and the pipeline renders them in its own order
+  Pipeline* pipeline_;
+  int pipeline_pass_;
 };
 
 }  // namespace gpupixel
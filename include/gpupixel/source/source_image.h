@@ -12,6 +12,7 @@
 
 #include "gpupixel/source/source.h"
 namespace gpupixel {
+class GPUPixelContext;
 class GPUPIXEL_API SourceImage : public Source {
  public:
   static std::shared_ptr<SourceImage> Create(const std::string name);
@@ -41,7 +42,10 @@ class GPUPIXEL_API SourceImage : public Source {
   std::vector<unsigned char> image_bytes_;
 
  private:
-  SourceImage() {}
+  SourceImage();
+
+  // Context the image was created on
+  GPUPixelContext* context_;
 };
 
 }  // namespace gpupixel
@@ -8,11 +8,14 @@
 #pragma once
 
 #include <functional>
+#include <future>
+#include <vector>
 
 #include "gpupixel/filter/filter.h"
 #include "gpupixel/source/source.h"
 
 namespace gpupixel {
+class GPUPixelContext;
 class GPUPixelGLProgram;
 class GPUPIXEL_API SourceRawData : public Filter {
  public:
@@ -20,33 +23,140 @@ class GPUPIXEL_API SourceRawData : public Filter {
 
   ~SourceRawData() override;
 
+  // `stride` is the distance in bytes between the starts of two rows and may
+  // be larger than a row; the padding is skipped and only `width` pixels of
+  // each row are drawn. For YUV frames it is that of the Y plane. The U and V
+  // rows of I420 are half as long, the interleaved rows of NV12 and NV21 as
+  // long, and the planes follow one another. The planes are uploaded as they
+  // are and converted to RGB on the GPU.
+  //
+  // With an upload ring (see SetUploadRingSize) the frame is copied into the
+  // next pixel buffer of the ring on the calling thread and ProcessData
+  // returns without waiting for it to be rendered; `data` may be reused right
+  // away.
   void ProcessData(const uint8_t* data,
                    int width,
                    int height,
                    int stride,
                    GPUPIXEL_FRAME_TYPE type);
 
+  // Same as ProcessData, but returns once the frame is queued on the GPU
+  // thread instead of waiting for the filter chain to finish. `data` must stay
+  // valid until the returned future is ready, or only for the call with an
+  // upload ring.
+  std::future<void> ProcessDataAsync(const uint8_t* data,
+                                     int width,
+                                     int height,
+                                     int stride,
+                                     GPUPIXEL_FRAME_TYPE type);
+
   void SetRotation(RotationMode rotation);
 
+  // How YUV frames are converted to RGB, BT.601 limited range by default
+  void SetYUVColorSpace(GPUPIXEL_YUV_MATRIX matrix, GPUPIXEL_YUV_RANGE range);
+
+  // Streams frames through a ring of `buffers` pixel unpack buffers, 2 or 3
+  // being typical: the caller copies a frame into a mapped buffer and the GL
+  // thread only has the driver upload from it, while up to `buffers` - 1
+  // earlier frames are still being rendered. 0, the default, uploads from
+  // the caller's memory. Frames are taken from one thread at a time. Returns
+  // false when the GL context has no pixel buffers (GLES 2, WebGL, Apple
+  // desktop GL), leaving the ring off.
+  bool SetUploadRingSize(int buffers);
+
   bool Init();
 
  private:
   SourceRawData();
 
+  // With unpack_buffer `pixels` is an offset into that buffer
   int GenerateTextureWithPixels(const uint8_t* pixels,
                                 int width,
                                 int height,
                                 int stride,
-                                GPUPIXEL_FRAME_TYPE type);
+                                GPUPIXEL_FRAME_TYPE type,
+                                uint32_t unpack_buffer = 0);
+  // Uploads the planes of a YUV frame and sets the uniforms converting them
+  void UploadYUV(const uint8_t* pixels,
+                 int width,
+                 int height,
+                 int stride,
+                 GPUPIXEL_FRAME_TYPE type);
+
+  // Size and format a texture's storage was allocated with
+  struct TextureStorage {
+    int width = 0;
+    int height = 0;
+    uint32_t format = 0;
+  };
+  // Uploads `width` x `height` texels of `format`, each `texel_size` bytes,
+  // from rows `stride` bytes apart into texture on unit. Storage is only
+  // allocated again when the size or the format changes.
+  void UploadTexture(uint32_t unit,
+                     uint32_t texture,
+                     TextureStorage& storage,
+                     uint32_t format,
+                     int texel_size,
+                     int width,
+                     int height,
+                     int stride,
+                     const uint8_t* pixels);
+
+  // A pixel unpack buffer of the upload ring
+  struct UploadBuffer {
+    uint32_t buffer = 0;
+    size_t size = 0;
+    // Where the calling thread copies the next frame, null while unmapped
+    uint8_t* mapped = nullptr;
+    // Rendering of the last frame copied, which maps the buffer again
+    std::future<void> pending;
+  };
+  // Copies a frame into the next buffer of the ring and queues its upload.
+  // Returns false, queuing nothing, when the frame cannot be streamed.
+  bool QueueRingFrame(const uint8_t* data,
+                      int width,
+                      int height,
+                      int stride,
+                      GPUPIXEL_FRAME_TYPE type,
+                      std::future<void>* rendered);
+  // On the GL thread: (re)allocates the buffer for at least `size` bytes if
+  // needed and maps it for writing
+  void MapUploadBuffer(UploadBuffer& upload, size_t size);
+  void ReleaseUploadRing();
 
  private:
-  GPUPixelGLProgram* filter_program_;
+  GPUPixelGLProgram* filter_program_ = nullptr;
   uint32_t filter_position_attribute_;
   uint32_t filter_tex_coord_attribute_;
 
   uint32_t texture_ = 0;
+  TextureStorage texture_storage_;
   RotationMode rotation_ = NoRotation;
-  std::shared_ptr<GPUPixelFramebuffer> framebuffer_;
+
+  // Draws BGRA frames, uploaded as RGBA, with red and blue swapped back
+  GPUPixelGLProgram* bgra_program_ = nullptr;
+  uint32_t bgra_position_attribute_;
+  uint32_t bgra_tex_coord_attribute_;
+
+  GPUPixelGLProgram* yuv_program_ = nullptr;
+  uint32_t yuv_position_attribute_;
+  uint32_t yuv_tex_coord_attribute_;
+  // Y, U and V planes; U holds both for NV12 and NV21
+  uint32_t yuv_textures_[3] = {0, 0, 0};
+  TextureStorage yuv_texture_storage_[3];
+  GPUPIXEL_YUV_MATRIX yuv_matrix_ = GPUPIXEL_YUV_MATRIX_BT601;
+  GPUPIXEL_YUV_RANGE yuv_range_ = GPUPIXEL_YUV_RANGE_LIMITED;
+
+  // Whether GL can skip row padding itself (GL_UNPACK_ROW_LENGTH); otherwise
+  // padded rows are packed into staging_ first
+  bool unpack_row_length_ = false;
+  std::vector<uint8_t> staging_;
+
+  bool pixel_buffers_supported_ = false;
+  std::vector<UploadBuffer> upload_ring_;
+  size_t next_upload_buffer_ = 0;
+  // Context the source was created on
+  GPUPixelContext* context_;
 };
 
 }  // namespace gpupixel
@@ -0,0 +1,36 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace gpupixel {
+
+// Timings of one filter or source over its most recent frames, see
+// GPUPixel::GetProfile. CPU time is the wall time the context thread spent
+// issuing the pass, GPU time what a GL timer query measured for it.
+struct FilterProfile {
+  // Source::GetNodeId of the filter or source
+  uint64_t node_id = 0;
+  // Filter class name, or the C++ type when none is set
+  std::string name;
+
+  int cpu_samples = 0;
+  double cpu_min_ms = 0;
+  double cpu_avg_ms = 0;
+  double cpu_p99_ms = 0;
+
+  // 0 when the driver has no timer queries
+  int gpu_samples = 0;
+  double gpu_min_ms = 0;
+  double gpu_avg_ms = 0;
+  double gpu_p99_ms = 0;
+};
+
+}  // namespace gpupixel
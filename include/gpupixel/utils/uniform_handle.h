@@ -0,0 +1,27 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+namespace gpupixel {
+
+// Location of a uniform in one program, resolved once through
+// GPUPixelGLProgram::GetUniformHandle and kept by the filter that uses it
+class UniformHandle {
+ public:
+  UniformHandle() = default;
+  explicit UniformHandle(int location) : location_(location) {}
+
+  int GetLocation() const { return location_; }
+  // False if not resolved yet or not an active uniform of the program
+  bool IsValid() const { return location_ >= 0; }
+
+ private:
+  int location_ = -1;
+};
+
+}  // namespace gpupixel
@@ -45,6 +45,11 @@ public class GPUPixelSinkRawData implements GPUPixelSink {
         return nativeGetI420Buffer(mNativeClassID);
     }
 
+    // Get NV12 buffer
+    public byte[] GetNV12Buffer() {
+        return nativeGetNV12Buffer(mNativeClassID);
+    }
+
     public void Destroy() {
         if (mNativeClassID != 0) {
             nativeDestroy(mNativeClassID);
@@ -78,4 +83,5 @@ public class GPUPixelSinkRawData implements GPUPixelSink {
     private static native int nativeGetHeight(long nativeObj);
     private static native byte[] nativeGetRgbaBuffer(long nativeObj);
     private static native byte[] nativeGetI420Buffer(long nativeObj);
+    private static native byte[] nativeGetNV12Buffer(long nativeObj);
 }
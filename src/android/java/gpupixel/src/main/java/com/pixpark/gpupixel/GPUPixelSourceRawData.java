@@ -11,6 +11,15 @@ public class GPUPixelSourceRawData extends GPUPixelSource {
     // Frame data format types
     public static final int FRAME_TYPE_RGBA = 0;
     public static final int FRAME_TYPE_BGRA = 1;
+    public static final int FRAME_TYPE_I420 = 2;
+    public static final int FRAME_TYPE_NV12 = 3;
+    public static final int FRAME_TYPE_NV21 = 4;
+
+    // YUV matrix and range types
+    public static final int YUV_MATRIX_BT601 = 0;
+    public static final int YUV_MATRIX_BT709 = 1;
+    public static final int YUV_RANGE_LIMITED = 0;
+    public static final int YUV_RANGE_FULL = 1;
 
     protected GPUPixelSourceRawData() {}
 
@@ -27,6 +36,18 @@ public class GPUPixelSourceRawData extends GPUPixelSource {
         nativeSetRotation(mNativeClassID, rotation);
     }
 
+    // Set how YUV frames are converted to RGB
+    public void SetYUVColorSpace(int matrix, int range) {
+        nativeSetYUVColorSpace(mNativeClassID, matrix, range);
+    }
+
+    // Stream frames through a ring of pixel buffers, 0 to turn it off; false
+    // when the GL context has none. ProcessData then returns once the frame
+    // is copied.
+    public boolean SetUploadRingSize(int buffers) {
+        return nativeSetUploadRingSize(mNativeClassID, buffers);
+    }
+
     // Unified data processing interface - accepts only byte[]
     public void ProcessData(byte[] data, int width, int height, int stride, int frameType) {
         nativeProcessData(mNativeClassID, data, width, height, stride, frameType);
@@ -60,4 +81,6 @@ public class GPUPixelSourceRawData extends GPUPixelSource {
     private static native void nativeProcessData(
             long nativeObj, byte[] data, int width, int height, int stride, int frameType);
     private static native void nativeSetRotation(long nativeObj, int rotation);
+    private static native void nativeSetYUVColorSpace(long nativeObj, int matrix, int range);
+    private static native boolean nativeSetUploadRingSize(long nativeObj, int buffers);
 }
@@ -144,3 +144,44 @@ Java_com_pixpark_gpupixel_GPUPixelSinkRawData_nativeGetI420Buffer(
 
   return result;
 }
+
+// Get NV12 buffer data
+extern "C" JNIEXPORT jbyteArray JNICALL
+Java_com_pixpark_gpupixel_GPUPixelSinkRawData_nativeGetNV12Buffer(
+    JNIEnv* env,
+    jclass clazz,
+    jlong native_obj) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<SinkRawData>*>(native_obj);
+  if (!ptr || !*ptr) {
+    return NULL;
+  }
+
+  const uint8_t* buffer = (*ptr)->GetNV12Buffer();
+  if (!buffer) {
+    return NULL;
+  }
+
+  int width = (*ptr)->GetWidth();
+  int height = (*ptr)->GetHeight();
+
+  // Check if width and height are valid
+  if (width <= 0 || height <= 0) {
+    return NULL;
+  }
+
+  // Check for potential overflow
+  if (width > INT_MAX / height || width * height > INT_MAX / 2) {
+    return NULL;
+  }
+
+  int size = width * height * 3 / 2;  // NV12 size = width * height * 1.5
+
+  jbyteArray result = env->NewByteArray(size);
+  if (!result) {
+    return NULL;
+  }
+
+  env->SetByteArrayRegion(result, 0, size, (jbyte*)buffer);
+
+  return result;
+}
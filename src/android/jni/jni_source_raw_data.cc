@@ -83,3 +83,32 @@ Java_com_pixpark_gpupixel_GPUPixelSourceRawData_nativeSetRotation(
     (*ptr)->SetRotation((RotationMode)rotation);
   }
 }
+
+// Set YUV matrix and range
+extern "C" JNIEXPORT void JNICALL
+Java_com_pixpark_gpupixel_GPUPixelSourceRawData_nativeSetYUVColorSpace(
+    JNIEnv* env,
+    jclass clazz,
+    jlong native_obj,
+    jint matrix,
+    jint range) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<SourceRawData>*>(native_obj);
+  if (ptr && *ptr) {
+    (*ptr)->SetYUVColorSpace((GPUPIXEL_YUV_MATRIX)matrix,
+                             (GPUPIXEL_YUV_RANGE)range);
+  }
+}
+
+// Set the number of pixel buffers frames are streamed through
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_pixpark_gpupixel_GPUPixelSourceRawData_nativeSetUploadRingSize(
+    JNIEnv* env,
+    jclass clazz,
+    jlong native_obj,
+    jint buffers) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<SourceRawData>*>(native_obj);
+  if (ptr && *ptr) {
+    return (*ptr)->SetUploadRingSize(buffers) ? JNI_TRUE : JNI_FALSE;
+  }
+  return JNI_FALSE;
+}
@@ -1,4 +1,7 @@
 #include "gpupixel/gpupixel.h"
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_gl_error_check.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
 namespace gpupixel {
@@ -6,4 +9,42 @@ namespace gpupixel {
 void GPUPixel::SetResourcePath(const std::string& path) {
   Util::SetResourcePath(fs::path(path));
 }
+
+void GPUPixel::SetProgramCachePath(const std::string& path) {
+  Util::SetProgramCachePath(fs::path(path));
+}
+
+void GPUPixel::SetGLErrorCheck(GPUPIXEL_GL_ERROR_CHECK mode,
+                               int sample_interval) {
+  GLErrorCheck::SetMode(mode, sample_interval);
+}
+
+void GPUPixel::SetProfilingEnabled(bool enabled) {
+  Profiler::SetEnabled(enabled);
+}
+
+std::vector<FilterProfile> GPUPixel::GetProfile() {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  std::vector<FilterProfile> profile;
+  context->SyncRunWithContext(
+      [&] { profile = context->GetProfiler()->GetProfile(); });
+  return profile;
+}
+
+void GPUPixel::ResetProfile() {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->SyncRunWithContext([&] { context->GetProfiler()->Reset(); });
+}
+
+void GPUPixel::SetTracingEnabled(bool enabled) {
+  Trace::SetEnabled(enabled);
+}
+
+bool GPUPixel::WriteTrace(const std::string& path) {
+  return Trace::WriteJson(path);
+}
+
+void GPUPixel::ClearTrace() {
+  Trace::Clear();
+}
 }  // namespace gpupixel
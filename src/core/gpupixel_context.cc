@@ -6,8 +6,11 @@
  */
 
 #include "core/gpupixel_context.h"
+#include <cstdio>
+#include <cstring>
 #include "utils/dispatch_queue.h"
 #include "utils/logging.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 #if defined(GPUPIXEL_WASM)
 #include <emscripten.h>
@@ -16,10 +19,22 @@
 
 namespace gpupixel {
 
+namespace {
+// Context bound to the calling thread; workers bind their own context
+thread_local GPUPixelContext* g_thread_context = nullptr;
+
+// EGL displays and GLFW are process-wide, so only the last context alive may
+// terminate them. The mutex also serializes GLFW calls, which are not
+// thread-safe, across context workers.
+std::mutex g_platform_mutex;
+int g_platform_refs = 0;
+}  // namespace
+
 GPUPixelContext* GPUPixelContext::instance_ = 0;
 std::mutex GPUPixelContext::mutex_;
 
-GPUPixelContext::GPUPixelContext() : current_shader_program_(0) {
+GPUPixelContext::GPUPixelContext(GPUPixelContext* share_context)
+    : share_context_(share_context) {
   LOG_DEBUG("Creating GPUPixelContext");
 #if !defined(GPUPIXEL_WASM)
   task_queue_ = std::make_shared<DispatchQueue>();
@@ -30,12 +45,48 @@ GPUPixelContext::GPUPixelContext() : current_shader_program_(0) {
 
 GPUPixelContext::~GPUPixelContext() {
   LOG_DEBUG("Destroying GPUPixelContext");
-  ReleaseContext();
+  // Framebuffers delete their GL objects through this context, and the GL
+  // context is current on the worker, so release both before stopping it
   delete framebuffer_factory_;
+#if defined(GPUPIXEL_WASM)
+  ReleaseContext();
+#else
+  task_queue_->runTask([this]() {
+    UseAsCurrent();
+    ReleaseContext();
+  });
   task_queue_->stop();
+#endif
+}
+
+std::shared_ptr<GPUPixelContext> GPUPixelContext::Create(
+    GPUPixelContext* share_context) {
+  return std::shared_ptr<GPUPixelContext>(
+      new (std::nothrow) GPUPixelContext(share_context),
+      [](GPUPixelContext* context) { delete context; });
+}
+
+void GPUPixelContext::SetThreadContext(GPUPixelContext* context) {
+  g_thread_context = context;
+}
+
+GPUPixelContext* GPUPixelContext::GetThreadContext() {
+  return g_thread_context;
+}
+
+GPUPixelContext::Scope::Scope(GPUPixelContext* context)
+    : previous_(g_thread_context) {
+  g_thread_context = context;
+}
+
+GPUPixelContext::Scope::~Scope() {
+  g_thread_context = previous_;
 }
 
 GPUPixelContext* GPUPixelContext::GetInstance() {
+  if (g_thread_context) {
+    return g_thread_context;
+  }
   if (!instance_) {
     std::unique_lock<std::mutex> lock(mutex_);
     if (!instance_) {
@@ -55,7 +106,9 @@ void GPUPixelContext::Destroy() {
 void GPUPixelContext::Init() {
   SyncRunWithContext([=] {
     LOG_INFO("Initializing GPUPixelContext");
+    Trace::SetThreadName("GPUPixel context");
     this->CreateContext();
+    gl_error_check_.Apply();
   });
 }
 
@@ -63,11 +116,217 @@ FramebufferFactory* GPUPixelContext::GetFramebufferFactory() const {
   return framebuffer_factory_;
 }
 
+// Compares GL program names rather than wrappers: wrappers share programs, and
+// a new wrapper can be allocated at the address of a deleted one
 void GPUPixelContext::SetActiveGlProgram(GPUPixelGLProgram* shaderProgram) {
-  if (current_shader_program_ != shaderProgram) {
-    current_shader_program_ = shaderProgram;
-    shaderProgram->UseProgram();
+  GLuint program = shaderProgram->GetProgram();
+  if (gl_state_cache_enabled_ && gl_state_.program_known &&
+      gl_state_.program == program) {
+    ++gl_state_stats_.skipped;
+    return;
   }
+  ++gl_state_stats_.calls;
+  gl_state_.program_known = true;
+  gl_state_.program = program;
+  shaderProgram->UseProgram();
+}
+
+void GPUPixelContext::BindFramebuffer(GLuint framebuffer) {
+  if (gl_state_cache_enabled_ && gl_state_.framebuffer_known &&
+      gl_state_.framebuffer == framebuffer) {
+    ++gl_state_stats_.skipped;
+    return;
+  }
+  ++gl_state_stats_.calls;
+  gl_state_.framebuffer_known = true;
+  gl_state_.framebuffer = framebuffer;
+  GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer));
+}
+
+void GPUPixelContext::SetViewport(GLint x,
+                                  GLint y,
+                                  GLsizei width,
+                                  GLsizei height) {
+  GLint viewport[4] = {x, y, width, height};
+  if (gl_state_cache_enabled_ && gl_state_.viewport_known &&
+      memcmp(gl_state_.viewport, viewport, sizeof(viewport)) == 0) {
+    ++gl_state_stats_.skipped;
+    return;
+  }
+  ++gl_state_stats_.calls;
+  gl_state_.viewport_known = true;
+  memcpy(gl_state_.viewport, viewport, sizeof(viewport));
+  GL_CALL(glViewport(x, y, width, height));
+}
+
+void GPUPixelContext::BindTexture(GLuint unit, GLuint texture) {
+  uint32_t unit_bit = unit < kCachedTextureUnits ? 1u << unit : 0;
+  if (gl_state_cache_enabled_ && (gl_state_.textures_known & unit_bit) &&
+      gl_state_.textures[unit] == texture) {
+    ++gl_state_stats_.skipped;
+    return;
+  }
+
+  if (!gl_state_cache_enabled_ || !gl_state_.active_texture_unit_known ||
+      gl_state_.active_texture_unit != unit) {
+    ++gl_state_stats_.calls;
+    gl_state_.active_texture_unit_known = true;
+    gl_state_.active_texture_unit = unit;
+    GL_CALL(glActiveTexture(GL_TEXTURE0 + unit));
+  }
+  ++gl_state_stats_.calls;
+  if (unit_bit) {
+    gl_state_.textures_known |= unit_bit;
+    gl_state_.textures[unit] = texture;
+  }
+  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture));
+}
+
+void GPUPixelContext::EnableVertexAttribArray(GLuint index) {
+  uint32_t index_bit = index < 32 ? 1u << index : 0;
+  if (gl_state_cache_enabled_ &&
+      (gl_state_.attributes_known & gl_state_.attributes_enabled & index_bit)) {
+    ++gl_state_stats_.skipped;
+    return;
+  }
+  ++gl_state_stats_.calls;
+  gl_state_.attributes_known |= index_bit;
+  gl_state_.attributes_enabled |= index_bit;
+  GL_CALL(glEnableVertexAttribArray(index));
+}
+
+void GPUPixelContext::SetClearColor(GLfloat red,
+                                    GLfloat green,
+                                    GLfloat blue,
+                                    GLfloat alpha) {
+  GLfloat color[4] = {red, green, blue, alpha};
+  if (gl_state_cache_enabled_ && gl_state_.clear_color_known &&
+      memcmp(gl_state_.clear_color, color, sizeof(color)) == 0) {
+    ++gl_state_stats_.skipped;
+    return;
+  }
+  ++gl_state_stats_.calls;
+  gl_state_.clear_color_known = true;
+  memcpy(gl_state_.clear_color, color, sizeof(color));
+  GL_CALL(glClearColor(red, green, blue, alpha));
+}
+
+void GPUPixelContext::InvalidateGlState() {
+  gl_state_ = GlState();
+}
+
+void GPUPixelContext::SetGlStateCacheEnabled(bool enabled) {
+  gl_state_cache_enabled_ = enabled;
+  InvalidateGlState();
+}
+
+void GPUPixelContext::OnProgramDeleted(GLuint program) {
+  if (gl_state_.program == program) {
+    gl_state_.program_known = false;
+  }
+}
+
+void GPUPixelContext::OnFramebufferDeleted(GLuint framebuffer) {
+  if (gl_state_.framebuffer == framebuffer) {
+    gl_state_.framebuffer_known = false;
+  }
+}
+
+void GPUPixelContext::OnTextureDeleted(GLuint texture) {
+  for (GLuint unit = 0; unit < kCachedTextureUnits; ++unit) {
+    if (gl_state_.textures[unit] == texture) {
+      gl_state_.textures_known &= ~(1u << unit);
+    }
+  }
+}
+
+void GPUPixelContext::OnFrameEnd() {
+  gl_error_check_.OnFrameEnd();
+  profiler_.OnFrameEnd();
+}
+
+void GPUPixelContext::ReadGLVersion() {
+  if (gl_major_version_ >= 0) {
+    return;
+  }
+  SyncRunWithContext([=] {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    const char* es = version ? strstr(version, "OpenGL ES") : nullptr;
+    int major = 0;
+    int minor = 0;
+    if (es) {
+      sscanf(es, "OpenGL ES %d.%d", &major, &minor);
+    } else if (version) {
+      sscanf(version, "%d.%d", &major, &minor);
+    }
+
+    gl_extensions_.clear();
+#if defined(GL_NUM_EXTENSIONS)
+    if (!es && major >= 3) {
+      GLint count = 0;
+      glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+      for (GLint i = 0; i < count; ++i) {
+        const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (name) {
+          gl_extensions_.insert(name);
+        }
+      }
+    }
+#endif
+    if (es || major < 3) {
+      const char* names = (const char*)glGetString(GL_EXTENSIONS);
+      std::string list = names ? names : "";
+      size_t begin = 0;
+      while (begin < list.size()) {
+        size_t end = list.find(' ', begin);
+        if (end == std::string::npos) {
+          end = list.size();
+        }
+        if (end > begin) {
+          gl_extensions_.insert(list.substr(begin, end - begin));
+        }
+        begin = end + 1;
+      }
+    }
+
+    gles_ = es != nullptr;
+    gl_minor_version_ = minor;
+    gl_major_version_ = major;
+  });
+}
+
+int GPUPixelContext::GetGLMajorVersion() {
+  ReadGLVersion();
+  return gl_major_version_;
+}
+
+int GPUPixelContext::GetGLMinorVersion() {
+  ReadGLVersion();
+  return gl_minor_version_;
+}
+
+bool GPUPixelContext::IsGLES() {
+  ReadGLVersion();
+  return gles_;
+}
+
+bool GPUPixelContext::HasGLExtension(const std::string& name) {
+  ReadGLVersion();
+  return gl_extensions_.count(name) > 0;
+}
+
+bool GPUPixelContext::SupportsPixelBuffers() {
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+  ReadGLVersion();
+#if defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+  // Loaded by glad only when the driver has them
+  return gl_major_version_ >= 3 && glMapBufferRange && glFenceSync;
+#else
+  return gl_major_version_ >= 3;
+#endif
+#else
+  return false;
+#endif
 }
 
 void GPUPixelContext::Clean() {
@@ -78,7 +337,10 @@ void GPUPixelContext::Clean() {
 void GPUPixelContext::CreateContext() {
 #if defined(GPUPIXEL_IOS)
   LOG_DEBUG("Creating iOS OpenGL ES 2.0 context");
-  egl_context_ = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES2];
+  egl_context_ = [[EAGLContext alloc]
+      initWithAPI:kEAGLRenderingAPIOpenGLES2
+       sharegroup:share_context_ ? share_context_->egl_context_.sharegroup
+                                 : nil];
   if (!egl_context_) {
     LOG_ERROR("Failed to create iOS OpenGL ES 2.0 context");
     return;
@@ -109,7 +371,11 @@ void GPUPixelContext::CreateContext() {
   }
 
   image_processing_context_ =
-      [[NSOpenGLContext alloc] initWithFormat:pixel_format_ shareContext:nil];
+      [[NSOpenGLContext alloc]
+          initWithFormat:pixel_format_
+            shareContext:share_context_
+                             ? share_context_->image_processing_context_
+                             : nil];
   if (!image_processing_context_) {
     LOG_ERROR("Failed to create NSOpenGLContext");
     return;
@@ -132,8 +398,13 @@ void GPUPixelContext::CreateContext() {
   EGLint major, minor;
   if (!eglInitialize(egl_display_, &major, &minor)) {
     LOG_ERROR("Failed to initialize EGL");
+    egl_display_ = EGL_NO_DISPLAY;
     return;
   }
+  {
+    std::lock_guard<std::mutex> lock(g_platform_mutex);
+    ++g_platform_refs;
+  }
   LOG_DEBUG("EGL initialized: version major:{} minor:{}", major, minor);
 
   // Configure EGL
@@ -165,8 +436,10 @@ void GPUPixelContext::CreateContext() {
   // Create EGL context
   const EGLint contextAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
 
-  egl_context_ = eglCreateContext(egl_display_, egl_config_, EGL_NO_CONTEXT,
-                                  contextAttribs);
+  egl_context_ = eglCreateContext(
+      egl_display_, egl_config_,
+      share_context_ ? share_context_->egl_context_ : EGL_NO_CONTEXT,
+      contextAttribs);
   if (egl_context_ == EGL_NO_CONTEXT) {
     LOG_ERROR("Failed to create EGL context");
     return;
@@ -188,8 +461,110 @@ void GPUPixelContext::CreateContext() {
     return;
   }
   LOG_INFO("Android EGL context created successfully");
+#elif defined(GPUPIXEL_LINUX_HEADLESS)
+  LOG_DEBUG("Creating headless EGL context");
+  // Prefer Mesa's surfaceless platform, which needs neither a display server
+  // nor a GPU device node; fall back to the default display otherwise
+  const char* client_extensions =
+      eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  auto get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress(
+          "eglGetPlatformDisplayEXT");
+  if (client_extensions && get_platform_display &&
+      strstr(client_extensions, "EGL_MESA_platform_surfaceless")) {
+    egl_display_ = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                        EGL_DEFAULT_DISPLAY, nullptr);
+  }
+  if (egl_display_ == EGL_NO_DISPLAY) {
+    LOG_DEBUG("Surfaceless EGL platform unavailable, using default display");
+    egl_display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  if (egl_display_ == EGL_NO_DISPLAY) {
+    LOG_ERROR("Failed to get EGL display");
+    return;
+  }
+
+  EGLint major, minor;
+  if (!eglInitialize(egl_display_, &major, &minor)) {
+    LOG_ERROR("Failed to initialize EGL");
+    egl_display_ = EGL_NO_DISPLAY;
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(g_platform_mutex);
+    ++g_platform_refs;
+  }
+  LOG_DEBUG("EGL initialized: version major:{} minor:{}", major, minor);
+
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    LOG_ERROR("Failed to bind desktop OpenGL API");
+    return;
+  }
+
+  // Without EGL_KHR_surfaceless_context a 1x1 pbuffer stands in for the
+  // window surface; all rendering goes to framebuffer objects anyway
+  const char* display_extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+  bool surfaceless = display_extensions &&
+                     strstr(display_extensions, "EGL_KHR_surfaceless_context");
+
+  const EGLint configAttribs[] = {EGL_RED_SIZE,
+                                  8,
+                                  EGL_GREEN_SIZE,
+                                  8,
+                                  EGL_BLUE_SIZE,
+                                  8,
+                                  EGL_ALPHA_SIZE,
+                                  8,
+                                  EGL_SURFACE_TYPE,
+                                  surfaceless ? 0 : EGL_PBUFFER_BIT,
+                                  EGL_RENDERABLE_TYPE,
+                                  EGL_OPENGL_BIT,
+                                  EGL_NONE};
+
+  EGLConfig config;
+  EGLint numConfigs = 0;
+  if (!eglChooseConfig(egl_display_, configAttribs, &config, 1, &numConfigs) ||
+      numConfigs < 1) {
+    LOG_ERROR("Failed to choose EGL config");
+    return;
+  }
+
+  // Same version the GLFW backend requests
+  const EGLint contextAttribs[] = {EGL_CONTEXT_MAJOR_VERSION, 3,
+                                   EGL_CONTEXT_MINOR_VERSION, 0, EGL_NONE};
+  egl_context_ = eglCreateContext(
+      egl_display_, config,
+      share_context_ ? share_context_->egl_context_ : EGL_NO_CONTEXT,
+      contextAttribs);
+  if (egl_context_ == EGL_NO_CONTEXT) {
+    LOG_ERROR("Failed to create EGL context");
+    return;
+  }
+
+  if (!surfaceless) {
+    const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    egl_surface_ = eglCreatePbufferSurface(egl_display_, config, pbufferAttribs);
+    if (egl_surface_ == EGL_NO_SURFACE) {
+      LOG_ERROR("Failed to create EGL surface");
+      return;
+    }
+  }
+
+  if (!eglMakeCurrent(egl_display_, egl_surface_, egl_surface_, egl_context_)) {
+    LOG_ERROR("Failed to make EGL context current");
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(g_platform_mutex);
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+    LOG_ERROR("Failed to initialize GLAD");
+    return;
+  }
+  LOG_INFO("Headless EGL context created successfully ({})",
+           surfaceless ? "surfaceless" : "pbuffer");
 #elif defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
   LOG_DEBUG("Creating Windows/Linux OpenGL context");
+  std::lock_guard<std::mutex> lock(g_platform_mutex);
   int ret = glfwInit();
 
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -201,12 +576,17 @@ void GPUPixelContext::CreateContext() {
     LOG_ERROR("Failed to initialize GLFW");
     return;
   }
-  gl_context_ = glfwCreateWindow(1, 1, "gpupixel opengl context", NULL, NULL);
+  gl_context_ = glfwCreateWindow(1, 1, "gpupixel opengl context", NULL,
+                                 share_context_ ? share_context_->gl_context_
+                                                : NULL);
   if (!gl_context_) {
     LOG_ERROR("Failed to create GLFW window");
-    glfwTerminate();
+    if (g_platform_refs == 0) {
+      glfwTerminate();
+    }
     return;
   }
+  ++g_platform_refs;
   glfwMakeContextCurrent(gl_context_);
 
   if (!gladLoadGL()) {
@@ -216,6 +596,9 @@ void GPUPixelContext::CreateContext() {
   LOG_INFO("Windows/Linux OpenGL context created successfully");
 #elif defined(GPUPIXEL_WASM)
   LOG_DEBUG("Creating WebGL context");
+  if (share_context_) {
+    LOG_WARN("WebGL contexts cannot share objects, ignoring share context");
+  }
   EmscriptenWebGLContextAttributes attrs;
   emscripten_webgl_init_context_attributes(&attrs);
   attrs.majorVersion = 2;  // Use WebGL 2.0
@@ -231,6 +614,7 @@ void GPUPixelContext::CreateContext() {
 }
 
 void GPUPixelContext::UseAsCurrent() {
+  g_thread_context = this;
 #if defined(GPUPIXEL_IOS)
   if ([EAGLContext currentContext] != egl_context_) {
     LOG_TRACE("Setting current EAGLContext");
@@ -241,7 +625,7 @@ void GPUPixelContext::UseAsCurrent() {
     LOG_TRACE("Setting current NSOpenGLContext");
     [image_processing_context_ makeCurrentContext];
   }
-#elif defined(GPUPIXEL_ANDROID)
+#elif defined(GPUPIXEL_ANDROID) || defined(GPUPIXEL_LINUX_HEADLESS)
   if (eglGetCurrentContext() != egl_context_) {
     LOG_TRACE("Setting current EGL context");
     eglMakeCurrent(egl_display_, egl_surface_, egl_surface_, egl_context_);
@@ -271,7 +655,7 @@ void GPUPixelContext::PresentBufferForDisplay() {
 
 void GPUPixelContext::ReleaseContext() {
   LOG_DEBUG("Releasing OpenGL context");
-#if defined(GPUPIXEL_ANDROID)
+#if defined(GPUPIXEL_ANDROID) || defined(GPUPIXEL_LINUX_HEADLESS)
   if (egl_display_ != EGL_NO_DISPLAY) {
     eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE,
                    EGL_NO_CONTEXT);
@@ -288,17 +672,26 @@ void GPUPixelContext::ReleaseContext() {
       egl_context_ = EGL_NO_CONTEXT;
     }
 
-    LOG_TRACE("Terminating EGL display");
-    eglTerminate(egl_display_);
+    eglReleaseThread();
+
+    std::lock_guard<std::mutex> lock(g_platform_mutex);
+    if (--g_platform_refs == 0) {
+      LOG_TRACE("Terminating EGL display");
+      eglTerminate(egl_display_);
+    }
     egl_display_ = EGL_NO_DISPLAY;
   }
 #elif defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+  std::lock_guard<std::mutex> lock(g_platform_mutex);
   if (gl_context_) {
     LOG_TRACE("Destroying GLFW window");
     glfwDestroyWindow(gl_context_);
+    gl_context_ = nullptr;
+    if (--g_platform_refs == 0) {
+      LOG_TRACE("Terminating GLFW");
+      glfwTerminate();
+    }
   }
-  LOG_TRACE("Terminating GLFW");
-  glfwTerminate();
 #elif defined(GPUPIXEL_WASM)
   LOG_TRACE("Destroying WebGL context");
   emscripten_webgl_destroy_context(wasm_context_);
@@ -306,7 +699,7 @@ void GPUPixelContext::ReleaseContext() {
   LOG_INFO("OpenGL context released successfully");
 }
 
-void GPUPixelContext::SyncRunWithContext(std::function<void(void)> task) {
+void GPUPixelContext::SyncRunWithContext(TaskRef task) {
 #if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
   if (!Util::IsAppleAppActive()) {
     return;
@@ -319,8 +712,59 @@ void GPUPixelContext::SyncRunWithContext(std::function<void(void)> task) {
   task();
 #else
   LOG_TRACE("Running task on task queue");
-  task_queue_->runTask([=]() {
+  // On the worker the task runs inline, as part of what is being recorded
+  bool nested = task_queue_->isWorkerThread();
+  TraceScope wait(nested ? nullptr : "SyncRunWithContext wait", "context");
+  task_queue_->runTask([&]() {
+    UseAsCurrent();
+    TraceScope scope(nested ? nullptr : "SyncRunWithContext", "context");
+    task();
+  });
+#endif
+}
+
+std::future<void> GPUPixelContext::AsyncRunWithContext(
+    std::function<void(void)> task) {
+#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
+  if (!Util::IsAppleAppActive()) {
+    std::promise<void> skipped;
+    skipped.set_value();
+    return skipped.get_future();
+  }
+#endif
+
+#if defined(GPUPIXEL_WASM)
+  // WebGL has no worker thread, so the task completes before returning
+  std::promise<void> promise;
+  UseAsCurrent();
+  task();
+  promise.set_value();
+  return promise.get_future();
+#else
+  LOG_TRACE("Running task asynchronously on task queue");
+  return task_queue_->runTaskAsync([=]() {
+    UseAsCurrent();
+    TraceScope scope("AsyncRunWithContext", "context");
+    task();
+  });
+#endif
+}
+
+void GPUPixelContext::PostRunWithContext(std::function<void(void)> task) {
+#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
+  if (!Util::IsAppleAppActive()) {
+    return;
+  }
+#endif
+
+#if defined(GPUPIXEL_WASM)
+  UseAsCurrent();
+  task();
+#else
+  LOG_TRACE("Posting task to task queue");
+  task_queue_->postTask([this, task = std::move(task)]() {
     UseAsCurrent();
+    TraceScope scope("PostRunWithContext", "context");
     task();
   });
 #endif
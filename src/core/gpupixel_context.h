@@ -7,28 +7,109 @@
 
 #pragma once
 
+#include <future>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <string>
 #include "core/gpupixel_framebuffer_factory.h"
 #include "gpupixel/filter/filter.h"
 #include "gpupixel/gpupixel_define.h"
 
 #include "core/gpupixel_gl_include.h"
+#include "core/gpupixel_profiler.h"
 #include "core/gpupixel_program.h"
-
-class DispatchQueue;
+#include "utils/dispatch_queue.h"
 
 namespace gpupixel {
 
+struct GlStateStats {
+  // State changes that reached the driver / that the context already had
+  uint64_t calls = 0;
+  uint64_t skipped = 0;
+};
+
 class GPUPIXEL_API GPUPixelContext {
  public:
+  // Returns the context bound to the calling thread (see SetThreadContext), or
+  // the process-wide default context when none is bound. On a context's own
+  // worker thread this is always that context.
   static GPUPixelContext* GetInstance();
   static void Destroy();
 
+  // Creates an independent context with its own worker thread, GL context and
+  // framebuffer pool. When share_context is given, GL objects are shared with
+  // it. The context must outlive every object created on it.
+  static std::shared_ptr<GPUPixelContext> Create(
+      GPUPixelContext* share_context = nullptr);
+
+  // Binds context to the calling thread so that sources, filters and sinks
+  // created on this thread use it; nullptr restores the default context.
+  static void SetThreadContext(GPUPixelContext* context);
+  static GPUPixelContext* GetThreadContext();
+
+  // Binds a context to the calling thread for the lifetime of the scope.
+  class GPUPIXEL_API Scope {
+   public:
+    explicit Scope(GPUPixelContext* context);
+    ~Scope();
+
+   private:
+    GPUPixelContext* previous_;
+  };
+
   FramebufferFactory* GetFramebufferFactory() const;
   void SetActiveGlProgram(GPUPixelGLProgram* shaderProgram);
   void Clean();
 
-  void SyncRunWithContext(std::function<void(void)> func);
+  // GL state cache. Changes made through these calls are skipped when the GL
+  // context already has the state; they must be made on the context thread.
+  // Code that changes the same state with direct GL calls, e.g. an application
+  // sharing the GL context, calls InvalidateGlState afterwards.
+  void BindFramebuffer(GLuint framebuffer);
+  void SetViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+  // Makes unit the active texture unit and binds texture to its
+  // GL_TEXTURE_2D target
+  void BindTexture(GLuint unit, GLuint texture);
+  void EnableVertexAttribArray(GLuint index);
+  void SetClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+  void InvalidateGlState();
+  // With the cache disabled every change reaches the driver, e.g. to rule the
+  // cache out when chasing a rendering problem
+  void SetGlStateCacheEnabled(bool enabled);
+  // Deleting a bound object unbinds it and the driver may hand its name out
+  // again, so deletions are reported to forget the binding
+  void OnProgramDeleted(GLuint program);
+  void OnFramebufferDeleted(GLuint framebuffer);
+  void OnTextureDeleted(GLuint texture);
+  GlStateStats GetGlStateStats() const { return gl_state_stats_; }
+
+  // Called on the context thread once a source has rendered a frame through
+  // its sinks
+  void OnFrameEnd();
+
+  Profiler* GetProfiler() { return &profiler_; }
+
+  // Version of the GL context, read on the context thread the first time it
+  // is asked for. GL_VERSION starts with "OpenGL ES" on GLES and WebGL.
+  int GetGLMajorVersion();
+  int GetGLMinorVersion();
+  bool IsGLES();
+  // Whether the context advertises the extension, e.g. "GL_KHR_debug". Core
+  // profiles list extensions through glGetStringi only.
+  bool HasGLExtension(const std::string& name);
+  // Whether pixel buffers can be mapped and fenced, see
+  // GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+  bool SupportsPixelBuffers();
+
+  // Run func on the context thread and wait for it. func is referenced, not
+  // copied, so the call does not allocate.
+  void SyncRunWithContext(TaskRef func);
+  // Queue func on the context thread and return immediately; the returned
+  // future becomes ready once func has run.
+  std::future<void> AsyncRunWithContext(std::function<void(void)> func);
+  // Fire-and-forget variant of AsyncRunWithContext.
+  void PostRunWithContext(std::function<void(void)> func);
   void UseAsCurrent(void);
   void PresentBufferForDisplay();
 
@@ -38,7 +119,7 @@ class GPUPIXEL_API GPUPixelContext {
   NSOpenGLContext* GetOpenGLContext() const {
     return image_processing_context_;
   };
-#elif defined(GPUPIXEL_ANDROID)
+#elif defined(GPUPIXEL_ANDROID) || defined(GPUPIXEL_LINUX_HEADLESS)
   EGLContext GetEglContext() const { return egl_context_; };
   EGLDisplay GetEglDisplay() const { return egl_display_; };
   EGLSurface GetEglSurface() const { return egl_surface_; };
@@ -47,19 +128,52 @@ class GPUPIXEL_API GPUPixelContext {
 #endif
 
  private:
-  GPUPixelContext();
+  GPUPixelContext(GPUPixelContext* share_context = nullptr);
   ~GPUPixelContext();
 
   void Init();
 
   void CreateContext();
   void ReleaseContext();
+  void ReadGLVersion();
 
  private:
   static GPUPixelContext* instance_;
   static std::mutex mutex_;
   FramebufferFactory* framebuffer_factory_;
-  GPUPixelGLProgram* current_shader_program_;
+
+  static constexpr GLuint kCachedTextureUnits = 32;
+  // What the GL context is known to have; a field is only valid while its
+  // known flag is set
+  struct GlState {
+    bool program_known = false;
+    GLuint program = 0;
+    bool framebuffer_known = false;
+    GLuint framebuffer = 0;
+    bool viewport_known = false;
+    GLint viewport[4] = {0, 0, 0, 0};
+    bool active_texture_unit_known = false;
+    GLuint active_texture_unit = 0;
+    // Bit n set when textures[n] is known
+    uint32_t textures_known = 0;
+    GLuint textures[kCachedTextureUnits] = {};
+    // Bit n set when the enabled state of attribute n is known / enabled
+    uint32_t attributes_known = 0;
+    uint32_t attributes_enabled = 0;
+    bool clear_color_known = false;
+    GLfloat clear_color[4] = {0, 0, 0, 0};
+  };
+  GlState gl_state_;
+  bool gl_state_cache_enabled_ = true;
+  GlStateStats gl_state_stats_;
+  // -1 until read
+  int gl_major_version_ = -1;
+  int gl_minor_version_ = 0;
+  bool gles_ = false;
+  std::set<std::string> gl_extensions_;
+  GLErrorCheck gl_error_check_;
+  Profiler profiler_;
+  GPUPixelContext* share_context_;
   std::shared_ptr<DispatchQueue> task_queue_;
 
 #if defined(GPUPIXEL_IOS)
@@ -72,8 +186,12 @@ class GPUPIXEL_API GPUPixelContext {
   EGLConfig egl_config_;
   EGLSurface egl_surface_;
   EGLContext egl_context_;
+#elif defined(GPUPIXEL_LINUX_HEADLESS)
+  EGLDisplay egl_display_ = EGL_NO_DISPLAY;
+  EGLSurface egl_surface_ = EGL_NO_SURFACE;
+  EGLContext egl_context_ = EGL_NO_CONTEXT;
 #elif defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
-  GLFWwindow* gl_context_;
+  GLFWwindow* gl_context_ = nullptr;
 #elif defined(GPUPIXEL_WASM)
   EMSCRIPTEN_WEBGL_CONTEXT_HANDLE wasm_context_;
 #endif
@@ -35,7 +35,9 @@ GPUPixelFramebuffer::GPUPixelFramebuffer(
     bool only_generate_texture /* = false*/,
     const TextureAttributes
         texture_attributes /* = default_texture_attributes*/)
-    : texture_(-1), framebuffer_(-1) {
+    : texture_(-1),
+      framebuffer_(-1),
+      context_(GPUPixelContext::GetInstance()) {
   width_ = width;
   height_ = height;
   texture_attributes_ = texture_attributes;
@@ -49,33 +51,35 @@ GPUPixelFramebuffer::GPUPixelFramebuffer(
 }
 
 GPUPixelFramebuffer::~GPUPixelFramebuffer() {
-  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+  context_->SyncRunWithContext([&] {
     bool should_delete_texture = (texture_ != -1);
     bool should_delete_framebuffer = (framebuffer_ != -1);
 
     if (should_delete_texture) {
       GL_CALL(glDeleteTextures(1, &texture_));
+      context_->OnTextureDeleted(texture_);
       texture_ = -1;
     }
     if (should_delete_framebuffer) {
       GL_CALL(glDeleteFramebuffers(1, &framebuffer_));
+      context_->OnFramebufferDeleted(framebuffer_);
       framebuffer_ = -1;
     }
   });
 }
 
 void GPUPixelFramebuffer::Activate() {
-  GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_));
-  GL_CALL(glViewport(0, 0, width_, height_));
+  context_->BindFramebuffer(framebuffer_);
+  context_->SetViewport(0, 0, width_, height_);
 }
 
-void GPUPixelFramebuffer::Deactivate() {
-  GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
-}
+// The next pass binds its own target, so the framebuffer is left bound rather
+// than switching to framebuffer 0 between passes
+void GPUPixelFramebuffer::Deactivate() {}
 
 void GPUPixelFramebuffer::GenerateTexture() {
   GL_CALL(glGenTextures(1, &texture_));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture_));
+  context_->BindTexture(0, texture_);
   GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
                           texture_attributes_.minFilter));
   GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER,
@@ -86,21 +90,17 @@ void GPUPixelFramebuffer::GenerateTexture() {
                           texture_attributes_.wrapT));
 
   // TODO: Handle mipmaps
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
 }
 
 void GPUPixelFramebuffer::GenerateFramebuffer() {
   GL_CALL(glGenFramebuffers(1, &framebuffer_));
-  GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_));
+  context_->BindFramebuffer(framebuffer_);
   GenerateTexture();
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture_));
   GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, texture_attributes_.internalFormat,
                        width_, height_, 0, texture_attributes_.format,
                        texture_attributes_.type, 0));
   GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
                                  GL_TEXTURE_2D, texture_, 0));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-  GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
 }
 
 }  // namespace gpupixel
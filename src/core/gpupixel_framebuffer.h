@@ -12,6 +12,8 @@
 #include <vector>
 
 namespace gpupixel {
+class GPUPixelContext;
+
 typedef struct GPUPIXEL_API {
   GLenum minFilter;
   GLenum magFilter;
@@ -40,7 +42,8 @@ class GPUPIXEL_API GPUPixelFramebuffer {
   const TextureAttributes& GetTextureAttributes() const {
     return texture_attributes_;
   };
-  bool HasFramebuffer() { return has_framebuffer_; };
+  bool HasFramebuffer() const { return has_framebuffer_; };
+  GPUPixelContext* GetContext() const { return context_; }
 
   void Activate();
   void Deactivate();
@@ -54,6 +57,8 @@ class GPUPIXEL_API GPUPixelFramebuffer {
   bool has_framebuffer_;
   uint32_t texture_;
   uint32_t framebuffer_;
+  // Context the GL objects were created on
+  GPUPixelContext* context_;
 
   void GenerateTexture();
   void GenerateFramebuffer();
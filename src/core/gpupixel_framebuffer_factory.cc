@@ -6,10 +6,92 @@
  */
 
 #include "core/gpupixel_framebuffer_factory.h"
-#include "utils/util.h"
+#include <algorithm>
+#include <cstring>
 
 namespace gpupixel {
 
+namespace {
+
+size_t ComponentCount(GLenum format) {
+  switch (format) {
+    case GL_ALPHA:
+    case GL_LUMINANCE:
+#if defined(GL_RED)
+    case GL_RED:
+#endif
+      return 1;
+    case GL_LUMINANCE_ALPHA:
+#if defined(GL_RG)
+    case GL_RG:
+#endif
+      return 2;
+    case GL_RGB:
+      return 3;
+    default:
+      return 4;
+  }
+}
+
+size_t BytesPerPixel(GLenum format, GLenum type) {
+  switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      return 2;
+#if defined(GL_HALF_FLOAT)
+    case GL_HALF_FLOAT:
+#endif
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+      return ComponentCount(format) * 2;
+    case GL_FLOAT:
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+      return ComponentCount(format) * 4;
+    default:
+      return ComponentCount(format);
+  }
+}
+
+}  // namespace
+
+FramebufferKey FramebufferKey::Make(
+    int width,
+    int height,
+    bool only_texture,
+    const TextureAttributes& texture_attributes) {
+  FramebufferKey key;
+  key.width = width;
+  key.height = height;
+  key.min_filter = texture_attributes.minFilter;
+  key.mag_filter = texture_attributes.magFilter;
+  key.wrap_s = texture_attributes.wrapS;
+  key.wrap_t = texture_attributes.wrapT;
+  key.internal_format = texture_attributes.internalFormat;
+  key.format = texture_attributes.format;
+  key.type = texture_attributes.type;
+  key.only_texture = only_texture ? 1 : 0;
+  return key;
+}
+
+bool FramebufferKey::operator==(const FramebufferKey& other) const {
+  return memcmp(this, &other, sizeof(FramebufferKey)) == 0;
+}
+
+size_t FramebufferKeyHash::operator()(const FramebufferKey& key) const {
+  static_assert(sizeof(FramebufferKey) % sizeof(uint32_t) == 0,
+                "FramebufferKey must be packed 32-bit fields");
+  // FNV-1a over the packed 32-bit fields
+  uint32_t words[sizeof(FramebufferKey) / sizeof(uint32_t)];
+  memcpy(words, &key, sizeof(words));
+  uint64_t hash = 14695981039346656037ull;
+  for (uint32_t word : words) {
+    hash = (hash ^ word) * 1099511628211ull;
+  }
+  return (size_t)hash;
+}
+
 FramebufferFactory::FramebufferFactory() {}
 
 FramebufferFactory::~FramebufferFactory() {
@@ -21,74 +103,177 @@ std::shared_ptr<GPUPixelFramebuffer> FramebufferFactory::CreateFramebuffer(
     int height,
     bool only_texture /* = false*/,
     const TextureAttributes texture_attributes /* = defaultTextureAttribure*/) {
-  std::shared_ptr<GPUPixelFramebuffer> framebuffer_from_cache;
-  std::string lookup_hash =
-      GenerateUuid(width, height, only_texture, texture_attributes);
-  int number_of_matching_framebuffers = 0;
-  if (framebuffer_type_counts_.find(lookup_hash) !=
-      framebuffer_type_counts_.end()) {
-    number_of_matching_framebuffers = framebuffer_type_counts_[lookup_hash];
-  }
-  if (number_of_matching_framebuffers < 1) {
-    framebuffer_from_cache =
-        std::shared_ptr<GPUPixelFramebuffer>(new GPUPixelFramebuffer(
-            width, height, only_texture, texture_attributes));
-  } else {
-    int cur_framebuffer_id = number_of_matching_framebuffers - 1;
-    while (!framebuffer_from_cache && cur_framebuffer_id >= 0) {
-      std::string framebuffer_hash =
-          Util::StringFormat("%s-%ld", lookup_hash.c_str(), cur_framebuffer_id);
-      if (framebuffers_.find(framebuffer_hash) != framebuffers_.end()) {
-        framebuffer_from_cache = framebuffers_[framebuffer_hash];
-        framebuffers_.erase(framebuffer_hash);
-      } else {
-        framebuffer_from_cache = 0;
+  FramebufferKey key =
+      FramebufferKey::Make(width, height, only_texture, texture_attributes);
+  auto itr = framebuffers_.find(key);
+  if (itr != framebuffers_.end()) {
+    for (auto& entry : itr->second) {
+      if (entry.IsIdle()) {
+        ++hits_;
+        entry.last_used = ++use_tick_;
+        return entry.framebuffer;
       }
-      cur_framebuffer_id--;
     }
-    cur_framebuffer_id++;
-    framebuffer_type_counts_[lookup_hash] = cur_framebuffer_id;
+  }
+
+  ++misses_;
+  size_t bytes = GetTextureBytes(width, height, texture_attributes);
+  if (memory_budget_ > 0 && total_bytes_ + bytes > memory_budget_) {
+    Trim(memory_budget_ > bytes ? memory_budget_ - bytes : 0);
+  }
 
-    if (!framebuffer_from_cache) {
-      framebuffer_from_cache =
-          std::shared_ptr<GPUPixelFramebuffer>(new GPUPixelFramebuffer(
-              width, height, only_texture, texture_attributes));
+  // Eviction may have dropped the key, so look it up again
+  Entries& entries = framebuffers_[key];
+  entries.push_back(
+      {std::shared_ptr<GPUPixelFramebuffer>(new GPUPixelFramebuffer(
+           width, height, only_texture, texture_attributes)),
+       bytes, ++use_tick_});
+  total_bytes_ += bytes;
+  return entries.back().framebuffer;
+}
+
+void FramebufferFactory::RemoveFramebuffer(
+    const std::shared_ptr<GPUPixelFramebuffer>& framebuffer) {
+  if (!framebuffer) {
+    return;
+  }
+  FramebufferKey key = FramebufferKey::Make(
+      framebuffer->GetWidth(), framebuffer->GetHeight(),
+      !framebuffer->HasFramebuffer(), framebuffer->GetTextureAttributes());
+  auto itr = framebuffers_.find(key);
+  if (itr == framebuffers_.end()) {
+    return;
+  }
+  Entries& entries = itr->second;
+  for (auto entry = entries.begin(); entry != entries.end(); ++entry) {
+    if (entry->framebuffer == framebuffer) {
+      total_bytes_ -= entry->bytes;
+      entries.erase(entry);
+      break;
     }
   }
+  if (entries.empty()) {
+    framebuffers_.erase(itr);
+  }
+}
 
-  return framebuffer_from_cache;
+void FramebufferFactory::SetMemoryBudget(size_t bytes) {
+  memory_budget_ = bytes;
+  if (memory_budget_ > 0 && total_bytes_ > memory_budget_) {
+    Trim(memory_budget_);
+  }
 }
 
-std::string FramebufferFactory::GenerateUuid(
-    int width,
-    int height,
-    bool only_texture,
-    const TextureAttributes texture_attributes) const {
-  if (only_texture) {
-    return Util::StringFormat(
-        "%.1dx%.1d-%d:%d:%d:%d:%d:%d:%d-NOFB", width, height,
-        texture_attributes.minFilter, texture_attributes.magFilter,
-        texture_attributes.wrapS, texture_attributes.wrapT,
-        texture_attributes.internalFormat, texture_attributes.format,
-        texture_attributes.type);
-  } else {
-    return Util::StringFormat(
-        "%.1dx%.1d-%d:%d:%d:%d:%d:%d:%d", width, height,
-        texture_attributes.minFilter, texture_attributes.magFilter,
-        texture_attributes.wrapS, texture_attributes.wrapT,
-        texture_attributes.internalFormat, texture_attributes.format,
-        texture_attributes.type);
+size_t FramebufferFactory::Trim(size_t target_bytes) {
+  if (total_bytes_ <= target_bytes) {
+    return 0;
+  }
+
+  struct Candidate {
+    uint64_t last_used;
+    const FramebufferKey* key;
+  };
+  std::vector<Candidate> candidates;
+  for (const auto& itr : framebuffers_) {
+    for (const auto& entry : itr.second) {
+      if (entry.IsIdle()) {
+        candidates.push_back({entry.last_used, &itr.first});
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& a, const Candidate& b) {
+              return a.last_used < b.last_used;
+            });
+
+  // Keys stay valid while evicting since empty keys are only erased at the end
+  size_t freed = 0;
+  for (const auto& candidate : candidates) {
+    if (total_bytes_ <= target_bytes) {
+      break;
+    }
+    Entries& entries = framebuffers_.find(*candidate.key)->second;
+    for (auto entry = entries.begin(); entry != entries.end(); ++entry) {
+      if (entry->last_used == candidate.last_used) {
+        freed += entry->bytes;
+        total_bytes_ -= entry->bytes;
+        ++evictions_;
+        entries.erase(entry);
+        break;
+      }
+    }
+  }
+
+  for (auto itr = framebuffers_.begin(); itr != framebuffers_.end();) {
+    itr = itr->second.empty() ? framebuffers_.erase(itr) : std::next(itr);
+  }
+  return freed;
+}
+
+std::vector<FramebufferMemoryUsage> FramebufferFactory::GetMemoryUsage()
+    const {
+  std::vector<FramebufferMemoryUsage> usages;
+  for (const auto& itr : framebuffers_) {
+    auto usage = std::find_if(
+        usages.begin(), usages.end(), [&](const FramebufferMemoryUsage& u) {
+          return u.internal_format == itr.first.internal_format &&
+                 u.type == itr.first.type;
+        });
+    if (usage == usages.end()) {
+      usages.emplace_back();
+      usage = usages.end() - 1;
+      usage->internal_format = itr.first.internal_format;
+      usage->type = itr.first.type;
+    }
+    for (const auto& entry : itr.second) {
+      if (entry.IsIdle()) {
+        usage->pooled_bytes += entry.bytes;
+        ++usage->pooled_count;
+      } else {
+        usage->live_bytes += entry.bytes;
+        ++usage->live_count;
+      }
+    }
   }
+  return usages;
 }
 
-std::shared_ptr<GPUPixelFramebuffer> FramebufferFactory::GetFramebufferByUuid(
-    const std::string& hash) {
-  return framebuffers_[hash];
+FramebufferPoolStats FramebufferFactory::GetStats() const {
+  FramebufferPoolStats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.evictions = evictions_;
+  for (const auto& itr : framebuffers_) {
+    for (const auto& entry : itr.second) {
+      if (entry.IsIdle()) {
+        ++stats.idle;
+      } else {
+        ++stats.in_use;
+      }
+    }
+  }
+  return stats;
+}
+
+void FramebufferFactory::ResetStats() {
+  hits_ = 0;
+  misses_ = 0;
+  evictions_ = 0;
 }
 
 void FramebufferFactory::Clean() {
+  // Leased framebuffers stay alive with their holders, they are just no longer
+  // pooled
   framebuffers_.clear();
-  framebuffer_type_counts_.clear();
+  total_bytes_ = 0;
+}
+
+size_t FramebufferFactory::GetTextureBytes(
+    int width,
+    int height,
+    const TextureAttributes& texture_attributes) {
+  return (size_t)width * height *
+         BytesPerPixel(texture_attributes.format, texture_attributes.type);
 }
 
 }  // namespace gpupixel
@@ -7,16 +7,75 @@
 
 #pragma once
 
-#include <map>
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "core/gpupixel_framebuffer.h"
 #include "gpupixel/gpupixel_define.h"
 
 namespace gpupixel {
+
+// Identifies interchangeable framebuffers: same size, texture attributes and
+// whether an FBO is attached
+struct FramebufferKey {
+  int32_t width;
+  int32_t height;
+  uint32_t min_filter;
+  uint32_t mag_filter;
+  uint32_t wrap_s;
+  uint32_t wrap_t;
+  uint32_t internal_format;
+  uint32_t format;
+  uint32_t type;
+  uint32_t only_texture;
+
+  static FramebufferKey Make(int width,
+                             int height,
+                             bool only_texture,
+                             const TextureAttributes& texture_attributes);
+
+  bool operator==(const FramebufferKey& other) const;
+};
+
+struct FramebufferKeyHash {
+  size_t operator()(const FramebufferKey& key) const;
+};
+
+struct FramebufferPoolStats {
+  // Requests served from / not served from the pool since the last reset
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // Idle framebuffers freed to stay within the memory budget
+  uint64_t evictions = 0;
+  // Pooled framebuffers currently leased out / idle
+  size_t in_use = 0;
+  size_t idle = 0;
+};
+
+// Texture memory of the pool for one internal format / pixel type pair.
+// Live framebuffers are leased out, pooled ones are idle and can be evicted.
+struct FramebufferMemoryUsage {
+  uint32_t internal_format = 0;
+  uint32_t type = 0;
+  size_t live_bytes = 0;
+  size_t pooled_bytes = 0;
+  size_t live_count = 0;
+  size_t pooled_count = 0;
+};
+
+// Per-context framebuffer pool; only used on the owning context's thread
 class GPUPIXEL_API FramebufferFactory {
  public:
   FramebufferFactory();
   ~FramebufferFactory();
+
+  // Leases a framebuffer matching the request. The pool keeps a reference to
+  // every framebuffer it hands out; once all other references are dropped the
+  // framebuffer is idle and the next matching request reuses it. Reuse does
+  // not allocate once the key has been seen. Allocating a new one first evicts
+  // least recently used idle framebuffers to stay within the memory budget.
   std::shared_ptr<GPUPixelFramebuffer> CreateFramebuffer(
       int width,
       int height,
@@ -24,18 +83,51 @@ class GPUPIXEL_API FramebufferFactory {
       const TextureAttributes texture_attributes =
           GPUPixelFramebuffer::default_texture_attributes);
 
+  // Stops pooling framebuffer, so its GL objects are freed together with the
+  // last outside reference instead of being kept for reuse
+  void RemoveFramebuffer(const std::shared_ptr<GPUPixelFramebuffer>& framebuffer);
+
+  // Soft limit on texture bytes owned by the pool, 0 means unlimited. Leased
+  // framebuffers are never evicted, so live usage alone may exceed it.
+  void SetMemoryBudget(size_t bytes);
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  // Frees least recently used idle framebuffers until the pool owns at most
+  // target_bytes; returns the number of bytes freed
+  size_t Trim(size_t target_bytes);
+
+  // Texture bytes owned by the pool, leased and idle
+  size_t GetTotalBytes() const { return total_bytes_; }
+  std::vector<FramebufferMemoryUsage> GetMemoryUsage() const;
+
+  FramebufferPoolStats GetStats() const;
+  void ResetStats();
+
   void Clean();
 
+  static size_t GetTextureBytes(int width,
+                                int height,
+                                const TextureAttributes& texture_attributes);
+
  private:
-  std::string GenerateUuid(int width,
-                           int height,
-                           bool only_texture,
-                           const TextureAttributes texture_attributes) const;
-  std::shared_ptr<GPUPixelFramebuffer> GetFramebufferByUuid(
-      const std::string& hash);
-
-  std::map<std::string, std::shared_ptr<GPUPixelFramebuffer>> framebuffers_;
-  std::map<std::string, int> framebuffer_type_counts_;
+  struct Entry {
+    std::shared_ptr<GPUPixelFramebuffer> framebuffer;
+    size_t bytes;
+    uint64_t last_used;
+
+    // Only the pool holds it, so every previous lease has ended
+    bool IsIdle() const { return framebuffer.use_count() == 1; }
+  };
+  using Entries = std::vector<Entry>;
+
+  std::unordered_map<FramebufferKey, Entries, FramebufferKeyHash>
+      framebuffers_;
+  size_t memory_budget_ = 0;
+  size_t total_bytes_ = 0;
+  uint64_t use_tick_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  uint64_t evictions_ = 0;
 };
 
 }  // namespace gpupixel
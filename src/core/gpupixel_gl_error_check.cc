@@ -0,0 +1,260 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "core/gpupixel_gl_error_check.h"
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_gl_include.h"
+#include "utils/logging.h"
+#include "utils/util.h"
+
+// Set by CMake from GPUPIXEL_GL_ERROR_CHECK; follows the build type otherwise
+#ifndef GPUPIXEL_GL_ERROR_CHECK_DEFAULT
+#if defined(NDEBUG)
+#define GPUPIXEL_GL_ERROR_CHECK_DEFAULT GPUPIXEL_GL_ERROR_CHECK_OFF
+#else
+#define GPUPIXEL_GL_ERROR_CHECK_DEFAULT GPUPIXEL_GL_ERROR_CHECK_DEBUG
+#endif
+#endif
+
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#endif
+#ifndef GL_DEBUG_OUTPUT_SYNCHRONOUS
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#endif
+#ifndef GL_DEBUG_TYPE_ERROR
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#endif
+#ifndef GL_DEBUG_SEVERITY_HIGH
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#endif
+#ifndef GL_DEBUG_SEVERITY_MEDIUM
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#endif
+#ifndef GL_DEBUG_SEVERITY_LOW
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#endif
+
+// KHR_debug is resolved at runtime where the GL loader can look it up; Apple
+// GL and WebGL have no debug output and always poll in DEBUG mode
+#if defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+#define GPUPIXEL_GL_HAS_DEBUG_OUTPUT 1
+#define GPUPIXEL_GL_APIENTRY APIENTRY
+#elif defined(GPUPIXEL_ANDROID)
+#define GPUPIXEL_GL_HAS_DEBUG_OUTPUT 1
+#define GPUPIXEL_GL_APIENTRY GL_APIENTRY
+#else
+#define GPUPIXEL_GL_HAS_DEBUG_OUTPUT 0
+#endif
+
+namespace gpupixel {
+
+namespace {
+
+// Bounds the drain; a lost context may report an error on every call
+constexpr int kMaxDrainedErrors = 8;
+
+const char* ErrorString(GLenum error) {
+  switch (error) {
+    case GL_INVALID_ENUM:
+      return "GL_INVALID_ENUM";
+    case GL_INVALID_VALUE:
+      return "GL_INVALID_VALUE";
+    case GL_INVALID_OPERATION:
+      return "GL_INVALID_OPERATION";
+    case GL_OUT_OF_MEMORY:
+      return "GL_OUT_OF_MEMORY";
+    default:
+      return "Unknown GL Error";
+  }
+}
+
+#if GPUPIXEL_GL_HAS_DEBUG_OUTPUT
+typedef void(GPUPIXEL_GL_APIENTRY* DebugProc)(GLenum source,
+                                              GLenum type,
+                                              GLuint id,
+                                              GLenum severity,
+                                              GLsizei length,
+                                              const GLchar* message,
+                                              const void* user_param);
+typedef void(GPUPIXEL_GL_APIENTRY* DebugMessageCallbackProc)(
+    DebugProc callback,
+    const void* user_param);
+
+void GPUPIXEL_GL_APIENTRY OnDebugMessage(GLenum source,
+                                         GLenum type,
+                                         GLuint id,
+                                         GLenum severity,
+                                         GLsizei length,
+                                         const GLchar* message,
+                                         const void* user_param) {
+  // Notifications are informational and frequent, so they are dropped
+  std::string text =
+      Util::StringFormat("GL DEBUG: 0x%04X MSG: %s", id, message);
+  if (type == GL_DEBUG_TYPE_ERROR || severity == GL_DEBUG_SEVERITY_HIGH) {
+    LOG_ERROR("{}", text);
+  } else if (severity == GL_DEBUG_SEVERITY_MEDIUM) {
+    LOG_WARN("{}", text);
+  } else if (severity == GL_DEBUG_SEVERITY_LOW) {
+    LOG_DEBUG("{}", text);
+  }
+}
+
+// Returns nullptr unless the current context supports KHR_debug
+DebugMessageCallbackProc GetDebugMessageCallback() {
+  if (!GPUPixelContext::GetInstance()->HasGLExtension("GL_KHR_debug")) {
+    return nullptr;
+  }
+#if defined(GPUPIXEL_LINUX_HEADLESS) || defined(GPUPIXEL_ANDROID)
+  auto load = [](const char* name) { return (void*)eglGetProcAddress(name); };
+#else
+  auto load = [](const char* name) { return (void*)glfwGetProcAddress(name); };
+#endif
+  // GLES names the extension functions with a KHR suffix, desktop GL does not
+  void* function = load("glDebugMessageCallback");
+  if (!function) {
+    function = load("glDebugMessageCallbackKHR");
+  }
+  return (DebugMessageCallbackProc)function;
+}
+#endif
+
+}  // namespace
+
+std::atomic<int> GLErrorCheck::mode_{GPUPIXEL_GL_ERROR_CHECK_DEFAULT};
+std::atomic<int> GLErrorCheck::sample_interval_{1};
+std::atomic<int> GLErrorCheck::polling_contexts_{0};
+std::atomic<bool> GLErrorCheck::debug_output_allowed_{true};
+
+GLErrorCheck::~GLErrorCheck() {
+  SetPolling(false);
+}
+
+void GLErrorCheck::SetMode(GPUPIXEL_GL_ERROR_CHECK mode, int sample_interval) {
+  sample_interval_ = sample_interval > 0 ? sample_interval : 1;
+  mode_ = mode;
+}
+
+GPUPIXEL_GL_ERROR_CHECK GLErrorCheck::GetMode() {
+  return (GPUPIXEL_GL_ERROR_CHECK)mode_.load();
+}
+
+void GLErrorCheck::SetDebugOutputAllowed(bool allowed) {
+  debug_output_allowed_ = allowed;
+}
+
+void GLErrorCheck::CheckCall(const char* file, const char* function, int line) {
+  GLenum error = glGetError();
+  if (error != GL_NO_ERROR) {
+    LOG_ERROR("{}", Util::StringFormat("[%s %s:%d] GL ERROR: 0x%04X MSG: %s",
+                                       file, function, line, error,
+                                       ErrorString(error)));
+  }
+}
+
+void GLErrorCheck::CheckPending(const char* file,
+                                const char* function,
+                                int line) {
+  bool report =
+      mode_.load(std::memory_order_relaxed) != GPUPIXEL_GL_ERROR_CHECK_OFF;
+  for (int i = 0; i < kMaxDrainedErrors; ++i) {
+    GLenum error = glGetError();
+    if (error == GL_NO_ERROR) {
+      break;
+    }
+    if (report) {
+      LOG_ERROR("{}", Util::StringFormat(
+                          "[%s %s:%d] GL ERROR: 0x%04X MSG: %s before the call",
+                          file, function, line, error, ErrorString(error)));
+    }
+  }
+}
+
+void GLErrorCheck::ClearPending() {
+  for (int i = 0; i < kMaxDrainedErrors; ++i) {
+    if (glGetError() == GL_NO_ERROR) {
+      break;
+    }
+  }
+}
+
+void GLErrorCheck::Apply() {
+  int mode = mode_.load(std::memory_order_relaxed);
+  bool debug_output_allowed =
+      debug_output_allowed_.load(std::memory_order_relaxed);
+  if (mode == applied_mode_ &&
+      debug_output_allowed == applied_debug_output_allowed_) {
+    return;
+  }
+  applied_mode_ = mode;
+  applied_debug_output_allowed_ = debug_output_allowed;
+  frames_ = 0;
+
+  bool debug = mode == GPUPIXEL_GL_ERROR_CHECK_DEBUG;
+  bool debug_output = SetDebugOutput(debug && debug_output_allowed);
+  SetPolling(debug && !debug_output);
+  if (debug && !debug_output) {
+    LOG_DEBUG("GLErrorCheck: checking after every GL call");
+  }
+}
+
+void GLErrorCheck::OnFrameEnd() {
+  Apply();
+  if (applied_mode_ != GPUPIXEL_GL_ERROR_CHECK_SAMPLED) {
+    return;
+  }
+  int interval = sample_interval_.load(std::memory_order_relaxed);
+  if (++frames_ % interval != 0) {
+    return;
+  }
+  // Error flags stay set until read, so this also finds errors raised in the
+  // frames that were not sampled
+  for (int i = 0; i < kMaxDrainedErrors; ++i) {
+    GLenum error = glGetError();
+    if (error == GL_NO_ERROR) {
+      break;
+    }
+    LOG_ERROR("{}", Util::StringFormat(
+                        "GL ERROR: 0x%04X MSG: %s within the last %d frame(s)",
+                        error, ErrorString(error), interval));
+  }
+}
+
+void GLErrorCheck::SetPolling(bool polling) {
+  if (polling == polling_) {
+    return;
+  }
+  polling_ = polling;
+  polling_contexts_ += polling ? 1 : -1;
+}
+
+bool GLErrorCheck::SetDebugOutput(bool enabled) {
+  if (enabled == debug_output_) {
+    return debug_output_;
+  }
+#if GPUPIXEL_GL_HAS_DEBUG_OUTPUT
+  DebugMessageCallbackProc set_callback = GetDebugMessageCallback();
+  if (!set_callback) {
+    return debug_output_;
+  }
+  if (enabled) {
+    // Synchronous, so that the callback runs inside the offending call and a
+    // breakpoint in it shows the caller
+    set_callback(OnDebugMessage, nullptr);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glEnable(GL_DEBUG_OUTPUT);
+  } else {
+    glDisable(GL_DEBUG_OUTPUT);
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    set_callback(nullptr, nullptr);
+  }
+  debug_output_ = enabled;
+#endif
+  return debug_output_;
+}
+
+}  // namespace gpupixel
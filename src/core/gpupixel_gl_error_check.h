@@ -0,0 +1,67 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+
+// Reports GL errors of one context according to the process-wide check mode
+// (see GPUPixel::SetGLErrorCheck):
+//   OFF      nothing is checked, GL_CALL is just the call
+//   SAMPLED  the error flags are drained once at the end of every Nth frame,
+//            which finds errors without naming the call that raised them
+//   DEBUG    the driver reports errors as they happen through a KHR_debug
+//            callback; without KHR_debug, GL_CALL polls glGetError instead
+// Instances must be used on their context's thread.
+class GPUPIXEL_API GLErrorCheck {
+ public:
+  ~GLErrorCheck();
+
+  static void SetMode(GPUPIXEL_GL_ERROR_CHECK mode, int sample_interval);
+  static GPUPIXEL_GL_ERROR_CHECK GetMode();
+  // With KHR_debug disallowed, DEBUG mode checks after every GL_CALL even
+  // where the driver has debug output, which names the GL_CALL site of each
+  // error in the log
+  static void SetDebugOutputAllowed(bool allowed);
+
+  // True while some context checks after every GL_CALL
+  static bool IsPolling() {
+    return polling_contexts_.load(std::memory_order_relaxed) > 0;
+  }
+  static void CheckCall(const char* file, const char* function, int line);
+  // Around a call whose errors are expected: CheckPending reports the errors
+  // raised before it unless the mode is OFF, ClearPending then drops the
+  // call's own
+  static void CheckPending(const char* file, const char* function, int line);
+  static void ClearPending();
+
+  // Brings the current GL context in line with the process-wide mode
+  void Apply();
+  // Called after every frame the context has rendered
+  void OnFrameEnd();
+
+ private:
+  void SetPolling(bool polling);
+  bool SetDebugOutput(bool enabled);
+
+  static std::atomic<int> mode_;
+  static std::atomic<int> sample_interval_;
+  static std::atomic<int> polling_contexts_;
+  static std::atomic<bool> debug_output_allowed_;
+
+  int applied_mode_ = -1;
+  bool applied_debug_output_allowed_ = false;
+  bool polling_ = false;
+  bool debug_output_ = false;
+  uint64_t frames_ = 0;
+};
+
+}  // namespace gpupixel
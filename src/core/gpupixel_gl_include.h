@@ -27,8 +27,14 @@
 #elif defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
 // clang-format off
 #include <glad/glad.h>
+#if defined(GPUPIXEL_LINUX_HEADLESS)
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
 #define GLEW_STATIC
 #include <GLFW/glfw3.h>
+#endif
 // clang-format on
 #elif defined(GPUPIXEL_WASM)
 #include <GLES3/gl3.h>
@@ -36,33 +42,24 @@
 #include <emscripten/html5.h>
 #endif
 
-// clang-format off
-//------------- ENABLE_GL_CHECK Begin ------------ //
-#if defined(NDEBUG)
-#define GPUPIXEL_OPENGL_DEBUG false
+#include "core/gpupixel_gl_error_check.h"
+
+// Mappable pixel buffers and fence syncs, GL 3.2 and GLES 3.0 API. Apple
+// desktop GL stops at 2.1 and WebGL 2 cannot map buffers. Whether the context
+// has them is up to GPUPixelContext::SupportsPixelBuffers.
+#if defined(GL_MAP_WRITE_BIT) && defined(GL_SYNC_GPU_COMMANDS_COMPLETE) && \
+    !defined(GPUPIXEL_WASM)
+#define GPUPIXEL_GL_HAS_PIXEL_BUFFERS 1
 #else
-#define GPUPIXEL_OPENGL_DEBUG true
+#define GPUPIXEL_GL_HAS_PIXEL_BUFFERS 0
 #endif
 
-#if GPUPIXEL_OPENGL_DEBUG
-#define GL_CALL(_CALL)                                                          \
-  do {                                                                          \
-    _CALL;                                                                      \
-    GLenum e = glGetError();                                                    \
-    if (e != 0) {                                                               \
-      std::string errorString;                                                  \
-      switch (e) {                                                              \
-        case GL_INVALID_ENUM:      errorString = "GL_INVALID_ENUM";      break; \
-        case GL_INVALID_VALUE:     errorString = "GL_INVALID_VALUE";     break; \
-        case GL_INVALID_OPERATION: errorString = "GL_INVALID_OPERATION"; break; \
-        case GL_OUT_OF_MEMORY:    errorString = "GL_OUT_OF_MEMORY";     break;  \
-        default:                  errorString = "Unknown GL Error";     break;  \
-      }                                                                         \
-      LOG_ERROR("[{} {}:{}] GL ERROR: 0x{:04X} MSG: {}", __FILE__,              \
-                __FUNCTION__, __LINE__, e, errorString.c_str());                \
-    }                                                                           \
+// Checks for errors after the call only while the GL error check polls, see
+// GLErrorCheck; in every other mode the cost is one relaxed atomic load
+#define GL_CALL(_CALL)                                                     \
+  do {                                                                     \
+    _CALL;                                                                 \
+    if (gpupixel::GLErrorCheck::IsPolling()) {                             \
+      gpupixel::GLErrorCheck::CheckCall(__FILE__, __FUNCTION__, __LINE__); \
+    }                                                                      \
   } while (0)
-#else
-#define GL_CALL(_CALL) do { _CALL; } while (0)
-#endif
-// clang-format on
@@ -0,0 +1,311 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "core/gpupixel_profiler.h"
+#include <algorithm>
+#include <typeinfo>
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_gl_include.h"
+#include "gpupixel/filter/filter.h"
+#include "gpupixel/source/source.h"
+#include "utils/util.h"
+
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+// Desktop GL has timer queries from 3.3 / ARB_timer_query, GLES through
+// EXT_disjoint_timer_query, whose functions carry an EXT suffix and are
+// resolved at runtime. Apple GL and WebGL are profiled on the CPU only.
+#if defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+#define GPUPIXEL_GL_HAS_TIMER_QUERY 1
+#define GPUPIXEL_GL_APIENTRY APIENTRY
+#elif defined(GPUPIXEL_ANDROID)
+#define GPUPIXEL_GL_HAS_TIMER_QUERY 1
+#define GPUPIXEL_GL_APIENTRY GL_APIENTRY
+#else
+#define GPUPIXEL_GL_HAS_TIMER_QUERY 0
+#define GPUPIXEL_GL_APIENTRY
+#endif
+
+namespace gpupixel {
+
+namespace {
+
+// Queries waiting for their result; passes beyond this go untimed on the GPU
+// rather than letting a stalled GPU pile them up
+constexpr size_t kMaxPendingQueries = 512;
+
+// Nodes not timed for this many frames are dropped, so that nodes destroyed
+// while profiling, such as the fused filters of a recompiled pipeline, do not
+// accumulate
+constexpr uint64_t kIdleFrames = 256;
+
+std::string NodeName(const Source* node) {
+  auto filter = dynamic_cast<const Filter*>(node);
+  if (filter && !filter->GetFilterClassName().empty()) {
+    return filter->GetFilterClassName();
+  }
+  return Util::DemangleTypeName(typeid(*node).name());
+}
+
+void Summarize(const float* values,
+               int count,
+               int* samples,
+               double* min_ms,
+               double* avg_ms,
+               double* p99_ms) {
+  *samples = count;
+  if (count == 0) {
+    return;
+  }
+  std::vector<float> sorted(values, values + count);
+  std::sort(sorted.begin(), sorted.end());
+  double sum = 0;
+  for (float value : sorted) {
+    sum += value;
+  }
+  *min_ms = sorted.front();
+  *avg_ms = sum / count;
+  *p99_ms = sorted[(count * 99 + 99) / 100 - 1];
+}
+
+}  // namespace
+
+struct Profiler::TimerQueryFunctions {
+  void(GPUPIXEL_GL_APIENTRY* gen_queries)(GLsizei n, GLuint* ids) = nullptr;
+  void(GPUPIXEL_GL_APIENTRY* begin_query)(GLenum target, GLuint id) = nullptr;
+  void(GPUPIXEL_GL_APIENTRY* end_query)(GLenum target) = nullptr;
+  void(GPUPIXEL_GL_APIENTRY* get_query_objectuiv)(GLuint id,
+                                                  GLenum pname,
+                                                  GLuint* params) = nullptr;
+};
+
+#if GPUPIXEL_GL_HAS_TIMER_QUERY
+namespace {
+
+// False if the context has no timer queries
+bool LoadTimerQueryFunctions(Profiler::TimerQueryFunctions* functions) {
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  if (context->IsGLES()) {
+    if (!context->HasGLExtension("GL_EXT_disjoint_timer_query")) {
+      return false;
+    }
+#if defined(GPUPIXEL_LINUX_HEADLESS) || defined(GPUPIXEL_ANDROID)
+    auto load = [](const char* name) { return (void*)eglGetProcAddress(name); };
+#else
+    auto load = [](const char* name) {
+      return (void*)glfwGetProcAddress(name);
+    };
+#endif
+    functions->gen_queries =
+        (decltype(functions->gen_queries))load("glGenQueriesEXT");
+    functions->begin_query =
+        (decltype(functions->begin_query))load("glBeginQueryEXT");
+    functions->end_query =
+        (decltype(functions->end_query))load("glEndQueryEXT");
+    functions->get_query_objectuiv =
+        (decltype(functions->get_query_objectuiv))load(
+            "glGetQueryObjectuivEXT");
+  } else {
+#if defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+    int major = context->GetGLMajorVersion();
+    int minor = context->GetGLMinorVersion();
+    if ((major < 3 || (major == 3 && minor < 3)) &&
+        !context->HasGLExtension("GL_ARB_timer_query") &&
+        !context->HasGLExtension("GL_EXT_timer_query")) {
+      return false;
+    }
+    functions->gen_queries = glGenQueries;
+    functions->begin_query = glBeginQuery;
+    functions->end_query = glEndQuery;
+    functions->get_query_objectuiv = glGetQueryObjectuiv;
+#endif
+  }
+  return functions->gen_queries && functions->begin_query &&
+         functions->end_query && functions->get_query_objectuiv;
+}
+
+}  // namespace
+#endif
+
+std::atomic<bool> Profiler::enabled_{false};
+
+Profiler::Profiler() = default;
+
+Profiler::~Profiler() = default;
+
+void Profiler::SetEnabled(bool enabled) {
+  enabled_ = enabled;
+}
+
+void Profiler::Samples::Add(float value) {
+  values[next] = value;
+  next = (next + 1) % kWindow;
+  count = std::min(count + 1, kWindow);
+}
+
+void Profiler::Begin(const Source* node) {
+  open_node_ = node;
+  open_node_id_ = node->GetNodeId();
+  open_type_name_ = typeid(*node).name();
+  open_profiled_ = IsEnabled();
+  open_query_ = 0;
+  if (open_profiled_) {
+    auto it = entry_index_.find(open_node_id_);
+    if (it == entry_index_.end()) {
+      it = entry_index_.emplace(open_node_id_, entries_.size()).first;
+      entries_.emplace_back();
+      entries_.back().profile.node_id = open_node_id_;
+      entries_.back().profile.name = NodeName(node);
+    }
+    entries_[it->second].last_frame = frames_;
+#if GPUPIXEL_GL_HAS_TIMER_QUERY
+    if (HasGpuTimer() && pending_queries_.size() < kMaxPendingQueries) {
+      if (free_queries_.empty()) {
+        GLuint query = 0;
+        GL_CALL(timer_->gen_queries(1, &query));
+        free_queries_.push_back(query);
+      }
+      open_query_ = free_queries_.back();
+      free_queries_.pop_back();
+      GL_CALL(timer_->begin_query(GL_TIME_ELAPSED, open_query_));
+    }
+#endif
+  }
+  open_start_ns_ = Trace::Now();
+}
+
+void Profiler::End() {
+  uint64_t end_ns = Trace::Now();
+  if (open_profiled_) {
+    // The node is gone from the index if Reset ran during the pass
+    auto it = entry_index_.find(open_node_id_);
+    if (it != entry_index_.end()) {
+      entries_[it->second].cpu.Add((end_ns - open_start_ns_) / 1e6f);
+    }
+#if GPUPIXEL_GL_HAS_TIMER_QUERY
+    if (open_query_) {
+      GL_CALL(timer_->end_query(GL_TIME_ELAPSED));
+      pending_queries_.push_back({open_node_id_, open_query_});
+    }
+#endif
+  }
+  Trace::AddEvent(open_type_name_, "pass", open_start_ns_, end_ns,
+                  open_node_id_, true);
+  open_node_ = nullptr;
+  open_node_id_ = 0;
+  open_query_ = 0;
+}
+
+void Profiler::OnFrameEnd() {
+  if (++frames_ % kIdleFrames == 0) {
+    DropIdleEntries();
+  }
+#if GPUPIXEL_GL_HAS_TIMER_QUERY
+  if (pending_queries_.empty()) {
+    return;
+  }
+  // A disjoint event, e.g. a frequency change, makes the pending results
+  // meaningless; reading the flag also clears it
+  GLint disjoint = 0;
+  if (GPUPixelContext::GetInstance()->IsGLES()) {
+    GL_CALL(glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint));
+  }
+  // Queries finish in the order they were issued
+  while (!pending_queries_.empty()) {
+    PendingQuery pending = pending_queries_.front();
+    GLuint available = GL_FALSE;
+    GL_CALL(timer_->get_query_objectuiv(
+        pending.query, GL_QUERY_RESULT_AVAILABLE, &available));
+    if (!available && !disjoint) {
+      break;
+    }
+    pending_queries_.pop_front();
+    free_queries_.push_back(pending.query);
+    if (disjoint) {
+      continue;
+    }
+    // Nanoseconds; a pass longer than 4 s overflows, which is not a
+    // concern for a single draw
+    GLuint elapsed = 0;
+    GL_CALL(
+        timer_->get_query_objectuiv(pending.query, GL_QUERY_RESULT, &elapsed));
+    auto it = entry_index_.find(pending.node_id);
+    if (it != entry_index_.end()) {
+      entries_[it->second].gpu.Add(elapsed / 1e6f);
+    }
+  }
+#endif
+}
+
+std::vector<FilterProfile> Profiler::GetProfile() const {
+  std::vector<FilterProfile> profiles;
+  profiles.reserve(entries_.size());
+  for (const Entry& entry : entries_) {
+    FilterProfile profile = entry.profile;
+    Summarize(entry.cpu.values, entry.cpu.count, &profile.cpu_samples,
+              &profile.cpu_min_ms, &profile.cpu_avg_ms, &profile.cpu_p99_ms);
+    Summarize(entry.gpu.values, entry.gpu.count, &profile.gpu_samples,
+              &profile.gpu_min_ms, &profile.gpu_avg_ms, &profile.gpu_p99_ms);
+    profiles.push_back(profile);
+  }
+  return profiles;
+}
+
+void Profiler::Reset() {
+  // Results of pending queries and of an open pass are dropped
+  entries_.clear();
+  entry_index_.clear();
+}
+
+void Profiler::DropIdleEntries() {
+  size_t kept = 0;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (frames_ - entries_[i].last_frame > kIdleFrames) {
+      continue;
+    }
+    if (kept != i) {
+      entries_[kept] = std::move(entries_[i]);
+    }
+    ++kept;
+  }
+  if (kept == entries_.size()) {
+    return;
+  }
+  entries_.resize(kept);
+  entry_index_.clear();
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    entry_index_[entries_[i].profile.node_id] = i;
+  }
+}
+
+bool Profiler::HasGpuTimer() {
+#if GPUPIXEL_GL_HAS_TIMER_QUERY
+  if (!timer_checked_) {
+    timer_checked_ = true;
+    timer_.reset(new TimerQueryFunctions);
+    if (!LoadTimerQueryFunctions(timer_.get())) {
+      timer_.reset();
+    }
+  }
+  return timer_ != nullptr;
+#else
+  return false;
+#endif
+}
+
+}  // namespace gpupixel
@@ -0,0 +1,115 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "gpupixel/gpupixel_define.h"
+#include "gpupixel/utils/filter_profile.h"
+#include "utils/trace.h"
+
+namespace gpupixel {
+
+class Source;
+
+// Per-pass CPU and GPU timings of the filters and sources rendered on one
+// context, enabled process-wide with GPUPixel::SetProfilingEnabled. A pass
+// runs from BeginPass until its node hands the output to its sinks, so passes
+// never nest and each gets one GL_TIME_ELAPSED query. Query results are read
+// at the end of later frames, once the GPU has them, so reading never waits.
+// While tracing, every pass is also recorded as a trace event.
+// Must be used on the context's thread.
+class GPUPIXEL_API Profiler {
+ public:
+  // Samples kept per node for the statistics
+  static constexpr int kWindow = 128;
+
+  // GL entry points of the timer queries, which differ between desktop GL
+  // and GLES
+  struct TimerQueryFunctions;
+
+  Profiler();
+  ~Profiler();
+
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // A pass begun while another is open is not timed
+  void BeginPass(const Source* node) {
+    if ((IsEnabled() || Trace::IsEnabled()) && !open_node_) {
+      Begin(node);
+    }
+  }
+  // Ends the pass of node, if it has one open
+  void EndPass(const Source* node) {
+    if (open_node_ == node) {
+      End();
+    }
+  }
+  // Collects the query results that have become available
+  void OnFrameEnd();
+
+  // Nodes in the order they were first timed. Nodes that have not been timed
+  // for a few hundred frames, destroyed ones included, are dropped.
+  std::vector<FilterProfile> GetProfile() const;
+  void Reset();
+
+ private:
+  struct Samples {
+    float values[kWindow];
+    int count = 0;
+    int next = 0;
+
+    void Add(float value);
+  };
+
+  struct Entry {
+    FilterProfile profile;
+    Samples cpu;
+    Samples gpu;
+    // Frame in which the node was last timed
+    uint64_t last_frame = 0;
+  };
+
+  struct PendingQuery {
+    uint64_t node_id;
+    uint32_t query;
+  };
+
+  void Begin(const Source* node);
+  void End();
+  void DropIdleEntries();
+  bool HasGpuTimer();
+
+  static std::atomic<bool> enabled_;
+
+  std::vector<Entry> entries_;
+  std::unordered_map<uint64_t, size_t> entry_index_;
+
+  const Source* open_node_ = nullptr;
+  uint64_t open_node_id_ = 0;
+  // std::type_info::name() of the node, for the trace event
+  const char* open_type_name_ = nullptr;
+  bool open_profiled_ = false;
+  uint64_t open_start_ns_ = 0;
+  uint32_t open_query_ = 0;
+
+  uint64_t frames_ = 0;
+
+  bool timer_checked_ = false;
+  // Null without GPU timer queries
+  std::unique_ptr<TimerQueryFunctions> timer_;
+  std::deque<PendingQuery> pending_queries_;
+  std::vector<uint32_t> free_queries_;
+};
+
+}  // namespace gpupixel
@@ -6,42 +6,102 @@
  */
 
 #include "core/gpupixel_program.h"
-#include <algorithm>
+#include <cstring>
 #include "core/gpupixel_context.h"
+#include "core/gpupixel_program_cache.h"
 #include "utils/util.h"
 
 namespace gpupixel {
 
-std::vector<GPUPixelGLProgram*> GPUPixelGLProgram::programs_;
+namespace {
 
-GPUPixelGLProgram::GPUPixelGLProgram() : program_(-1) {
-  programs_.push_back(this);
+// FNV-1a over both sources, with the separator keeping "ab" + "c" apart from
+// "a" + "bc"
+uint64_t HashShaderSources(const std::string& vertex_shader_source,
+                           const std::string& fragment_shader_source) {
+  uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash](const std::string& source) {
+    for (unsigned char c : source) {
+      hash = (hash ^ c) * 1099511628211ull;
+    }
+    hash = (hash ^ 0xff) * 1099511628211ull;
+  };
+  mix(vertex_shader_source);
+  mix(fragment_shader_source);
+  return hash;
+}
+
+// GL reports unknown names as -1, so that is cached like any location
+constexpr GLint kLocationNotCached = -2;
+
+}  // namespace
+
+std::unordered_map<GPUPixelGLProgram::CacheKey,
+                   GPUPixelGLProgram::CacheEntry,
+                   GPUPixelGLProgram::CacheKeyHash>
+    GPUPixelGLProgram::programs_;
+std::mutex GPUPixelGLProgram::programs_mutex_;
+uint64_t GPUPixelGLProgram::cache_hits_ = 0;
+uint64_t GPUPixelGLProgram::cache_misses_ = 0;
+std::atomic<uint64_t> GPUPixelGLProgram::location_lookups_{0};
+std::atomic<uint64_t> GPUPixelGLProgram::uniform_uploads_{0};
+std::atomic<uint64_t> GPUPixelGLProgram::uniform_uploads_skipped_{0};
+
+size_t GPUPixelGLProgram::CacheKeyHash::operator()(const CacheKey& key) const {
+  return std::hash<uint64_t>()(key.source_hash) ^
+         std::hash<GPUPixelContext*>()(key.context);
 }
 
+GPUPixelGLProgram::GPUPixelGLProgram()
+    : program_(-1),
+      context_(GPUPixelContext::GetInstance()),
+      cached_(false),
+      cache_key_{nullptr, 0} {}
+
 GPUPixelGLProgram::~GPUPixelGLProgram() {
-  GPUPixelContext::GetInstance()->SyncRunWithContext([=] {
-    std::vector<GPUPixelGLProgram*>::iterator itr =
-        std::find(programs_.begin(), programs_.end(), this);
-    if (itr != programs_.end()) {
-      programs_.erase(itr);
-    }
+  context_->SyncRunWithContext([=] { ReleaseProgram(); });
+}
 
-    bool should_delete_program = (program_ != -1);
+void GPUPixelGLProgram::ReleaseProgram() {
+  if (program_ == -1) {
+    return;
+  }
 
-    for (auto const& program : programs_) {
-      if (should_delete_program) {
-        if (program_ == program->GetProgram()) {
-          should_delete_program = false;
-          break;
-        }
-      }
+  bool should_delete_program = true;
+  if (cached_) {
+    std::lock_guard<std::mutex> lock(programs_mutex_);
+    auto itr = programs_.find(cache_key_);
+    if (itr != programs_.end() && --itr->second.ref_count > 0) {
+      should_delete_program = false;
+    } else if (itr != programs_.end()) {
+      programs_.erase(itr);
     }
+    cached_ = false;
+  }
 
-    if (should_delete_program) {
-      glDeleteProgram(program_);
-      program_ = -1;
-    }
-  });
+  if (should_delete_program) {
+    glDeleteProgram(program_);
+    context_->OnProgramDeleted(program_);
+  }
+  program_ = -1;
+  uniform_locations_.clear();
+  attribute_locations_.clear();
+  uniform_values_.reset();
+}
+
+GPUPixelGLProgramCacheStats GPUPixelGLProgram::GetCacheStats() {
+  std::lock_guard<std::mutex> lock(programs_mutex_);
+  GPUPixelGLProgramCacheStats stats;
+  stats.programs = programs_.size();
+  for (const auto& itr : programs_) {
+    stats.references += itr.second.ref_count;
+  }
+  stats.hits = cache_hits_;
+  stats.misses = cache_misses_;
+  stats.location_lookups = location_lookups_;
+  stats.uniform_uploads = uniform_uploads_;
+  stats.uniform_uploads_skipped = uniform_uploads_skipped_;
+  return stats;
 }
 
 GPUPixelGLProgram* GPUPixelGLProgram::CreateWithShaderString(
@@ -61,10 +121,60 @@ GPUPixelGLProgram* GPUPixelGLProgram::CreateWithShaderString(
 bool GPUPixelGLProgram::InitWithShaderString(
     const std::string& vertex_shader_source,
     const std::string& fragment_shader_source) {
-  if (program_ != -1) {
-    GL_CALL(glDeleteProgram(program_));
-    program_ = -1;
+  ReleaseProgram();
+
+  CacheKey key{context_, HashShaderSources(vertex_shader_source,
+                                           fragment_shader_source)};
+  {
+    std::lock_guard<std::mutex> lock(programs_mutex_);
+    auto itr = programs_.find(key);
+    if (itr != programs_.end() &&
+        itr->second.vertex_shader_source == vertex_shader_source &&
+        itr->second.fragment_shader_source == fragment_shader_source) {
+      ++itr->second.ref_count;
+      ++cache_hits_;
+      program_ = itr->second.program;
+      uniform_values_ = itr->second.uniform_values;
+      cache_key_ = key;
+      cached_ = true;
+      return true;
+    }
+    ++cache_misses_;
+  }
+
+  uniform_values_ = std::make_shared<UniformValues>();
+  uint32_t program = ProgramBinaryCache::Load(key.source_hash);
+  if (program != 0) {
+    program_ = program;
+  } else {
+    if (!CompileAndLink(vertex_shader_source, fragment_shader_source)) {
+      return false;
+    }
+
+    // Build errors have been logged; such a program stays private to this
+    // wrapper instead of being shared
+    GLint link_success = GL_FALSE;
+    GL_CALL(glGetProgramiv(program_, GL_LINK_STATUS, &link_success));
+    if (link_success == GL_FALSE) {
+      return true;
+    }
+    ProgramBinaryCache::Store(key.source_hash, program_);
   }
+
+  // Leave a slot taken by a colliding hash to its owner
+  std::lock_guard<std::mutex> lock(programs_mutex_);
+  if (programs_.find(key) == programs_.end()) {
+    programs_[key] = CacheEntry{program_, 1, uniform_values_,
+                                vertex_shader_source, fragment_shader_source};
+    cache_key_ = key;
+    cached_ = true;
+  }
+  return true;
+}
+
+bool GPUPixelGLProgram::CompileAndLink(
+    const std::string& vertex_shader_source,
+    const std::string& fragment_shader_source) {
   GL_CALL(program_ = glCreateProgram());
 
   uint32_t vert_shader;
@@ -115,6 +225,7 @@ bool GPUPixelGLProgram::InitWithShaderString(
   GL_CALL(glAttachShader(program_, vert_shader));
   GL_CALL(glAttachShader(program_, frag_shader));
 
+  ProgramBinaryCache::PrepareForLink(program_);
   GL_CALL(glLinkProgram(program_));
 
   GL_CALL(glDeleteShader(vert_shader));
@@ -127,73 +238,104 @@ void GPUPixelGLProgram::UseProgram() {
   GL_CALL(glUseProgram(program_));
 }
 
-uint32_t GPUPixelGLProgram::GetAttribLocation(const std::string& attribute) {
-  return glGetAttribLocation(program_, attribute.c_str());
+GLint GPUPixelGLProgram::FindLocation(
+    const std::vector<CachedLocation>& locations,
+    const char* name) {
+  for (const auto& cached : locations) {
+    if (strcmp(cached.name.c_str(), name) == 0) {
+      return cached.location;
+    }
+  }
+  return kLocationNotCached;
 }
 
-uint32_t GPUPixelGLProgram::GetUniformLocation(
-    const std::string& uniform_name) {
-  return glGetUniformLocation(program_, uniform_name.c_str());
+uint32_t GPUPixelGLProgram::GetAttribLocation(const char* attribute) {
+  GLint location = FindLocation(attribute_locations_, attribute);
+  if (location == kLocationNotCached) {
+    ++location_lookups_;
+    location = glGetAttribLocation(program_, attribute);
+    attribute_locations_.push_back({attribute, location});
+  }
+  return location;
+}
+
+uint32_t GPUPixelGLProgram::GetUniformLocation(const char* uniform_name) {
+  GLint location = FindLocation(uniform_locations_, uniform_name);
+  if (location == kLocationNotCached) {
+    ++location_lookups_;
+    location = glGetUniformLocation(program_, uniform_name);
+    uniform_locations_.push_back({uniform_name, location});
+  }
+  return location;
 }
 
 void GPUPixelGLProgram::SetUniformValue(const std::string& uniform_name,
                                         int value) {
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   SetUniformValue(GetUniformLocation(uniform_name), value);
 }
 
 void GPUPixelGLProgram::SetUniformValue(const std::string& uniform_name,
                                         float value) {
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   SetUniformValue(GetUniformLocation(uniform_name), value);
 }
 
 void GPUPixelGLProgram::SetUniformValue(const std::string& uniform_name,
                                         Matrix4 value) {
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   SetUniformValue(GetUniformLocation(uniform_name), value);
 }
 
 void GPUPixelGLProgram::SetUniformValue(const std::string& uniform_name,
                                         Vector2 value) {
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   SetUniformValue(GetUniformLocation(uniform_name), value);
 }
 
 void GPUPixelGLProgram::SetUniformValue(const std::string& uniform_name,
                                         Matrix3 value) {
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   SetUniformValue(GetUniformLocation(uniform_name), value);
 }
 
 void GPUPixelGLProgram::SetUniformValue(const std::string& uniform_name,
                                         const void* value,
                                         int length) {
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   SetUniformValue(GetUniformLocation(uniform_name), value, length);
 }
 
 void GPUPixelGLProgram::SetUniformValue(int uniform_location, int value) {
+  if (!UpdateUniformValue(uniform_location, &value, sizeof(value))) {
+    return;
+  }
   GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   GL_CALL(glUniform1i(uniform_location, value));
 }
 
 void GPUPixelGLProgram::SetUniformValue(int uniform_location, float value) {
+  if (!UpdateUniformValue(uniform_location, &value, sizeof(value))) {
+    return;
+  }
   GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   GL_CALL(glUniform1f(uniform_location, value));
 }
 
 void GPUPixelGLProgram::SetUniformValue(int uniform_location, Matrix4 value) {
+  if (!UpdateUniformValue(uniform_location, &value, sizeof(value))) {
+    return;
+  }
   GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   GL_CALL(glUniformMatrix4fv(uniform_location, 1, GL_FALSE, (float*)&value));
 }
 
 void GPUPixelGLProgram::SetUniformValue(int uniform_location, Vector2 value) {
+  if (!UpdateUniformValue(uniform_location, &value, sizeof(value))) {
+    return;
+  }
   GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   GL_CALL(glUniform2f(uniform_location, value.x, value.y));
 }
 
 void GPUPixelGLProgram::SetUniformValue(int uniform_location, Matrix3 value) {
+  if (!UpdateUniformValue(uniform_location, &value, sizeof(value))) {
+    return;
+  }
   GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   GL_CALL(glUniformMatrix3fv(uniform_location, 1, GL_FALSE, (float*)&value));
 }
@@ -201,8 +343,43 @@ void GPUPixelGLProgram::SetUniformValue(int uniform_location, Matrix3 value) {
 void GPUPixelGLProgram::SetUniformValue(int uniform_location,
                                         const void* value,
                                         int length) {
+  if (!UpdateUniformValue(uniform_location, value, length * sizeof(float))) {
+    return;
+  }
   GPUPixelContext::GetInstance()->SetActiveGlProgram(this);
   GL_CALL(glUniform1fv(uniform_location, length, (float*)value));
 }
 
+bool GPUPixelGLProgram::UpdateUniformValue(int location,
+                                           const void* value,
+                                           size_t size) {
+  // GL ignores location -1, so there is nothing to upload
+  if (location < 0) {
+    return false;
+  }
+  if (!uniform_values_) {
+    ++uniform_uploads_;
+    return true;
+  }
+
+  const char* bytes = (const char*)value;
+  for (auto& cached : *uniform_values_) {
+    if (cached.location != location) {
+      continue;
+    }
+    if (cached.bytes.size() == size &&
+        memcmp(cached.bytes.data(), bytes, size) == 0) {
+      ++uniform_uploads_skipped_;
+      return false;
+    }
+    cached.bytes.assign(bytes, bytes + size);
+    ++uniform_uploads_;
+    return true;
+  }
+  uniform_values_->push_back(
+      {location, std::vector<char>(bytes, bytes + size)});
+  ++uniform_uploads_;
+  return true;
+}
+
 }  // namespace gpupixel
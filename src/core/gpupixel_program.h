@@ -7,25 +7,67 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "core/gpupixel_gl_include.h"
 #include "gpupixel/utils/math_toolbox.h"
+#include "gpupixel/utils/uniform_handle.h"
 
 namespace gpupixel {
+class GPUPixelContext;
+
+struct GPUPixelGLProgramCacheStats {
+  // Linked GL programs currently alive, and the wrappers sharing them
+  size_t programs = 0;
+  size_t references = 0;
+  // Creations served from the cache / that had to compile and link
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // glGetUniformLocation / glGetAttribLocation calls, i.e. location cache
+  // misses
+  uint64_t location_lookups = 0;
+  // glUniform* calls made, and those left out because the program already
+  // held the value
+  uint64_t uniform_uploads = 0;
+  uint64_t uniform_uploads_skipped = 0;
+};
+
 class GPUPIXEL_API GPUPixelGLProgram {
  public:
   GPUPixelGLProgram();
   ~GPUPixelGLProgram();
 
+  // Wrappers created from identical sources on the same context share one
+  // linked GL program, which is deleted with the last of them. Uniform values
+  // are program state and therefore shared too, so users set them before
+  // every draw. The last value set is remembered per GL program and setting it
+  // again does not reach the driver, so uniforms must only be changed through
+  // SetUniformValue.
   static GPUPixelGLProgram* CreateWithShaderString(
       const std::string& vertex_shader_source,
       const std::string& fragment_shader_source);
+  static GPUPixelGLProgramCacheStats GetCacheStats();
   void UseProgram();
   uint32_t GetProgram() const { return program_; }
 
-  uint32_t GetAttribLocation(const std::string& attribute);
-  uint32_t GetUniformLocation(const std::string& uniform_name);
+  // Locations are cached per program, so only the first lookup of a name
+  // reaches the driver
+  uint32_t GetAttribLocation(const char* attribute);
+  uint32_t GetAttribLocation(const std::string& attribute) {
+    return GetAttribLocation(attribute.c_str());
+  }
+  uint32_t GetUniformLocation(const char* uniform_name);
+  uint32_t GetUniformLocation(const std::string& uniform_name) {
+    return GetUniformLocation(uniform_name.c_str());
+  }
+  UniformHandle GetUniformHandle(const char* uniform_name) {
+    return UniformHandle(GetUniformLocation(uniform_name));
+  }
 
   void SetUniformValue(const std::string& uniform_name, int value);
   void SetUniformValue(const std::string& uniform_name, float value);
@@ -44,11 +86,90 @@ class GPUPIXEL_API GPUPixelGLProgram {
   void SetUniformValue(int uniform_location, Matrix4 value);
   void SetUniformValue(int uniform_location, const void* array, int length);
 
+  void SetUniformValue(UniformHandle handle, int value) {
+    SetUniformValue(handle.GetLocation(), value);
+  }
+  void SetUniformValue(UniformHandle handle, float value) {
+    SetUniformValue(handle.GetLocation(), value);
+  }
+  void SetUniformValue(UniformHandle handle, Vector2 value) {
+    SetUniformValue(handle.GetLocation(), value);
+  }
+  void SetUniformValue(UniformHandle handle, Matrix3 value) {
+    SetUniformValue(handle.GetLocation(), value);
+  }
+  void SetUniformValue(UniformHandle handle, Matrix4 value) {
+    SetUniformValue(handle.GetLocation(), value);
+  }
+  void SetUniformValue(UniformHandle handle, const void* array, int length) {
+    SetUniformValue(handle.GetLocation(), array, length);
+  }
+
  private:
-  static std::vector<GPUPixelGLProgram*> programs_;
+  struct CacheKey {
+    // Program names are only unique within one context
+    GPUPixelContext* context;
+    uint64_t source_hash;
+
+    bool operator==(const CacheKey& other) const {
+      return context == other.context && source_hash == other.source_hash;
+    }
+  };
+  struct CacheKeyHash {
+    size_t operator()(const CacheKey& key) const;
+  };
+  struct UniformValue {
+    GLint location;
+    std::vector<char> bytes;
+  };
+  // Last value uploaded to each uniform of one GL program
+  using UniformValues = std::vector<UniformValue>;
+
+  struct CacheEntry {
+    uint32_t program;
+    size_t ref_count;
+    std::shared_ptr<UniformValues> uniform_values;
+    // Kept to rule out hash collisions
+    std::string vertex_shader_source;
+    std::string fragment_shader_source;
+  };
+
+  static std::unordered_map<CacheKey, CacheEntry, CacheKeyHash> programs_;
+  // Programs are created on every context's worker thread
+  static std::mutex programs_mutex_;
+  static uint64_t cache_hits_;
+  static uint64_t cache_misses_;
+  static std::atomic<uint64_t> location_lookups_;
+  static std::atomic<uint64_t> uniform_uploads_;
+  static std::atomic<uint64_t> uniform_uploads_skipped_;
+
+  struct CachedLocation {
+    std::string name;
+    GLint location;
+  };
+  // Programs have a handful of inputs, so a scan beats hashing the name
+  static GLint FindLocation(const std::vector<CachedLocation>& locations,
+                            const char* name);
+
   uint32_t program_;
+  // Context the program was created on
+  GPUPixelContext* context_;
+  // Whether program_ is registered in programs_ under cache_key_
+  bool cached_;
+  CacheKey cache_key_;
+  std::vector<CachedLocation> uniform_locations_;
+  std::vector<CachedLocation> attribute_locations_;
+  // Shared with the other wrappers of program_
+  std::shared_ptr<UniformValues> uniform_values_;
+
   bool InitWithShaderString(const std::string& vertex_shader_source,
                             const std::string& fragment_shader_source);
+  bool CompileAndLink(const std::string& vertex_shader_source,
+                      const std::string& fragment_shader_source);
+  void ReleaseProgram();
+  // Records |size| bytes at |value| as the uniform's value; false if the
+  // program already holds it and the upload can be skipped
+  bool UpdateUniformValue(int location, const void* value, size_t size);
 };
 
 }  // namespace gpupixel
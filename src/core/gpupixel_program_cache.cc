@@ -0,0 +1,264 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "core/gpupixel_program_cache.h"
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_gl_include.h"
+#include "utils/util.h"
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+#if defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+#define GPUPIXEL_GL_APIENTRYP APIENTRYP
+#else
+#define GPUPIXEL_GL_APIENTRYP *
+#endif
+
+namespace gpupixel {
+
+namespace {
+
+typedef void(GPUPIXEL_GL_APIENTRYP GetProgramBinaryProc)(GLuint program,
+                                                         GLsizei buf_size,
+                                                         GLsizei* length,
+                                                         GLenum* format,
+                                                         void* binary);
+typedef void(GPUPIXEL_GL_APIENTRYP ProgramBinaryProc)(GLuint program,
+                                                      GLenum format,
+                                                      const void* binary,
+                                                      GLsizei length);
+typedef void(GPUPIXEL_GL_APIENTRYP ProgramParameteriProc)(GLuint program,
+                                                          GLenum pname,
+                                                          GLint value);
+
+struct BinaryFunctions {
+  GetProgramBinaryProc get_program_binary = nullptr;
+  ProgramBinaryProc program_binary = nullptr;
+  ProgramParameteriProc program_parameteri = nullptr;
+};
+
+// Desktop GL only has these from 4.1 / ARB_get_program_binary, beyond what
+// glad loads, so they are resolved at runtime. GLES 3 has them in core.
+const BinaryFunctions& GetBinaryFunctions() {
+  static const BinaryFunctions functions = [] {
+    BinaryFunctions f;
+#if defined(GPUPIXEL_WIN) || defined(GPUPIXEL_LINUX)
+#if defined(GPUPIXEL_LINUX_HEADLESS)
+    auto load = [](const char* name) { return (void*)eglGetProcAddress(name); };
+#else
+    auto load = [](const char* name) {
+      return (void*)glfwGetProcAddress(name);
+    };
+#endif
+    f.get_program_binary = (GetProgramBinaryProc)load("glGetProgramBinary");
+    f.program_binary = (ProgramBinaryProc)load("glProgramBinary");
+    f.program_parameteri = (ProgramParameteriProc)load("glProgramParameteri");
+#elif defined(GPUPIXEL_ANDROID) || defined(GPUPIXEL_IOS)
+    f.get_program_binary = glGetProgramBinary;
+    f.program_binary = glProgramBinary;
+    f.program_parameteri = glProgramParameteri;
+#endif
+    return f;
+  }();
+  return functions;
+}
+
+constexpr uint32_t kMagic = 0x42585047;  // "GPXB"
+constexpr uint32_t kFileVersion = 1;
+
+struct FileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t source_hash;
+  uint64_t driver_hash;
+  uint32_t format;
+  uint32_t length;
+};
+
+std::atomic<uint64_t> g_loads{0};
+std::atomic<uint64_t> g_rejects{0};
+std::atomic<uint64_t> g_stores{0};
+
+// Binaries are only valid for the driver that produced them
+uint64_t DriverHash() {
+  std::string driver;
+  for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+    const char* value = (const char*)glGetString(name);
+    driver += value ? value : "";
+    driver += '\n';
+  }
+  return std::hash<std::string>()(driver);
+}
+
+fs::path EntryPath(uint64_t source_hash, uint64_t driver_hash) {
+  return Util::GetProgramCachePath() /
+         Util::StringFormat("%016llx_%016llx.bin",
+                            (unsigned long long)source_hash,
+                            (unsigned long long)driver_hash);
+}
+
+}  // namespace
+
+bool ProgramBinaryCache::IsEnabled() {
+  if (Util::GetProgramCachePath().empty()) {
+    return false;
+  }
+  // GLES 2 only has program binaries through OES_get_program_binary, whose
+  // functions are not the ones loaded here, and desktop GL from 4.1 or
+  // ARB_get_program_binary on; elsewhere asking for the formats is an error
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  int major = context->GetGLMajorVersion();
+  bool supported =
+      context->IsGLES()
+          ? major >= 3
+          : major > 4 || (major == 4 && context->GetGLMinorVersion() >= 1) ||
+                context->HasGLExtension("GL_ARB_get_program_binary");
+  const BinaryFunctions& functions = GetBinaryFunctions();
+  if (!supported || !functions.get_program_binary ||
+      !functions.program_binary) {
+    return false;
+  }
+  GLint formats = 0;
+  GL_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+  return formats > 0;
+}
+
+uint32_t ProgramBinaryCache::Load(uint64_t source_hash) {
+  if (!IsEnabled()) {
+    return 0;
+  }
+
+  uint64_t driver_hash = DriverHash();
+  fs::path path = EntryPath(source_hash, driver_hash);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return 0;
+  }
+  FileHeader header;
+  std::vector<char> binary;
+  bool valid = (bool)file.read((char*)&header, sizeof(header)) &&
+               header.magic == kMagic && header.version == kFileVersion &&
+               header.source_hash == source_hash &&
+               header.driver_hash == driver_hash;
+  if (valid) {
+    binary.resize(header.length);
+    valid = (bool)file.read(binary.data(), binary.size());
+  }
+  file.close();
+
+  uint32_t program = 0;
+  if (valid) {
+    GL_CALL(program = glCreateProgram());
+    // Not wrapped in GL_CALL: the driver may refuse the binary, which is the
+    // expected outcome after an update and is handled by compiling instead.
+    // Earlier errors are reported first so that clearing the errors of this
+    // call does not hide them.
+    GLErrorCheck::CheckPending(__FILE__, __FUNCTION__, __LINE__);
+    GetBinaryFunctions().program_binary(program, header.format, binary.data(),
+                                        (GLsizei)binary.size());
+    GLErrorCheck::ClearPending();
+    GLint link_success = GL_FALSE;
+    GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &link_success));
+    if (link_success == GL_TRUE) {
+      ++g_loads;
+      return program;
+    }
+    GL_CALL(glDeleteProgram(program));
+  }
+
+  LOG_DEBUG("ProgramBinaryCache: discarding {}", path.string());
+  ++g_rejects;
+  std::error_code error;
+  fs::remove(path, error);
+  return 0;
+}
+
+void ProgramBinaryCache::PrepareForLink(uint32_t program) {
+  if (!IsEnabled() || !GetBinaryFunctions().program_parameteri) {
+    return;
+  }
+  GL_CALL(GetBinaryFunctions().program_parameteri(
+      program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+}
+
+void ProgramBinaryCache::Store(uint64_t source_hash, uint32_t program) {
+  if (!IsEnabled()) {
+    return;
+  }
+
+  GLint length = 0;
+  GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+  if (length <= 0) {
+    return;
+  }
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  GLsizei written = 0;
+  GL_CALL(GetBinaryFunctions().get_program_binary(program, length, &written,
+                                                  &format, binary.data()));
+  if (written <= 0) {
+    return;
+  }
+
+  FileHeader header;
+  header.magic = kMagic;
+  header.version = kFileVersion;
+  header.source_hash = source_hash;
+  header.driver_hash = DriverHash();
+  header.format = format;
+  header.length = (uint32_t)written;
+
+  std::error_code error;
+  fs::create_directories(Util::GetProgramCachePath(), error);
+
+  // Written aside and renamed so that contexts on other threads or processes
+  // never read a partial entry
+  fs::path path = EntryPath(source_hash, header.driver_hash);
+  fs::path temp_path = path;
+  temp_path += Util::StringFormat(
+      ".%zx.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.write((const char*)&header, sizeof(header)) ||
+        !file.write(binary.data(), written)) {
+      LOG_WARN("ProgramBinaryCache: failed to write {}", temp_path.string());
+      file.close();
+      fs::remove(temp_path, error);
+      return;
+    }
+  }
+  fs::rename(temp_path, path, error);
+  if (error) {
+    fs::remove(temp_path, error);
+    return;
+  }
+  ++g_stores;
+}
+
+ProgramBinaryCacheStats ProgramBinaryCache::GetStats() {
+  ProgramBinaryCacheStats stats;
+  stats.loads = g_loads;
+  stats.rejects = g_rejects;
+  stats.stores = g_stores;
+  return stats;
+}
+
+}  // namespace gpupixel
@@ -0,0 +1,45 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+
+struct ProgramBinaryCacheStats {
+  // Programs created from a stored binary
+  uint64_t loads = 0;
+  // Stored binaries the driver refused, e.g. after a driver update
+  uint64_t rejects = 0;
+  // Binaries written after compiling and linking
+  uint64_t stores = 0;
+};
+
+// Linked program binaries kept under Util::GetProgramCachePath(), keyed by the
+// shader source hash and the GL vendor, renderer and version strings. Disabled
+// while no path is set or when the driver offers no binary formats. Must be
+// used on a thread with a current GL context.
+class GPUPIXEL_API ProgramBinaryCache {
+ public:
+  static bool IsEnabled();
+
+  // Returns a linked program restored from disk, or 0 when there is no usable
+  // binary and the sources have to be compiled
+  static uint32_t Load(uint64_t source_hash);
+
+  // Lets the driver keep the binary around; call before linking a program
+  // that is going to be stored
+  static void PrepareForLink(uint32_t program);
+
+  static void Store(uint64_t source_hash, uint32_t program);
+
+  static ProgramBinaryCacheStats GetStats();
+};
+
+}  // namespace gpupixel
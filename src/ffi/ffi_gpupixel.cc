@@ -1,12 +1,27 @@
 #include <stdint.h>
 #include <cstring>
 #include <climits>
+#include <memory>
+#include "core/gpupixel_context.h"
+#include "core/gpupixel_framebuffer_factory.h"
+#include "gpupixel/ffi/ffi_gpupixel.h"
 #include "libyuv/convert.h"
 #include "libyuv/convert_argb.h"
 #include "libyuv/planar_functions.h"
 #include "libyuv/rotate.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
+namespace {
+
+gpupixel::GPUPixelContext* ContextFromHandle(intptr_t context) {
+  auto* ptr =
+      reinterpret_cast<std::shared_ptr<gpupixel::GPUPixelContext>*>(context);
+  return ptr ? ptr->get() : gpupixel::GPUPixelContext::GetInstance();
+}
+
+}  // namespace
+
 extern "C" {
 
 // Convert YUV420 to RGBA, output to rgba_out, ensure rgba_out has enough space (width*height*4 bytes)
@@ -225,4 +240,128 @@ void gpupixel_set_resource_path(const char* path) {
   gpupixel::Util::SetResourcePath(fs::path(path).string());
 }
 
+// Set program binary cache directory
+void gpupixel_set_program_cache_path(const char* path) {
+  gpupixel::Util::SetProgramCachePath(path ? fs::path(path) : fs::path());
+}
+
+// Set GL error check mode
+void gpupixel_set_gl_error_check(int mode, int sample_interval) {
+  gpupixel::GLErrorCheck::SetMode((gpupixel::GPUPIXEL_GL_ERROR_CHECK)mode,
+                                  sample_interval);
+}
+
+// Create independent context
+intptr_t gpupixel_context_create(intptr_t share_context) {
+  auto* share =
+      reinterpret_cast<std::shared_ptr<gpupixel::GPUPixelContext>*>(
+          share_context);
+  auto context = gpupixel::GPUPixelContext::Create(
+      share ? share->get() : nullptr);
+  if (!context) return 0;
+  auto* ptr = new std::shared_ptr<gpupixel::GPUPixelContext>(context);
+  return reinterpret_cast<intptr_t>(ptr);
+}
+
+// Destroy context
+void gpupixel_context_destroy(intptr_t context) {
+  auto* ptr =
+      reinterpret_cast<std::shared_ptr<gpupixel::GPUPixelContext>*>(context);
+  delete ptr;
+}
+
+// Bind context to the calling thread
+void gpupixel_context_set_thread_context(intptr_t context) {
+  auto* ptr =
+      reinterpret_cast<std::shared_ptr<gpupixel::GPUPixelContext>*>(context);
+  gpupixel::GPUPixelContext::SetThreadContext(ptr ? ptr->get() : nullptr);
+}
+
+// Set framebuffer cache budget
+void gpupixel_framebuffer_cache_set_budget(intptr_t context, uint64_t bytes) {
+  auto* ctx = ContextFromHandle(context);
+  ctx->SyncRunWithContext(
+      [&] { ctx->GetFramebufferFactory()->SetMemoryBudget((size_t)bytes); });
+}
+
+// Evict idle framebuffers
+uint64_t gpupixel_framebuffer_cache_trim(intptr_t context,
+                                         uint64_t target_bytes) {
+  auto* ctx = ContextFromHandle(context);
+  uint64_t freed = 0;
+  ctx->SyncRunWithContext([&] {
+    freed = ctx->GetFramebufferFactory()->Trim((size_t)target_bytes);
+  });
+  return freed;
+}
+
+// Query framebuffer cache usage per format
+int gpupixel_framebuffer_cache_get_usage(intptr_t context,
+                                         GPUPixelFramebufferUsage* usage,
+                                         int capacity) {
+  auto* ctx = ContextFromHandle(context);
+  std::vector<gpupixel::FramebufferMemoryUsage> usages;
+  ctx->SyncRunWithContext(
+      [&] { usages = ctx->GetFramebufferFactory()->GetMemoryUsage(); });
+
+  for (int i = 0; usage && i < capacity && i < (int)usages.size(); ++i) {
+    usage[i].internal_format = usages[i].internal_format;
+    usage[i].type = usages[i].type;
+    usage[i].live_bytes = usages[i].live_bytes;
+    usage[i].pooled_bytes = usages[i].pooled_bytes;
+    usage[i].live_count = (uint32_t)usages[i].live_count;
+    usage[i].pooled_count = (uint32_t)usages[i].pooled_count;
+  }
+  return (int)usages.size();
+}
+
+// Enable or disable profiling
+void gpupixel_set_profiling_enabled(int enabled) {
+  gpupixel::Profiler::SetEnabled(enabled != 0);
+}
+
+int gpupixel_get_profile(intptr_t context,
+                         GPUPixelFilterProfile* profile,
+                         int capacity) {
+  auto* ctx = ContextFromHandle(context);
+  std::vector<gpupixel::FilterProfile> profiles;
+  ctx->SyncRunWithContext(
+      [&] { profiles = ctx->GetProfiler()->GetProfile(); });
+
+  for (int i = 0; profile && i < capacity && i < (int)profiles.size(); ++i) {
+    const gpupixel::FilterProfile& from = profiles[i];
+    GPUPixelFilterProfile& to = profile[i];
+    to.node_id = from.node_id;
+    strncpy(to.name, from.name.c_str(), sizeof(to.name) - 1);
+    to.name[sizeof(to.name) - 1] = '\0';
+    to.cpu_samples = from.cpu_samples;
+    to.cpu_min_ms = from.cpu_min_ms;
+    to.cpu_avg_ms = from.cpu_avg_ms;
+    to.cpu_p99_ms = from.cpu_p99_ms;
+    to.gpu_samples = from.gpu_samples;
+    to.gpu_min_ms = from.gpu_min_ms;
+    to.gpu_avg_ms = from.gpu_avg_ms;
+    to.gpu_p99_ms = from.gpu_p99_ms;
+  }
+  return (int)profiles.size();
+}
+
+void gpupixel_reset_profile(intptr_t context) {
+  auto* ctx = ContextFromHandle(context);
+  ctx->SyncRunWithContext([&] { ctx->GetProfiler()->Reset(); });
+}
+
+// Enable or disable tracing
+void gpupixel_set_tracing_enabled(int enabled) {
+  gpupixel::Trace::SetEnabled(enabled != 0);
+}
+
+int gpupixel_write_trace(const char* path) {
+  return path && gpupixel::Trace::WriteJson(path) ? 1 : 0;
+}
+
+void gpupixel_clear_trace(void) {
+  gpupixel::Trace::Clear();
+}
+
 } // extern "C"
@@ -122,6 +122,46 @@ int gpupixel_sink_raw_data_get_i420_buffer(intptr_t sink_ptr, uint8_t** out_buff
   return size;
 }
 
+// Get NV12 buffer data - returns buffer size, data output via out_buffer, caller is responsible for releasing
+int gpupixel_sink_raw_data_get_nv12_buffer(intptr_t sink_ptr, uint8_t** out_buffer) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<SinkRawData>*>(sink_ptr);
+  if (!ptr || !*ptr || !out_buffer) {
+    if (out_buffer) *out_buffer = nullptr;
+    return 0;
+  }
+
+  const uint8_t* buffer = (*ptr)->GetNV12Buffer();
+  if (!buffer) {
+    *out_buffer = nullptr;
+    return 0;
+  }
+
+  int width = (*ptr)->GetWidth();
+  int height = (*ptr)->GetHeight();
+
+  // Check if width and height are valid
+  if (width <= 0 || height <= 0) {
+    *out_buffer = nullptr;
+    return 0;
+  }
+
+  // Check for potential overflow
+  if (width > INT_MAX / height || width * height > INT_MAX / 2) {
+    *out_buffer = nullptr;
+    return 0;
+  }
+
+  int size = width * height * 3 / 2;  // NV12 size = width * height * 1.5
+
+  *out_buffer = new uint8_t[size];
+  if (!*out_buffer) {
+    return 0;
+  }
+
+  memcpy(*out_buffer, buffer, size);
+  return size;
+}
+
 // Release buffer data
 void gpupixel_sink_raw_data_free_buffer(uint8_t* buffer) {
   delete[] buffer;
@@ -1,6 +1,7 @@
 #include <stdint.h>
 #include <memory>
 #include "gpupixel/source/source.h"
+#include "gpupixel/source/pipeline.h"
 #include "gpupixel/sink/sink.h"
 #include "gpupixel/filter/filter.h"
 
@@ -187,4 +188,57 @@ int gpupixel_source_get_rotated_framebuffer_height(intptr_t source_id, int is_so
   return 0;
 }
 
+// Get node id
+uint64_t gpupixel_source_get_node_id(intptr_t source_id, int is_source_filter) {
+  if (is_source_filter) {
+    auto* filter_ptr = reinterpret_cast<std::shared_ptr<Filter>*>(source_id);
+    if (filter_ptr && *filter_ptr) {
+      return (*filter_ptr)->GetNodeId();
+    }
+  } else {
+    auto* source_ptr = reinterpret_cast<std::shared_ptr<Source>*>(source_id);
+    if (source_ptr && *source_ptr) {
+      return (*source_ptr)->GetNodeId();
+    }
+  }
+  return 0;
+}
+
+// Create Pipeline
+intptr_t gpupixel_pipeline_create(intptr_t source_id, int is_source_filter) {
+  std::shared_ptr<Source> source;
+  if (is_source_filter) {
+    auto* filter_ptr = reinterpret_cast<std::shared_ptr<Filter>*>(source_id);
+    if (!filter_ptr || !*filter_ptr) return 0;
+    source = std::static_pointer_cast<Source>(*filter_ptr);
+  } else {
+    auto* source_ptr = reinterpret_cast<std::shared_ptr<Source>*>(source_id);
+    if (!source_ptr || !*source_ptr) return 0;
+    source = *source_ptr;
+  }
+
+  auto pipeline = Pipeline::Create(source);
+  if (!pipeline) return 0;
+  auto* ptr = new std::shared_ptr<Pipeline>(pipeline);
+  return reinterpret_cast<intptr_t>(ptr);
+}
+
+// Destroy Pipeline
+void gpupixel_pipeline_destroy(intptr_t pipeline_id) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<Pipeline>*>(pipeline_id);
+  delete ptr;
+}
+
+// Compile Pipeline
+int gpupixel_pipeline_compile(intptr_t pipeline_id) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<Pipeline>*>(pipeline_id);
+  return ptr && *ptr && (*ptr)->Compile() ? 1 : 0;
+}
+
+// Get pass count
+int gpupixel_pipeline_get_pass_count(intptr_t pipeline_id) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<Pipeline>*>(pipeline_id);
+  return ptr && *ptr ? (*ptr)->GetPassCount() : 0;
+}
+
 } // extern "C"
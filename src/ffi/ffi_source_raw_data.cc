@@ -45,4 +45,21 @@ void gpupixel_source_raw_data_set_rotation(intptr_t raw_ptr, int rotation) {
   }
 }
 
+// Set YUV matrix and range
+void gpupixel_source_raw_data_set_yuv_color_space(intptr_t raw_ptr, int matrix, int range) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<SourceRawData>*>(raw_ptr);
+  if (ptr && *ptr) {
+    (*ptr)->SetYUVColorSpace((GPUPIXEL_YUV_MATRIX)matrix, (GPUPIXEL_YUV_RANGE)range);
+  }
+}
+
+// Set the number of pixel buffers frames are streamed through
+int gpupixel_source_raw_data_set_upload_ring_size(intptr_t raw_ptr, int buffers) {
+  auto* ptr = reinterpret_cast<std::shared_ptr<SourceRawData>*>(raw_ptr);
+  if (ptr && *ptr) {
+    return (*ptr)->SetUploadRingSize(buffers) ? 1 : 0;
+  }
+  return 0;
+}
+
 } // extern "C"
@@ -306,6 +306,24 @@ bool BeautyFaceUnitFilter::Init() {
     return false;
   }
 
+  input_texture_uniforms_[0] =
+      filter_program_->GetUniformHandle("inputImageTexture");
+  input_texture_uniforms_[1] =
+      filter_program_->GetUniformHandle("inputImageTexture2");
+  input_texture_uniforms_[2] =
+      filter_program_->GetUniformHandle("inputImageTexture3");
+  look_up_gray_uniform_ = filter_program_->GetUniformHandle("lookUpGray");
+  look_up_origin_uniform_ = filter_program_->GetUniformHandle("lookUpOrigin");
+  look_up_skin_uniform_ = filter_program_->GetUniformHandle("lookUpSkin");
+  look_up_custom_uniform_ = filter_program_->GetUniformHandle("lookUpCustom");
+  width_offset_uniform_ = filter_program_->GetUniformHandle("widthOffset");
+  height_offset_uniform_ = filter_program_->GetUniformHandle("heightOffset");
+  sharpen_uniform_ = filter_program_->GetUniformHandle("sharpen");
+  blur_alpha_uniform_ = filter_program_->GetUniformHandle("blurAlpha");
+  whiten_uniform_ = filter_program_->GetUniformHandle("whiten");
+  tex_coord_attribute_ =
+      filter_program_->GetAttribLocation("inputTextureCoordinate");
+
   auto path = Util::GetResourcePath() / "res";
   gray_image_ = SourceImage::Create((path / "lookup_gray.png").string());
   original_image_ = SourceImage::Create((path / "lookup_origin.png").string());
@@ -319,63 +337,52 @@ bool BeautyFaceUnitFilter::DoRender(bool updateSinks) {
       -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
   };
 
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->SetActiveGlProgram(filter_program_);
   framebuffer_->Activate();
-  GL_CALL(glClearColor(background_color_.r, background_color_.g,
-                       background_color_.b, background_color_.a));
+  context->SetClearColor(background_color_.r, background_color_.g,
+                         background_color_.b, background_color_.a);
   GL_CALL(glClear(GL_COLOR_BUFFER_BIT));
 
-  GL_CALL(glActiveTexture(GL_TEXTURE2));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D,
-                        input_framebuffers_[0].frame_buffer->GetTexture()));
-  filter_program_->SetUniformValue("inputImageTexture", 2);
+  context->BindTexture(2, input_framebuffers_[0].frame_buffer->GetTexture());
+  filter_program_->SetUniformValue(input_texture_uniforms_[0], 2);
 
-  GL_CALL(glActiveTexture(GL_TEXTURE3));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D,
-                        input_framebuffers_[1].frame_buffer->GetTexture()));
-  filter_program_->SetUniformValue("inputImageTexture2", 3);
+  context->BindTexture(3, input_framebuffers_[1].frame_buffer->GetTexture());
+  filter_program_->SetUniformValue(input_texture_uniforms_[1], 3);
 
-  GL_CALL(glActiveTexture(GL_TEXTURE4));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D,
-                        input_framebuffers_[2].frame_buffer->GetTexture()));
-  filter_program_->SetUniformValue("inputImageTexture3", 4);
+  context->BindTexture(4, input_framebuffers_[2].frame_buffer->GetTexture());
+  filter_program_->SetUniformValue(input_texture_uniforms_[2], 4);
 
   // texcoord attribute
-  uint32_t filter_tex_coord_attribute =
-      filter_program_->GetAttribLocation("inputTextureCoordinate");
-  GL_CALL(glEnableVertexAttribArray(filter_tex_coord_attribute));
+  context->EnableVertexAttribArray(tex_coord_attribute_);
   GL_CALL(glVertexAttribPointer(
-      filter_tex_coord_attribute, 2, GL_FLOAT, 0, 0,
+      tex_coord_attribute_, 2, GL_FLOAT, 0, 0,
       GetTextureCoordinate(input_framebuffers_[0].rotation_mode)));
 
-  glActiveTexture(GL_TEXTURE5);
-  glBindTexture(GL_TEXTURE_2D, gray_image_->GetFramebuffer()->GetTexture());
-  filter_program_->SetUniformValue("lookUpGray", 5);
+  context->BindTexture(5, gray_image_->GetFramebuffer()->GetTexture());
+  filter_program_->SetUniformValue(look_up_gray_uniform_, 5);
 
-  glActiveTexture(GL_TEXTURE6);
-  glBindTexture(GL_TEXTURE_2D, original_image_->GetFramebuffer()->GetTexture());
-  filter_program_->SetUniformValue("lookUpOrigin", 6);
+  context->BindTexture(6, original_image_->GetFramebuffer()->GetTexture());
+  filter_program_->SetUniformValue(look_up_origin_uniform_, 6);
 
-  glActiveTexture(GL_TEXTURE7);
-  glBindTexture(GL_TEXTURE_2D, skin_image_->GetFramebuffer()->GetTexture());
-  filter_program_->SetUniformValue("lookUpSkin", 7);
+  context->BindTexture(7, skin_image_->GetFramebuffer()->GetTexture());
+  filter_program_->SetUniformValue(look_up_skin_uniform_, 7);
 
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, custom_image_->GetFramebuffer()->GetTexture());
-  filter_program_->SetUniformValue("lookUpCustom", 0);
+  context->BindTexture(0, custom_image_->GetFramebuffer()->GetTexture());
+  filter_program_->SetUniformValue(look_up_custom_uniform_, 0);
 
   float width_offset = 1.0 / this->GetRotatedFramebufferWidth();
   float height_offset = 1.0 / this->GetRotatedFramebufferHeight();
-  filter_program_->SetUniformValue("widthOffset", width_offset);
-  filter_program_->SetUniformValue("heightOffset", height_offset);
+  filter_program_->SetUniformValue(width_offset_uniform_, width_offset);
+  filter_program_->SetUniformValue(height_offset_uniform_, height_offset);
 
   // vertex position
   GL_CALL(glVertexAttribPointer(filter_position_attribute_, 2, GL_FLOAT, 0, 0,
                                 imageVertices));
 
-  filter_program_->SetUniformValue("sharpen", sharpen_factor_);
-  filter_program_->SetUniformValue("blurAlpha", blur_alpha_);
-  filter_program_->SetUniformValue("whiten", white_balance_);
+  filter_program_->SetUniformValue(sharpen_uniform_, sharpen_factor_);
+  filter_program_->SetUniformValue(blur_alpha_uniform_, blur_alpha_);
+  filter_program_->SetUniformValue(whiten_uniform_, white_balance_);
 
   // draw
   GL_CALL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
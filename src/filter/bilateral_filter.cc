@@ -231,8 +231,6 @@ bool BilateralMonoFilter::Init() {
 }
 
 bool BilateralMonoFilter::DoRender(bool updateSinks) {
-  std::shared_ptr<GPUPixelFramebuffer> inputFramebuffer =
-      input_framebuffers_.begin()->second.frame_buffer;
   RotationMode inputRotation =
       input_framebuffers_.begin()->second.rotation_mode;
 
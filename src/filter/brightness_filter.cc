@@ -9,25 +9,12 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
-#if defined(GPUPIXEL_GLES_SHADER) || defined(GPUPIXEL_MAC)
-const std::string kBrightnessFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform lowp float brightness_factor;
-    varying highp vec2 textureCoordinate;
+const std::string kBrightnessColorFunction = R"(
+    uniform float brightness_factor;
 
-    void main() {
-      lowp vec4 color = texture2D(inputImageTexture, textureCoordinate);
-      gl_FragColor = vec4((color.rgb + vec3(brightness_factor)), color.a);
+    vec4 Apply(vec4 color) {
+      return vec4((color.rgb + vec3(brightness_factor)), color.a);
     })";
-#elif defined(GPUPIXEL_WIN) || defined(GPUPIXEL_MAC) || defined(GPUPIXEL_LINUX)
-const std::string kBrightnessFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform float brightness_factor;
-    varying vec2 textureCoordinate;
-
-    void main() {
-      vec4 color = texture2D(inputImageTexture, textureCoordinate);
-      gl_FragColor = vec4((color.rgb + vec3(brightness_factor)), color.a);
-    })";
-#endif
 
 std::shared_ptr<BrightnessFilter> BrightnessFilter::Create(
     float brightness /* = 0.0*/) {
@@ -41,9 +28,11 @@ std::shared_ptr<BrightnessFilter> BrightnessFilter::Create(
 }
 
 bool BrightnessFilter::Init(float brightness) {
-  if (!InitWithFragmentShaderString(kBrightnessFragmentShaderString)) {
+  if (!InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kBrightnessColorFunction))) {
     return false;
   }
+  color_uniforms_ = ResolveColorUniforms(filter_program_, "");
 
   brightness_factor_ = 0.01;
   RegisterProperty("brightness_factor", brightness_factor_,
@@ -60,11 +49,29 @@ void BrightnessFilter::setBrightness(float brightness) {
   } else if (brightness_factor_ < -1.0) {
     brightness_factor_ = -1.0;
   }
+  OnColorChanged();
 }
 
 bool BrightnessFilter::DoRender(bool updateSinks) {
-  filter_program_->SetUniformValue("brightness_factor", brightness_factor_);
+  SetColorUniforms(filter_program_, color_uniforms_);
   return Filter::DoRender(updateSinks);
 }
 
+bool BrightnessFilter::GetColorFunction(std::string& glsl,
+                                        std::vector<std::string>& names) const {
+  glsl = kBrightnessColorFunction;
+  names = {"brightness_factor"};
+  return true;
+}
+
+std::vector<std::string> BrightnessFilter::GetColorUniformNames() const {
+  return {"brightness_factor"};
+}
+
+void BrightnessFilter::SetColorUniforms(
+    GPUPixelGLProgram* program,
+    const std::vector<UniformHandle>& uniforms) {
+  program->SetUniformValue(uniforms[0], brightness_factor_);
+}
+
 }  // namespace gpupixel
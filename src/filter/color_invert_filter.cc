@@ -9,13 +9,9 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
-const std::string kColorInvertFragmentShaderString = R"(
-
-    uniform sampler2D inputImageTexture; varying highp vec2 textureCoordinate;
-
-    void main() {
-      lowp vec4 color = texture2D(inputImageTexture, textureCoordinate);
-      gl_FragColor = vec4((1.0 - color.rgb), color.a);
+const std::string kColorInvertColorFunction = R"(
+    vec4 Apply(vec4 color) {
+      return vec4((1.0 - color.rgb), color.a);
     })";
 
 std::shared_ptr<ColorInvertFilter> ColorInvertFilter::Create() {
@@ -29,7 +25,8 @@ std::shared_ptr<ColorInvertFilter> ColorInvertFilter::Create() {
 }
 
 bool ColorInvertFilter::Init() {
-  if (!Filter::InitWithFragmentShaderString(kColorInvertFragmentShaderString)) {
+  if (!Filter::InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kColorInvertColorFunction))) {
     return false;
   }
   return true;
@@ -39,4 +36,12 @@ bool ColorInvertFilter::DoRender(bool updateSinks) {
   return Filter::DoRender(updateSinks);
 }
 
+bool ColorInvertFilter::GetColorFunction(
+    std::string& glsl,
+    std::vector<std::string>& names) const {
+  glsl = kColorInvertColorFunction;
+  names = {};
+  return true;
+}
+
 }  // namespace gpupixel
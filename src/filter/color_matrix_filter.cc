@@ -9,35 +9,15 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
-#if defined(GPUPIXEL_GLES_SHADER)
-const std::string kColorMatrixFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform lowp mat4 colorMatrix;
-    uniform lowp float intensity;
-
-    varying highp vec2 textureCoordinate;
-
-    void main() {
-      lowp vec4 textureColor = texture2D(inputImageTexture, textureCoordinate);
-      lowp vec4 outputColor = textureColor * colorMatrix;
-
-      gl_FragColor =
-          (intensity * outputColor) + ((1.0 - intensity) * textureColor);
-    })";
-#elif defined(GPUPIXEL_GL_SHADER)
-const std::string kColorMatrixFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform mat4 colorMatrix;
+const std::string kColorMatrixColorFunction = R"(
+    uniform mat4 colorMatrix;
     uniform float intensity;
 
-    varying vec2 textureCoordinate;
-
-    void main() {
-      vec4 textureColor = texture2D(inputImageTexture, textureCoordinate);
-      vec4 outputColor = textureColor * colorMatrix;
+    vec4 Apply(vec4 color) {
+      vec4 outputColor = color * colorMatrix;
 
-      gl_FragColor =
-          (intensity * outputColor) + ((1.0 - intensity) * textureColor);
+      return (intensity * outputColor) + ((1.0 - intensity) * color);
     })";
-#endif
 
 ColorMatrixFilter::ColorMatrixFilter()
     : intensity_factor_(1.0), color_matrix_(Matrix4::IDENTITY) {}
@@ -53,9 +33,11 @@ std::shared_ptr<ColorMatrixFilter> ColorMatrixFilter::Create() {
 }
 
 bool ColorMatrixFilter::Init() {
-  if (!Filter::InitWithFragmentShaderString(kColorMatrixFragmentShaderString)) {
+  if (!Filter::InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kColorMatrixColorFunction))) {
     return false;
   }
+  color_uniforms_ = ResolveColorUniforms(filter_program_, "");
 
   RegisterProperty("intensity", intensity_factor_,
                    "The percentage of color applied by color matrix with range "
@@ -75,9 +57,27 @@ bool ColorMatrixFilter::Init() {
 }
 
 bool ColorMatrixFilter::DoRender(bool updateSinks) {
-  filter_program_->SetUniformValue("intensity", intensity_factor_);
-  filter_program_->SetUniformValue("colorMatrix", color_matrix_);
+  SetColorUniforms(filter_program_, color_uniforms_);
   return Filter::DoRender(updateSinks);
 }
 
+bool ColorMatrixFilter::GetColorFunction(
+    std::string& glsl,
+    std::vector<std::string>& names) const {
+  glsl = kColorMatrixColorFunction;
+  names = {"colorMatrix", "intensity"};
+  return true;
+}
+
+std::vector<std::string> ColorMatrixFilter::GetColorUniformNames() const {
+  return {"intensity", "colorMatrix"};
+}
+
+void ColorMatrixFilter::SetColorUniforms(
+    GPUPixelGLProgram* program,
+    const std::vector<UniformHandle>& uniforms) {
+  program->SetUniformValue(uniforms[0], intensity_factor_);
+  program->SetUniformValue(uniforms[1], color_matrix_);
+}
+
 }  // namespace gpupixel
@@ -9,14 +9,11 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
-const std::string kContrastFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform lowp float contrast;
-    varying highp vec2 textureCoordinate;
-
-    void main() {
-      lowp vec4 color = texture2D(inputImageTexture, textureCoordinate);
-      gl_FragColor =
-          vec4(((color.rgb - vec3(0.5)) * contrast + vec3(0.5)), color.a);
+const std::string kContrastColorFunction = R"(
+    uniform float contrast;
+
+    vec4 Apply(vec4 color) {
+      return vec4(((color.rgb - vec3(0.5)) * contrast + vec3(0.5)), color.a);
     })";
 
 std::shared_ptr<ContrastFilter> ContrastFilter::Create() {
@@ -30,9 +27,11 @@ std::shared_ptr<ContrastFilter> ContrastFilter::Create() {
 }
 
 bool ContrastFilter::Init() {
-  if (!InitWithFragmentShaderString(kContrastFragmentShaderString)) {
+  if (!InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kContrastColorFunction))) {
     return false;
   }
+  color_uniforms_ = ResolveColorUniforms(filter_program_, "");
 
   contrast_factor_ = 1.0;
   RegisterProperty("contrast", contrast_factor_,
@@ -50,11 +49,29 @@ void ContrastFilter::setContrast(float contrast) {
   } else if (contrast_factor_ < 0.0) {
     contrast_factor_ = 0.0;
   }
+  OnColorChanged();
 }
 
 bool ContrastFilter::DoRender(bool updateSinks) {
-  filter_program_->SetUniformValue("contrast", contrast_factor_);
+  SetColorUniforms(filter_program_, color_uniforms_);
   return Filter::DoRender(updateSinks);
 }
 
+bool ContrastFilter::GetColorFunction(std::string& glsl,
+                                      std::vector<std::string>& names) const {
+  glsl = kContrastColorFunction;
+  names = {"contrast"};
+  return true;
+}
+
+std::vector<std::string> ContrastFilter::GetColorUniformNames() const {
+  return {"contrast"};
+}
+
+void ContrastFilter::SetColorUniforms(
+    GPUPixelGLProgram* program,
+    const std::vector<UniformHandle>& uniforms) {
+  program->SetUniformValue(uniforms[0], contrast_factor_);
+}
+
 }  // namespace gpupixel
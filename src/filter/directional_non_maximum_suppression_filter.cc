@@ -119,8 +119,6 @@ bool DirectionalNonMaximumSuppressionFilter::DoRender(bool updateSinks) {
   float texelWidth = 1.0 / framebuffer_->GetWidth();
   float texelHeight = 1.0 / framebuffer_->GetHeight();
 
-  std::shared_ptr<GPUPixelFramebuffer> inputFramebuffer =
-      input_framebuffers_.begin()->second.frame_buffer;
   RotationMode inputRotation =
       input_framebuffers_.begin()->second.rotation_mode;
 
@@ -9,13 +9,11 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
-const std::string kExposureFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform lowp float exposure;
-    varying highp vec2 textureCoordinate;
+const std::string kExposureColorFunction = R"(
+    uniform float exposure;
 
-    void main() {
-      lowp vec4 color = texture2D(inputImageTexture, textureCoordinate);
-      gl_FragColor = vec4(color.rgb * pow(2.0, exposure), color.a);
+    vec4 Apply(vec4 color) {
+      return vec4(color.rgb * pow(2.0, exposure), color.a);
     })";
 
 std::shared_ptr<ExposureFilter> ExposureFilter::Create() {
@@ -29,9 +27,11 @@ std::shared_ptr<ExposureFilter> ExposureFilter::Create() {
 }
 
 bool ExposureFilter::Init() {
-  if (!InitWithFragmentShaderString(kExposureFragmentShaderString)) {
+  if (!InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kExposureColorFunction))) {
     return false;
   }
+  color_uniforms_ = ResolveColorUniforms(filter_program_, "");
 
   exposure_factor_ = 0.0;
   RegisterProperty("exposure", exposure_factor_,
@@ -49,11 +49,29 @@ void ExposureFilter::SetExposure(float exposure) {
   } else if (exposure_factor_ < -10.0) {
     exposure_factor_ = -10.0;
   }
+  OnColorChanged();
 }
 
 bool ExposureFilter::DoRender(bool updateSinks) {
-  filter_program_->SetUniformValue("exposure", exposure_factor_);
+  SetColorUniforms(filter_program_, color_uniforms_);
   return Filter::DoRender(updateSinks);
 }
 
+bool ExposureFilter::GetColorFunction(std::string& glsl,
+                                      std::vector<std::string>& names) const {
+  glsl = kExposureColorFunction;
+  names = {"exposure"};
+  return true;
+}
+
+std::vector<std::string> ExposureFilter::GetColorUniformNames() const {
+  return {"exposure"};
+}
+
+void ExposureFilter::SetColorUniforms(
+    GPUPixelGLProgram* program,
+    const std::vector<UniformHandle>& uniforms) {
+  program->SetUniformValue(uniforms[0], exposure_factor_);
+}
+
 }  // namespace gpupixel
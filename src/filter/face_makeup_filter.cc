@@ -226,33 +226,32 @@ bool FaceMakeupFilter::DoRender(bool updateSinks) {
       -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
   };
 
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
   framebuffer_->Activate();
   // render origin frame --- begin -----//
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program2_);
-  GL_CALL(glClearColor(background_color_.r, background_color_.g,
-                       background_color_.b, background_color_.a));
+  context->SetActiveGlProgram(filter_program2_);
+  context->SetClearColor(background_color_.r, background_color_.g,
+                         background_color_.b, background_color_.a);
   GL_CALL(glClear(GL_COLOR_BUFFER_BIT));
 
-  GL_CALL(glActiveTexture(GL_TEXTURE4));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D,
-                        input_framebuffers_[0].frame_buffer->GetTexture()));
+  context->BindTexture(4, input_framebuffers_[0].frame_buffer->GetTexture());
   filter_program2_->SetUniformValue("inputImageTexture", 4);
 
   // vertex
-  GL_CALL(glEnableVertexAttribArray(filter_position_attribute2_));
+  context->EnableVertexAttribArray(filter_position_attribute2_);
   GL_CALL(glVertexAttribPointer(filter_position_attribute2_, 2, GL_FLOAT, 0, 0,
                                 imageVertices));
 
-  GL_CALL(glEnableVertexAttribArray(filter_tex_coord_attribute2_));
+  context->EnableVertexAttribArray(filter_tex_coord_attribute2_);
   GL_CALL(glVertexAttribPointer(filter_tex_coord_attribute2_, 2, GL_FLOAT, 0, 0,
                                 GetTextureCoordinate(NoRotation)));
 
   GL_CALL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
 
   // render image --- begin --- //
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
+  context->SetActiveGlProgram(filter_program_);
 
-  GL_CALL(glEnableVertexAttribArray(filter_position_attribute_));
+  context->EnableVertexAttribArray(filter_position_attribute_);
   if (face_landmarks_.size() != 0) {
     GL_CALL(glVertexAttribPointer(filter_position_attribute_, 2, GL_FLOAT, 0, 0,
                                   face_landmarks_.data()));
@@ -268,7 +267,7 @@ bool FaceMakeupFilter::DoRender(bool updateSinks) {
         (coord[i * 2 + 1] * 1280 - texture_bounds_.y) / texture_bounds_.height;
   }
   // texcoord attribute
-  GL_CALL(glEnableVertexAttribArray(filter_tex_coord_attribute_));
+  context->EnableVertexAttribArray(filter_tex_coord_attribute_);
   GL_CALL(glVertexAttribPointer(filter_tex_coord_attribute_, 2, GL_FLOAT, 0, 0,
                                 textureCoordinates.data()));
 
@@ -276,14 +275,12 @@ bool FaceMakeupFilter::DoRender(bool updateSinks) {
 
   filter_program_->SetUniformValue("blendMode", 15);
 
-  std::shared_ptr<GPUPixelFramebuffer> fb = input_framebuffers_[0].frame_buffer;
-  GL_CALL(glActiveTexture(GL_TEXTURE0));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, fb->GetTexture()));
+  GPUPixelFramebuffer* fb = input_framebuffers_[0].frame_buffer.get();
+  context->BindTexture(0, fb->GetTexture());
   filter_program_->SetUniformValue("inputImageTexture", 0);  // origin image
 
-  glActiveTexture(GL_TEXTURE3);
   // assert(image_texture_);
-  glBindTexture(GL_TEXTURE_2D, image_texture_->GetFramebuffer()->GetTexture());
+  context->BindTexture(3, image_texture_->GetFramebuffer()->GetTexture());
   filter_program_->SetUniformValue("inputImageTexture2", 3);
 
   if (has_face_) {
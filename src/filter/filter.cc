@@ -12,6 +12,43 @@
 #include "utils/util.h"
 namespace gpupixel {
 
+namespace {
+
+// Input names by index, so that rendering does not format them every frame.
+// Filters do not take more inputs than this.
+const char* const kInputTextureNames[] = {
+    "inputImageTexture",  "inputImageTexture1", "inputImageTexture2",
+    "inputImageTexture3", "inputImageTexture4", "inputImageTexture5",
+    "inputImageTexture6", "inputImageTexture7",
+};
+const char* const kInputTextureCoordinateNames[] = {
+    "inputTextureCoordinate",  "inputTextureCoordinate1",
+    "inputTextureCoordinate2", "inputTextureCoordinate3",
+    "inputTextureCoordinate4", "inputTextureCoordinate5",
+    "inputTextureCoordinate6", "inputTextureCoordinate7",
+};
+constexpr int kNamedInputs =
+    sizeof(kInputTextureNames) / sizeof(kInputTextureNames[0]);
+
+// |storage| holds the name of inputs beyond the tables
+const char* InputTextureName(int index, std::string& storage) {
+  if (index < kNamedInputs) {
+    return kInputTextureNames[index];
+  }
+  storage = Util::StringFormat("inputImageTexture%d", index);
+  return storage.c_str();
+}
+
+const char* InputTextureCoordinateName(int index, std::string& storage) {
+  if (index < kNamedInputs) {
+    return kInputTextureCoordinateNames[index];
+  }
+  storage = Util::StringFormat("inputTextureCoordinate%d", index);
+  return storage.c_str();
+}
+
+}  // namespace
+
 std::map<std::string, std::function<std::shared_ptr<Filter>()>>
 init_filter_factory() {
   std::map<std::string, std::function<std::shared_ptr<Filter>()>> factory;
@@ -63,11 +100,13 @@ init_filter_factory() {
 std::map<std::string, std::function<std::shared_ptr<Filter>()>>
     Filter::filter_factories_ = init_filter_factory();
 
-Filter::Filter() : filter_program_(0), filter_class_name_("") {
+Filter::Filter()
+    : filter_program_(0), filter_class_name_(""), color_version_(0) {
   background_color_.r = 0.0;
   background_color_.g = 0.0;
   background_color_.b = 0.0;
   background_color_.a = 1.0;
+  transient_framebuffer_ = true;
 }
 
 Filter::~Filter() {
@@ -86,6 +125,14 @@ std::shared_ptr<Filter> Filter::Create(const std::string& filter_class_name) {
   return nullptr;
 }
 
+std::vector<std::string> Filter::GetFilterClassNames() {
+  std::vector<std::string> names;
+  for (const auto& filter : filter_factories_) {
+    names.push_back(filter.first);
+  }
+  return names;
+}
+
 std::shared_ptr<Filter> Filter::CreateWithShaderString(
     const std::string& vertex_shader_source,
     const std::string& fragment_shader_source) {
@@ -112,7 +159,8 @@ bool Filter::InitWithShaderString(const std::string& vertex_shader_source,
       vertex_shader_source, fragment_shader_source);
   filter_position_attribute_ = filter_program_->GetAttribLocation("position");
   GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
-  GL_CALL(glEnableVertexAttribArray(filter_position_attribute_));
+  GPUPixelContext::GetInstance()->EnableVertexAttribArray(
+      filter_position_attribute_);
   return true;
 }
 
@@ -158,32 +206,63 @@ std::string Filter::GetVertexShaderString(int input_number) const {
   return shader_str;
 }
 
+std::string Filter::GetColorFunctionShaderHeader() {
+  // No precision qualifiers in color functions, which desktop GLSL 1.10 lacks
+  return R"(
+    #ifdef GL_ES
+    #ifdef GL_FRAGMENT_PRECISION_HIGH
+    precision highp float;
+    #else
+    precision mediump float;
+    #endif
+    #endif
+    uniform sampler2D inputImageTexture;
+    varying vec2 textureCoordinate;
+)";
+}
+
+std::string Filter::GetColorFunctionShaderString(
+    const std::string& color_function) {
+  return GetColorFunctionShaderHeader() + color_function + R"(
+    void main() {
+      gl_FragColor = Apply(texture2D(inputImageTexture, textureCoordinate));
+    })";
+}
+
+std::vector<UniformHandle> Filter::ResolveColorUniforms(
+    GPUPixelGLProgram* program,
+    const std::string& prefix) const {
+  std::vector<UniformHandle> uniforms;
+  for (const auto& name : GetColorUniformNames()) {
+    uniforms.push_back(program->GetUniformHandle((prefix + name).c_str()));
+  }
+  return uniforms;
+}
+
 bool Filter::DoRender(bool update_sinks) {
   static const float image_vertices[] = {
       -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
   };
 
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->SetActiveGlProgram(filter_program_);
   framebuffer_->Activate();
-  GL_CALL(glClearColor(background_color_.r, background_color_.g,
-                       background_color_.b, background_color_.a));
+  context->SetClearColor(background_color_.r, background_color_.g,
+                         background_color_.b, background_color_.a);
   GL_CALL(glClear(GL_COLOR_BUFFER_BIT));
   for (std::map<int, InputFrameBufferInfo>::const_iterator it =
            input_framebuffers_.begin();
        it != input_framebuffers_.end(); ++it) {
     int tex_idx = it->first;
-    std::shared_ptr<GPUPixelFramebuffer> fb = it->second.frame_buffer;
-    GL_CALL(glActiveTexture(GL_TEXTURE0 + tex_idx));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, fb->GetTexture()));
+    context->BindTexture(tex_idx, it->second.frame_buffer->GetTexture());
+    std::string name;
     filter_program_->SetUniformValue(
-        tex_idx == 0 ? "inputImageTexture"
-                     : Util::StringFormat("inputImageTexture%d", tex_idx),
+        filter_program_->GetUniformHandle(InputTextureName(tex_idx, name)),
         tex_idx);
     // texcoord attribute
     uint32_t filter_tex_coord_attribute = filter_program_->GetAttribLocation(
-        tex_idx == 0 ? "inputTextureCoordinate"
-                     : Util::StringFormat("inputTextureCoordinate%d", tex_idx));
-    GL_CALL(glEnableVertexAttribArray(filter_tex_coord_attribute));
+        InputTextureCoordinateName(tex_idx, name));
+    context->EnableVertexAttribArray(filter_tex_coord_attribute);
     GL_CALL(
         glVertexAttribPointer(filter_tex_coord_attribute, 2, GL_FLOAT, 0, 0,
                               GetTextureCoordinate(it->second.rotation_mode)));
@@ -261,13 +340,22 @@ const float* Filter::GetTextureCoordinate(
   }
 }
 
+void Filter::DoUpdateSinks() {
+  // The draw reading the inputs has been issued, so release them before the
+  // sinks render; an input nobody else reads goes back to the pool and can
+  // back one of their outputs
+  ResetAndClean();
+  Source::DoUpdateSinks();
+}
+
 void Filter::Render() {
   if (input_framebuffers_.empty()) {
     return;
   }
 
-  std::shared_ptr<GPUPixelFramebuffer> first_input_framebuffer =
-      input_framebuffers_.begin()->second.frame_buffer;
+  // Not a reference, so the input can go back to the pool during DoRender
+  GPUPixelFramebuffer* first_input_framebuffer =
+      input_framebuffers_.begin()->second.frame_buffer.get();
   RotationMode first_input_rotation =
       input_framebuffers_.begin()->second.rotation_mode;
   if (!first_input_framebuffer) {
@@ -287,15 +375,14 @@ void Filter::Render() {
     rotated_framebuffer_height =
         int(rotated_framebuffer_height * framebuffer_scale_);
   }
-  if (!framebuffer_ ||
-      (framebuffer_->GetWidth() != rotated_framebuffer_width ||
-       framebuffer_->GetHeight() != rotated_framebuffer_height)) {
-    framebuffer_ = GPUPixelContext::GetInstance()
-                       ->GetFramebufferFactory()
-                       ->CreateFramebuffer(rotated_framebuffer_width,
-                                           rotated_framebuffer_height);
-  }
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->GetProfiler()->BeginPass(this);
+  framebuffer_ = context->GetFramebufferFactory()->CreateFramebuffer(
+      rotated_framebuffer_width, rotated_framebuffer_height);
   DoRender(true);
+  // Normally already handed off and ended in DoUpdateSinks
+  ReleaseTransientFramebuffer();
+  context->GetProfiler()->EndPass(this);
 }
 
 bool Filter::RegisterProperty(
@@ -0,0 +1,92 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "filter/fused_color_filter.h"
+#include "core/gpupixel_context.h"
+#include "utils/util.h"
+
+namespace gpupixel {
+
+namespace {
+// What storing the color in an RGBA8 framebuffer and sampling it again does to
+// it: rounding to the nearest of 256 levels, ties to even as the float to
+// unorm conversion of the GPU does, and scaling back by a reciprocal
+const std::string kQuantize = R"(
+      level = clamp(color, 0.0, 1.0) * 255.0;
+      rounded = floor(level + 0.5);
+      rounded -= step(0.5, rounded - level) * mod(rounded, 2.0);
+      color = rounded * (1.0 / 255.0);
+)";
+}  // namespace
+
+std::shared_ptr<FusedColorFilter> FusedColorFilter::Create(
+    const std::vector<std::shared_ptr<Filter>>& stages) {
+  auto ret = std::shared_ptr<FusedColorFilter>(new FusedColorFilter());
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (ret && !ret->Init(stages)) {
+      ret.reset();
+    }
+  });
+  return ret;
+}
+
+bool FusedColorFilter::Init(
+    const std::vector<std::shared_ptr<Filter>>& stages) {
+  std::string shader = GetColorFunctionShaderHeader();
+  std::string body;
+  // Prepended to the names of each stage
+  std::vector<std::string> prefixes;
+  for (size_t i = 0; i < stages.size(); ++i) {
+    std::string glsl;
+    std::vector<std::string> names;
+    if (!stages[i]->GetColorFunction(glsl, names)) {
+      return false;
+    }
+    std::string prefix = Util::StringFormat("s%zu_", i);
+    // Renamed by the preprocessor, which leaves the GLSL of the stage as it is
+    names.push_back("Apply");
+    for (const auto& name : names) {
+      shader += "#define " + name + " " + prefix + name + "\n";
+    }
+    shader += glsl + "\n";
+    for (const auto& name : names) {
+      shader += "#undef " + name + "\n";
+    }
+
+    if (i > 0) {
+      body += kQuantize;
+    }
+    body += "      color = " + prefix + "Apply(color);\n";
+    prefixes.push_back(prefix);
+  }
+  shader += R"(
+    void main() {
+      vec4 color = texture2D(inputImageTexture, textureCoordinate);
+      vec4 level;
+      vec4 rounded;
+)" + body + R"(      gl_FragColor = color;
+    })";
+
+  if (!InitWithFragmentShaderString(shader)) {
+    return false;
+  }
+  for (size_t i = 0; i < stages.size(); ++i) {
+    stage_uniforms_.push_back(
+        stages[i]->ResolveColorUniforms(filter_program_, prefixes[i]));
+  }
+  stages_ = stages;
+  return true;
+}
+
+bool FusedColorFilter::DoRender(bool update_sinks) {
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    stages_[i]->SetColorUniforms(filter_program_, stage_uniforms_[i]);
+  }
+  return Filter::DoRender(update_sinks);
+}
+
+}  // namespace gpupixel
@@ -0,0 +1,45 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "gpupixel/filter/filter.h"
+
+namespace gpupixel {
+
+// One pass doing the work of a chain of point-wise color filters, built by
+// Pipeline and LutBakeFilter from the filters' color functions. The names each
+// function declares are renamed per stage, so stages of the same kind do not
+// collide, and every stage sets its uniforms from its filter each frame
+// through handles resolved when the pass is built.
+// Between stages the color is clamped and rounded to 8 bits, as the
+// framebuffers of the unfused chain store it, so that both give the same
+// pixels.
+class FusedColorFilter : public Filter {
+ public:
+  static std::shared_ptr<FusedColorFilter> Create(
+      const std::vector<std::shared_ptr<Filter>>& stages);
+
+  bool Init(const std::vector<std::shared_ptr<Filter>>& stages);
+  bool DoRender(bool update_sinks = true) override;
+
+  const std::vector<std::shared_ptr<Filter>>& GetStages() const {
+    return stages_;
+  }
+
+ private:
+  FusedColorFilter() {}
+
+  std::vector<std::shared_ptr<Filter>> stages_;
+  // Handles of the renamed uniforms of each stage
+  std::vector<std::vector<UniformHandle>> stage_uniforms_;
+};
+
+}  // namespace gpupixel
@@ -13,29 +13,24 @@ namespace gpupixel {
 // Adapted from
 // http://stackoverflow.com/questions/9234724/how-to-change-hue-of-a-texture-with-glsl
 // - see for code and discussion
-const std::string kHueFragmentShaderString = R"(
-    precision highp float; uniform sampler2D inputImageTexture;
-    uniform mediump float hueAdjustment;
-    varying highp vec2 textureCoordinate;
-    const highp vec4 kRGBToYPrime = vec4(0.299, 0.587, 0.114, 0.0);
-    const highp vec4 kRGBToI = vec4(0.595716, -0.274453, -0.321263, 0.0);
-    const highp vec4 kRGBToQ = vec4(0.211456, -0.522591, 0.31135, 0.0);
-    const highp vec4 kYIQToR = vec4(1.0, 0.9563, 0.6210, 0.0);
-    const highp vec4 kYIQToG = vec4(1.0, -0.2721, -0.6474, 0.0);
-    const highp vec4 kYIQToB = vec4(1.0, -1.1070, 1.7046, 0.0);
-
-    void main() {
-      // Sample the input pixel
-      highp vec4 color = texture2D(inputImageTexture, textureCoordinate);
-
+const std::string kHueColorFunction = R"(
+    uniform float hueAdjustment;
+    const vec4 kRGBToYPrime = vec4(0.299, 0.587, 0.114, 0.0);
+    const vec4 kRGBToI = vec4(0.595716, -0.274453, -0.321263, 0.0);
+    const vec4 kRGBToQ = vec4(0.211456, -0.522591, 0.31135, 0.0);
+    const vec4 kYIQToR = vec4(1.0, 0.9563, 0.6210, 0.0);
+    const vec4 kYIQToG = vec4(1.0, -0.2721, -0.6474, 0.0);
+    const vec4 kYIQToB = vec4(1.0, -1.1070, 1.7046, 0.0);
+
+    vec4 Apply(vec4 color) {
       // Convert to YIQ
-      highp float YPrime = dot(color, kRGBToYPrime);
-      highp float I = dot(color, kRGBToI);
-      highp float Q = dot(color, kRGBToQ);
+      float YPrime = dot(color, kRGBToYPrime);
+      float I = dot(color, kRGBToI);
+      float Q = dot(color, kRGBToQ);
 
       // Calculate the hue and chroma
-      highp float hue = atan(Q, I);
-      highp float chroma = sqrt(I * I + Q * Q);
+      float hue = atan(Q, I);
+      float chroma = sqrt(I * I + Q * Q);
 
       // Make the user's adjustments
       hue += (-hueAdjustment);  // why negative rotation?
@@ -45,13 +40,11 @@ const std::string kHueFragmentShaderString = R"(
       I = chroma * cos(hue);
 
       // Convert back to RGB
-      highp vec4 yIQ = vec4(YPrime, I, Q, 0.0);
+      vec4 yIQ = vec4(YPrime, I, Q, 0.0);
       color.r = dot(yIQ, kYIQToR);
       color.g = dot(yIQ, kYIQToG);
       color.b = dot(yIQ, kYIQToB);
-
-      // Save the result
-      gl_FragColor = color;
+      return color;
     })";
 
 std::shared_ptr<HueFilter> HueFilter::Create() {
@@ -65,9 +58,11 @@ std::shared_ptr<HueFilter> HueFilter::Create() {
 }
 
 bool HueFilter::Init() {
-  if (!InitWithFragmentShaderString(kHueFragmentShaderString)) {
+  if (!InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kHueColorFunction))) {
     return false;
   }
+  color_uniforms_ = ResolveColorUniforms(filter_program_, "");
 
   hue_adjustment_ = 90;
   RegisterProperty(
@@ -81,11 +76,29 @@ bool HueFilter::Init() {
 void HueFilter::setHueAdjustment(float hueAdjustment) {
   // Convert degrees to radians for hue rotation
   hue_adjustment_ = fmodf(hueAdjustment, 360.0) * M_PI / 180;
+  OnColorChanged();
 }
 
 bool HueFilter::DoRender(bool updateSinks) {
-  filter_program_->SetUniformValue("hueAdjustment", hue_adjustment_);
+  SetColorUniforms(filter_program_, color_uniforms_);
   return Filter::DoRender(updateSinks);
 }
 
+bool HueFilter::GetColorFunction(std::string& glsl,
+                                 std::vector<std::string>& names) const {
+  glsl = kHueColorFunction;
+  names = {"hueAdjustment", "kRGBToYPrime", "kRGBToI", "kRGBToQ",
+           "kYIQToR", "kYIQToG", "kYIQToB"};
+  return true;
+}
+
+std::vector<std::string> HueFilter::GetColorUniformNames() const {
+  return {"hueAdjustment"};
+}
+
+void HueFilter::SetColorUniforms(GPUPixelGLProgram* program,
+                                 const std::vector<UniformHandle>& uniforms) {
+  program->SetUniformValue(uniforms[0], hue_adjustment_);
+}
+
 }  // namespace gpupixel
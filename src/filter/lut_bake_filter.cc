@@ -0,0 +1,152 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/filter/lut_bake_filter.h"
+#include <cmath>
+#include "core/gpupixel_context.h"
+#include "filter/fused_color_filter.h"
+#include "utils/logging.h"
+
+namespace gpupixel {
+
+namespace {
+// Blue picks one of 8x8 tiles, red and green the texel within it
+constexpr int kLutLevels = 64;
+constexpr int kLutTiles = 8;
+constexpr int kLutSize = kLutLevels * kLutTiles;
+
+// Interpolates between the tiles of the two nearest blue levels, as the
+// lookup of the beauty filter does
+const std::string kLutLookupShaderString = R"(
+    uniform sampler2D lookupTexture;
+
+    void main() {
+      vec4 color =
+          clamp(texture2D(inputImageTexture, textureCoordinate), 0.0, 1.0);
+      float blue = color.b * 63.0;
+      vec2 quad1;
+      quad1.y = floor(floor(blue) / 8.0);
+      quad1.x = floor(blue) - quad1.y * 8.0;
+      vec2 quad2;
+      quad2.y = floor(ceil(blue) / 8.0);
+      quad2.x = ceil(blue) - quad2.y * 8.0;
+      vec2 offset = vec2(0.5 / 512.0) + (1.0 / 8.0 - 1.0 / 512.0) * color.rg;
+      vec3 color1 = texture2D(lookupTexture, quad1 / 8.0 + offset).rgb;
+      vec3 color2 = texture2D(lookupTexture, quad2 / 8.0 + offset).rgb;
+      gl_FragColor = vec4(mix(color1, color2, fract(blue)), color.a);
+    })";
+}  // namespace
+
+LutBakeFilter::LutBakeFilter() : bake_count_(0) {}
+
+LutBakeFilter::~LutBakeFilter() {}
+
+std::shared_ptr<LutBakeFilter> LutBakeFilter::Create(
+    const std::vector<std::shared_ptr<Filter>>& stages) {
+  auto ret = std::shared_ptr<LutBakeFilter>(new LutBakeFilter());
+  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
+    if (ret && !ret->Init(stages)) {
+      ret.reset();
+    }
+  });
+  return ret;
+}
+
+bool LutBakeFilter::Init(const std::vector<std::shared_ptr<Filter>>& stages) {
+  if (stages.empty()) {
+    LOG_ERROR("LutBakeFilter: no filters to bake");
+    return false;
+  }
+  std::string glsl;
+  std::vector<std::string> names;
+  for (const auto& stage : stages) {
+    if (!stage || !stage->GetColorFunction(glsl, names)) {
+      LOG_ERROR("LutBakeFilter: {} is not a color filter",
+                stage ? stage->GetFilterClassName() : "null");
+      return false;
+    }
+  }
+
+  if (!InitWithFragmentShaderString(GetColorFunctionShaderHeader() +
+                                    kLutLookupShaderString)) {
+    return false;
+  }
+  lookup_texture_uniform_ = filter_program_->GetUniformHandle("lookupTexture");
+
+  bake_filter_ = FusedColorFilter::Create(stages);
+  if (!bake_filter_) {
+    return false;
+  }
+
+  std::vector<uint8_t> identity((size_t)kLutSize * kLutSize * 4);
+  for (int y = 0; y < kLutSize; ++y) {
+    for (int x = 0; x < kLutSize; ++x) {
+      int levels[] = {x % kLutLevels, y % kLutLevels,
+                      y / kLutLevels * kLutTiles + x / kLutLevels};
+      uint8_t* texel = &identity[((size_t)y * kLutSize + x) * 4];
+      for (int i = 0; i < 3; ++i) {
+        texel[i] = (uint8_t)std::lround(levels[i] * 255.0 / (kLutLevels - 1));
+      }
+      texel[3] = 255;
+    }
+  }
+
+  // Held for the life of the filter, so kept out of the pool
+  auto factory = GPUPixelContext::GetInstance()->GetFramebufferFactory();
+  identity_lut_ = factory->CreateFramebuffer(kLutSize, kLutSize, true);
+  factory->RemoveFramebuffer(identity_lut_);
+  lut_ = factory->CreateFramebuffer(kLutSize, kLutSize);
+  factory->RemoveFramebuffer(lut_);
+
+  GPUPixelContext::GetInstance()->BindTexture(0, identity_lut_->GetTexture());
+  GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, kLutSize, kLutSize, 0,
+                       GL_RGBA, GL_UNSIGNED_BYTE, identity.data()));
+
+  stages_ = stages;
+  return true;
+}
+
+bool LutBakeFilter::IsStale() const {
+  if (baked_versions_.size() != stages_.size()) {
+    return true;
+  }
+  for (size_t i = 0; i < stages_.size(); ++i) {
+    if (stages_[i]->GetColorVersion() != baked_versions_[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void LutBakeFilter::Bake() {
+  // Versions are read first, so that a setting changed during the bake makes
+  // the next frame bake again
+  baked_versions_.clear();
+  for (const auto& stage : stages_) {
+    baked_versions_.push_back(stage->GetColorVersion());
+  }
+
+  bake_filter_->SetInputFramebuffer(identity_lut_, NoRotation, 0);
+  bake_filter_->SetFramebuffer(lut_);
+  bake_filter_->DoRender(false);
+  bake_filter_->SetFramebuffer(nullptr);
+  bake_filter_->ResetAndClean();
+  ++bake_count_;
+}
+
+bool LutBakeFilter::DoRender(bool update_sinks) {
+  if (IsStale()) {
+    Bake();
+  }
+
+  // Unit 0 is the input
+  GPUPixelContext::GetInstance()->BindTexture(1, lut_->GetTexture());
+  filter_program_->SetUniformValue(lookup_texture_uniform_, 1);
+  return Filter::DoRender(update_sinks);
+}
+
+}  // namespace gpupixel
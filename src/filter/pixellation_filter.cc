@@ -58,8 +58,8 @@ void PixellationFilter::setPixelSize(float pixelSize) {
 
 bool PixellationFilter::DoRender(bool updateSinks) {
   float aspectRatio = 1.0;
-  std::shared_ptr<GPUPixelFramebuffer> firstInputFramebuffer =
-      input_framebuffers_.begin()->second.frame_buffer;
+  GPUPixelFramebuffer* firstInputFramebuffer =
+      input_framebuffers_.begin()->second.frame_buffer.get();
   aspectRatio = firstInputFramebuffer->GetHeight() /
                 (float)(firstInputFramebuffer->GetWidth());
   filter_program_->SetUniformValue("aspectRatio", aspectRatio);
@@ -9,16 +9,14 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
-const std::string kRGBFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform highp float redAdjustment;
-    uniform highp float greenAdjustment;
-    uniform highp float blueAdjustment;
-    varying highp vec2 textureCoordinate;
-
-    void main() {
-      lowp vec4 color = texture2D(inputImageTexture, textureCoordinate);
-      gl_FragColor = vec4(color.r * redAdjustment, color.g * greenAdjustment,
-                          color.b * blueAdjustment, color.a);
+const std::string kRGBColorFunction = R"(
+    uniform float redAdjustment;
+    uniform float greenAdjustment;
+    uniform float blueAdjustment;
+
+    vec4 Apply(vec4 color) {
+      return vec4(color.r * redAdjustment, color.g * greenAdjustment,
+                  color.b * blueAdjustment, color.a);
     })";
 
 std::shared_ptr<RGBFilter> RGBFilter::Create() {
@@ -32,9 +30,11 @@ std::shared_ptr<RGBFilter> RGBFilter::Create() {
 }
 
 bool RGBFilter::Init() {
-  if (!InitWithFragmentShaderString(kRGBFragmentShaderString)) {
+  if (!InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kRGBColorFunction))) {
     return false;
   }
+  color_uniforms_ = ResolveColorUniforms(filter_program_, "");
 
   red_adjustment_ = 1.0;
   green_adjustment_ = 1.0;
@@ -68,6 +68,7 @@ void RGBFilter::setRedAdjustment(float redAdjustment) {
   if (red_adjustment_ < 0.0) {
     red_adjustment_ = 0.0;
   }
+  OnColorChanged();
 }
 
 void RGBFilter::setGreenAdjustment(float greenAdjustment) {
@@ -75,6 +76,7 @@ void RGBFilter::setGreenAdjustment(float greenAdjustment) {
   if (green_adjustment_ < 0.0) {
     green_adjustment_ = 0.0;
   }
+  OnColorChanged();
 }
 
 void RGBFilter::setBlueAdjustment(float blueAdjustment) {
@@ -82,12 +84,29 @@ void RGBFilter::setBlueAdjustment(float blueAdjustment) {
   if (blue_adjustment_ < 0.0) {
     blue_adjustment_ = 0.0;
   }
+  OnColorChanged();
 }
 bool RGBFilter::DoRender(bool updateSinks) {
-  filter_program_->SetUniformValue("redAdjustment", red_adjustment_);
-  filter_program_->SetUniformValue("greenAdjustment", green_adjustment_);
-  filter_program_->SetUniformValue("blueAdjustment", blue_adjustment_);
+  SetColorUniforms(filter_program_, color_uniforms_);
   return Filter::DoRender(updateSinks);
 }
 
+bool RGBFilter::GetColorFunction(std::string& glsl,
+                                 std::vector<std::string>& names) const {
+  glsl = kRGBColorFunction;
+  names = {"redAdjustment", "greenAdjustment", "blueAdjustment"};
+  return true;
+}
+
+std::vector<std::string> RGBFilter::GetColorUniformNames() const {
+  return {"redAdjustment", "greenAdjustment", "blueAdjustment"};
+}
+
+void RGBFilter::SetColorUniforms(GPUPixelGLProgram* program,
+                                 const std::vector<UniformHandle>& uniforms) {
+  program->SetUniformValue(uniforms[0], red_adjustment_);
+  program->SetUniformValue(uniforms[1], green_adjustment_);
+  program->SetUniformValue(uniforms[2], blue_adjustment_);
+}
+
 }  // namespace gpupixel
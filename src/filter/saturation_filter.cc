@@ -9,20 +9,18 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
-const std::string kSaturationFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform lowp float saturation;
-    varying highp vec2 textureCoordinate;
+const std::string kSaturationColorFunction = R"(
+    uniform float saturation;
 
     // Values from "Graphics Shaders: Theory and Practice" by Bailey and
     // Cunningham
-    const mediump vec3 luminanceWeighting = vec3(0.2125, 0.7154, 0.0721);
+    const vec3 luminanceWeighting = vec3(0.2125, 0.7154, 0.0721);
 
-    void main() {
-      lowp vec4 color = texture2D(inputImageTexture, textureCoordinate);
-      lowp float luminance = dot(color.rgb, luminanceWeighting);
-      lowp vec3 greyScaleColor = vec3(luminance);
+    vec4 Apply(vec4 color) {
+      float luminance = dot(color.rgb, luminanceWeighting);
+      vec3 greyScaleColor = vec3(luminance);
 
-      gl_FragColor = vec4(mix(greyScaleColor, color.rgb, saturation), color.a);
+      return vec4(mix(greyScaleColor, color.rgb, saturation), color.a);
     })";
 
 std::shared_ptr<SaturationFilter> SaturationFilter::Create() {
@@ -36,9 +34,11 @@ std::shared_ptr<SaturationFilter> SaturationFilter::Create() {
 }
 
 bool SaturationFilter::Init() {
-  if (!InitWithFragmentShaderString(kSaturationFragmentShaderString)) {
+  if (!InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kSaturationColorFunction))) {
     return false;
   }
+  color_uniforms_ = ResolveColorUniforms(filter_program_, "");
 
   saturation_ = 1.0;
   RegisterProperty(
@@ -57,11 +57,29 @@ void SaturationFilter::setSaturation(float saturation) {
   } else if (saturation_ < 0.0) {
     saturation_ = 0.0;
   }
+  OnColorChanged();
 }
 
 bool SaturationFilter::DoRender(bool updateSinks) {
-  filter_program_->SetUniformValue("saturation", saturation_);
+  SetColorUniforms(filter_program_, color_uniforms_);
   return Filter::DoRender(updateSinks);
 }
 
+bool SaturationFilter::GetColorFunction(std::string& glsl,
+                                        std::vector<std::string>& names) const {
+  glsl = kSaturationColorFunction;
+  names = {"saturation", "luminanceWeighting"};
+  return true;
+}
+
+std::vector<std::string> SaturationFilter::GetColorUniformNames() const {
+  return {"saturation"};
+}
+
+void SaturationFilter::SetColorUniforms(
+    GPUPixelGLProgram* program,
+    const std::vector<UniformHandle>& uniforms) {
+  program->SetUniformValue(uniforms[0], saturation_);
+}
+
 }  // namespace gpupixel
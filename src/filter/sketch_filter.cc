@@ -107,8 +107,6 @@ bool _SketchFilter::DoRender(bool updateSinks) {
   float texelWidth = 1.0 / framebuffer_->GetWidth();
   float texelHeight = 1.0 / framebuffer_->GetHeight();
 
-  std::shared_ptr<GPUPixelFramebuffer> inputFramebuffer =
-      input_framebuffers_.begin()->second.frame_buffer;
   RotationMode inputRotation =
       input_framebuffers_.begin()->second.rotation_mode;
   if (rotationSwapsSize(inputRotation)) {
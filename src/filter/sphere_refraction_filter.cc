@@ -127,8 +127,8 @@ bool SphereRefractionFilter::DoRender(bool updateSinks) {
   filter_program_->SetUniformValue("refractiveIndex", refractive_index_);
 
   float aspectRatio = 1.0;
-  std::shared_ptr<GPUPixelFramebuffer> firstInputFramebuffer =
-      input_framebuffers_.begin()->second.frame_buffer;
+  GPUPixelFramebuffer* firstInputFramebuffer =
+      input_framebuffers_.begin()->second.frame_buffer.get();
   aspectRatio = firstInputFramebuffer->GetHeight() /
                 (float)(firstInputFramebuffer->GetWidth());
   filter_program_->SetUniformValue("aspectRatio", aspectRatio);
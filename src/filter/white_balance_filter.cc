@@ -9,26 +9,24 @@
 #include "core/gpupixel_context.h"
 namespace gpupixel {
 
-const std::string kWhiteBalanceFragmentShaderString = R"(
-    uniform sampler2D inputImageTexture; uniform lowp float temperature;
-    uniform lowp float tint;
-    varying highp vec2 textureCoordinate;
-    const lowp vec3 warmFilter = vec3(0.93, 0.54, 0.0);
-    const mediump mat3 RGBtoYIQ =
+const std::string kWhiteBalanceColorFunction = R"(
+    uniform float temperature;
+    uniform float tint;
+    const vec3 warmFilter = vec3(0.93, 0.54, 0.0);
+    const mat3 RGBtoYIQ =
         mat3(0.299, 0.587, 0.114,
              0.596, -0.274, -0.322,
              0.212, -0.523, 0.311);
-    const mediump mat3 YIQtoRGB =
+    const mat3 YIQtoRGB =
         mat3(1.0, 0.956, 0.621,
              1.0, -0.272, -0.647,
              1.0, -1.105, 1.702);
 
-    void main() {
-      lowp vec4 color = texture2D(inputImageTexture, textureCoordinate);
-      mediump vec3 yiq = RGBtoYIQ * color.rgb;  // adjusting tint
+    vec4 Apply(vec4 color) {
+      vec3 yiq = RGBtoYIQ * color.rgb;  // adjusting tint
       yiq.b = clamp(yiq.b + tint * 0.5226 * 0.1, -0.5226, 0.5226);
-      lowp vec3 rgb = YIQtoRGB * yiq;
-      lowp vec3 processed = vec3(
+      vec3 rgb = YIQtoRGB * yiq;
+      vec3 processed = vec3(
           (rgb.r < 0.5
                ? (2.0 * rgb.r * warmFilter.r)
                : (1.0 - 2.0 * (1.0 - rgb.r) *
@@ -38,7 +36,7 @@ const std::string kWhiteBalanceFragmentShaderString = R"(
           (rgb.b < 0.5 ? (2.0 * rgb.b * warmFilter.b)
                        : (1.0 - 2.0 * (1.0 - rgb.b) * (1.0 - warmFilter.b))));
 
-      gl_FragColor = vec4(mix(rgb, processed, temperature), color.a);
+      return vec4(mix(rgb, processed, temperature), color.a);
     })";
 
 std::shared_ptr<WhiteBalanceFilter> WhiteBalanceFilter::Create() {
@@ -52,9 +50,11 @@ std::shared_ptr<WhiteBalanceFilter> WhiteBalanceFilter::Create() {
 }
 
 bool WhiteBalanceFilter::Init() {
-  if (!InitWithFragmentShaderString(kWhiteBalanceFragmentShaderString)) {
+  if (!InitWithFragmentShaderString(
+          GetColorFunctionShaderString(kWhiteBalanceColorFunction))) {
     return false;
   }
+  color_uniforms_ = ResolveColorUniforms(filter_program_, "");
 
   setTemperature(5000.0);
   RegisterProperty(
@@ -75,16 +75,36 @@ bool WhiteBalanceFilter::Init() {
 void WhiteBalanceFilter::setTemperature(float temperature) {
   temperature_ = temperature < 5000 ? 0.0004 * (temperature - 5000.0)
                                     : 0.00006 * (temperature - 5000.0);
+  OnColorChanged();
 }
 
 void WhiteBalanceFilter::setTint(float tint) {
   tint_ = tint / 100.0;
+  OnColorChanged();
 }
 
 bool WhiteBalanceFilter::DoRender(bool updateSinks) {
-  filter_program_->SetUniformValue("temperature", temperature_);
-  filter_program_->SetUniformValue("tint", tint_);
+  SetColorUniforms(filter_program_, color_uniforms_);
   return Filter::DoRender(updateSinks);
 }
 
+bool WhiteBalanceFilter::GetColorFunction(
+    std::string& glsl,
+    std::vector<std::string>& names) const {
+  glsl = kWhiteBalanceColorFunction;
+  names = {"temperature", "tint", "warmFilter", "RGBtoYIQ", "YIQtoRGB"};
+  return true;
+}
+
+std::vector<std::string> WhiteBalanceFilter::GetColorUniformNames() const {
+  return {"temperature", "tint"};
+}
+
+void WhiteBalanceFilter::SetColorUniforms(
+    GPUPixelGLProgram* program,
+    const std::vector<UniformHandle>& uniforms) {
+  program->SetUniformValue(uniforms[0], temperature_);
+  program->SetUniformValue(uniforms[1], tint_);
+}
+
 }  // namespace gpupixel
@@ -100,10 +100,11 @@ using namespace gpupixel;
     colorMapUniformLocation =
         displayProgram->GetUniformLocation("inputImageTexture");
 
-    gpupixel::GPUPixelContext::GetInstance()->SetActiveGlProgram(
-        displayProgram);
-    glEnableVertexAttribArray(positionAttribLocation);
-    glEnableVertexAttribArray(texCoordAttribLocation);
+    gpupixel::GPUPixelContext* context =
+        gpupixel::GPUPixelContext::GetInstance();
+    context->SetActiveGlProgram(displayProgram);
+    context->EnableVertexAttribArray(positionAttribLocation);
+    context->EnableVertexAttribArray(texCoordAttribLocation);
 
     [self setBackgroundColorRed:0.0 green:0.0 blue:0.0 alpha:0.0];
     _fillMode = gpupixel::SinkRender::FillMode::PreserveAspectRatio;
@@ -162,7 +163,8 @@ using namespace gpupixel;
     lastBoundsSize = currentFrame.size;
 
     glGenFramebuffers(1, &displayFramebuffer);
-    glBindFramebuffer(GL_FRAMEBUFFER, displayFramebuffer);
+    gpupixel::GPUPixelContext::GetInstance()->BindFramebuffer(
+        displayFramebuffer);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
                               GL_RENDERBUFFER, displayRenderbuffer);
 
@@ -190,6 +192,8 @@ using namespace gpupixel;
 #if defined(GPUPIXEL_IOS)
     if (displayFramebuffer) {
       glDeleteFramebuffers(1, &displayFramebuffer);
+      gpupixel::GPUPixelContext::GetInstance()->OnFramebufferDeleted(
+          displayFramebuffer);
       displayFramebuffer = 0;
     }
 
@@ -211,14 +215,19 @@ using namespace gpupixel;
   }
 
   gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
-      glBindFramebuffer(GL_FRAMEBUFFER, displayFramebuffer);
-      glViewport(0, 0, framebufferWidth, framebufferHeight);
+    gpupixel::GPUPixelContext* context =
+        gpupixel::GPUPixelContext::GetInstance();
+    context->BindFramebuffer(displayFramebuffer);
+    context->SetViewport(0, 0, framebufferWidth, framebufferHeight);
   });
 #else
   gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gpupixel::GPUPixelContext* context =
+        gpupixel::GPUPixelContext::GetInstance();
+    context->BindFramebuffer(0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glViewport(0, 0, self.sizeInPixels.width, self.sizeInPixels.height);
+    context->SetViewport(0, 0, self.sizeInPixels.width,
+                         self.sizeInPixels.height);
   });
 #endif
 }
@@ -247,20 +256,20 @@ using namespace gpupixel;
 
 - (void)DoRender {
   gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
-    gpupixel::GPUPixelContext::GetInstance()->SetActiveGlProgram(
-        displayProgram);
+    gpupixel::GPUPixelContext* context =
+        gpupixel::GPUPixelContext::GetInstance();
+    context->SetActiveGlProgram(displayProgram);
     [self setDisplayFramebuffer];
-    glClearColor(backgroundColorRed, backgroundColorGreen, backgroundColorBlue,
-                 backgroundColorAlpha);
+    context->SetClearColor(backgroundColorRed, backgroundColorGreen,
+                           backgroundColorBlue, backgroundColorAlpha);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 #if defined(GPUPIXEL_MAC)
     // Re-render onscreen, flipped to a normal orientation
-    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    context->BindFramebuffer(0);
     GL_CALL(glBindRenderbuffer(GL_RENDERBUFFER, 0));
 #endif
-    GL_CALL(glActiveTexture(GL_TEXTURE0));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, inputFramebuffer->GetTexture()));
-    GL_CALL(glUniform1i(colorMapUniformLocation, 0));
+    context->BindTexture(0, inputFramebuffer->GetTexture());
+    displayProgram->SetUniformValue((int)colorMapUniformLocation, 0);
 
     GL_CALL(glVertexAttribPointer(positionAttribLocation, 2, GL_FLOAT, 0, 0,
                                   displayVertices));
@@ -274,7 +283,7 @@ using namespace gpupixel;
     [[self openGLContext] makeCurrentContext];
     GL_CALL(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
     [self presentFramebuffer];
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+    context->BindTexture(0, 0);
 #endif
   });
 }
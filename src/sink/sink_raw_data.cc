@@ -10,11 +10,13 @@
 #include <cstring>
 #include "core/gpupixel_context.h"
 #include "libyuv.h"
+#include "utils/logging.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
 namespace gpupixel {
 
-const std::string kRGBToI420VertexShaderString = R"(
+const std::string kVertexShaderString = R"(
     attribute vec4 position;
     attribute vec4 inputTextureCoordinate;
     varying vec2 textureCoordinate;
@@ -25,14 +27,14 @@ const std::string kRGBToI420VertexShaderString = R"(
     })";
 
 #if defined(GPUPIXEL_GLES_SHADER)
-const std::string kRGBToI420FragmentShaderString = R"(
+const std::string kFragmentShaderString = R"(
     varying mediump vec2 textureCoordinate;
     uniform sampler2D sTexture;
     void main() {
       gl_FragColor = texture2D(sTexture, textureCoordinate);
     })";
 #elif defined(GPUPIXEL_GL_SHADER)
-const std::string kRGBToI420FragmentShaderString = R"(
+const std::string kFragmentShaderString = R"(
     varying vec2 textureCoordinate;
     uniform sampler2D sTexture;
     void main() {
@@ -40,6 +42,98 @@ const std::string kRGBToI420FragmentShaderString = R"(
     })";
 #endif
 
+const std::string kRGBToYUVVertexShaderString = R"(
+    attribute vec4 position;
+
+    void main() {
+      gl_Position = position;
+    })";
+
+// Packs the frame as I420 or NV12 into an RGBA target a quarter as wide and
+// one and a half times as tall, four bytes of a plane row per texel, so that
+// reading the target back gives the planes one after the other. Computes Y,
+// U and V as libyuv does, U and V from the average of 2x2 pixels, which the
+// input's linear filtering takes.
+const std::string kRGBToYUVFragmentShaderString = R"(
+    #ifdef GL_ES
+    precision highp float;
+    #endif
+    uniform sampler2D inputImageTexture;
+    // Of the input, in pixels
+    uniform vec2 size;
+    // NV12 rather than I420
+    uniform float interleaved;
+
+    vec3 Texel(float x, float y) {
+      vec3 color = texture2D(inputImageTexture, (vec2(x, y) + 0.5) / size).rgb;
+      return floor(color * 255.0 + 0.5);
+    }
+
+    float Luma(float x, float y) {
+      vec3 c = Texel(x, y);
+      return floor((dot(c, vec3(66.0, 129.0, 25.0)) + 128.0) / 256.0) + 16.0;
+    }
+
+    // U, or V, of chroma sample (x, y). One linear fetch between the 2x2
+    // pixels averages them.
+    float Chroma(float x, float y, bool v) {
+      vec2 corner = vec2(x, y) * 2.0 + 1.0;
+      vec3 c = floor(
+          texture2D(inputImageTexture, corner / size).rgb * 255.0 + 0.5);
+      vec3 weights = v ? vec3(112.0, -94.0, -18.0) : vec3(-38.0, -74.0, 112.0);
+      return floor((dot(c, weights) + 32896.0) / 256.0);
+    }
+
+    // Byte x of row y of the planes
+    float Byte(float x, float y) {
+      if (y < size.y) {
+        return Luma(x, y);
+      }
+      float row = y - size.y;
+      if (interleaved > 0.5) {
+        float pair = floor(x / 2.0);
+        return Chroma(pair, row, x - 2.0 * pair > 0.5);
+      }
+      // U then V, two chroma rows to a row
+      float quarter = size.y / 4.0;
+      bool v = row >= quarter;
+      row = 2.0 * (v ? row - quarter : row);
+      float half_width = size.x / 2.0;
+      if (x >= half_width) {
+        x -= half_width;
+        row += 1.0;
+      }
+      return Chroma(x, row, v);
+    }
+
+    void main() {
+      vec2 texel = floor(gl_FragCoord.xy);
+      float x = texel.x * 4.0;
+      gl_FragColor = vec4(Byte(x, texel.y), Byte(x + 1.0, texel.y),
+                          Byte(x + 2.0, texel.y), Byte(x + 3.0, texel.y)) /
+                     255.0;
+    })";
+
+namespace {
+// How long a blocking wait for a readback fence waits before checking again
+constexpr uint64_t kReadbackWaitNs = 100 * 1000 * 1000;
+
+// Pixel positions of 4K frames and the sums of the conversion need more than
+// the 10 bits of mediump
+bool HasHighpFragmentFloat() {
+#if defined(GPUPIXEL_ANDROID) || defined(GPUPIXEL_IOS) || \
+    defined(GPUPIXEL_WASM)
+  GLint range[2] = {0, 0};
+  GLint precision = 0;
+  glGetShaderPrecisionFormat(GL_FRAGMENT_SHADER, GL_HIGH_FLOAT, range,
+                             &precision);
+  return precision >= 23;
+#else
+  return true;
+#endif
+}
+}  // namespace
+
 std::shared_ptr<SinkRawData> SinkRawData::Create() {
   std::shared_ptr<SinkRawData> ret;
   gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext(
@@ -47,12 +141,23 @@ std::shared_ptr<SinkRawData> SinkRawData::Create() {
   return ret;
 }
 
-SinkRawData::SinkRawData() {
-  InitWithShaderString(kRGBToI420VertexShaderString,
-                       kRGBToI420FragmentShaderString);
+SinkRawData::SinkRawData() : context_(GPUPixelContext::GetInstance()) {
+  InitWithShaderString(kVertexShaderString, kFragmentShaderString);
+  if (HasHighpFragmentFloat()) {
+    yuv_program_ = GPUPixelGLProgram::CreateWithShaderString(
+        kRGBToYUVVertexShaderString, kRGBToYUVFragmentShaderString);
+    yuv_position_attribute_ = yuv_program_->GetAttribLocation("position");
+  }
 }
 
 SinkRawData::~SinkRawData() {
+  context_->SyncRunWithContext([=] {
+    // Frames still in flight are dropped
+    ReleaseReadbackRing();
+    delete shader_program_;
+    delete yuv_program_;
+  });
+
   // Clean up RGBA frame buffer
   if (rgba_buffer_ != nullptr) {
     delete[] rgba_buffer_;
@@ -64,6 +169,11 @@ SinkRawData::~SinkRawData() {
     delete[] yuv_buffer_;
   }
   yuv_buffer_ = nullptr;
+
+  if (nv12_buffer_ != nullptr) {
+    delete[] nv12_buffer_;
+  }
+  nv12_buffer_ = nullptr;
 }
 
 void SinkRawData::Render() {
@@ -80,12 +190,10 @@ void SinkRawData::Render() {
     InitOutputBuffer(width, height);
   }
 
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(shader_program_);
+  context_->SetActiveGlProgram(shader_program_);
   framebuffer_->Activate();
 
-  GL_CALL(glViewport(0, 0, width_, height_));
-
-  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  context_->SetClearColor(0.0f, 0.0f, 0.0f, 1.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
   float image_vertices[] = {
@@ -99,23 +207,142 @@ void SinkRawData::Render() {
       0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,
   };
 
-  GL_CALL(glEnableVertexAttribArray(position_attribute_));
+  context_->EnableVertexAttribArray(position_attribute_);
   GL_CALL(glVertexAttribPointer(position_attribute_, 2, GL_FLOAT, 0, 0,
                                 image_vertices));
 
-  GL_CALL(glEnableVertexAttribArray(tex_coord_attribute_));
+  context_->EnableVertexAttribArray(tex_coord_attribute_);
   GL_CALL(glVertexAttribPointer(tex_coord_attribute_, 2, GL_FLOAT, 0, 0,
                                 texture_vertices));
 
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D,
-                input_framebuffers_[0].frame_buffer->GetTexture());
+  context_->BindTexture(0, input_framebuffers_[0].frame_buffer->GetTexture());
 
   GL_CALL(shader_program_->SetUniformValue("sTexture", 0));
   // Draw frame buffer
   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
   framebuffer_->Deactivate();
+
+  ++frame_count_;
+  if (!readback_ring_.empty()) {
+    DeliverReadbacks(false);
+    IssueReadback();
+  }
+}
+
+bool SinkRawData::SetAsyncReadback(ReadbackCallback callback, int buffers) {
+  bool enable = callback && buffers > 0;
+  bool supported = !enable || context_->SupportsPixelBuffers();
+  context_->SyncRunWithContext([&] {
+    // Frames in flight go to the callback they were read for
+    DeliverReadbacks(true);
+    ReleaseReadbackRing();
+    readback_callback_ = nullptr;
+    if (enable && supported) {
+      readback_ring_.resize(buffers);
+      readback_callback_ = callback;
+    }
+  });
+  return supported;
+}
+
+void SinkRawData::FlushAsyncReadback() {
+  context_->SyncRunWithContext([=] { DeliverReadbacks(true); });
+}
+
+void SinkRawData::IssueReadback() {
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+  TraceScope readback_scope("async readback", "io");
+  ReadbackBuffer& readback = readback_ring_[next_readback_];
+  if (readback.fence) {
+    // The GPU is a whole ring behind. Waiting for the oldest frame would
+    // block the GL thread, so this one is not read back.
+    ++dropped_readbacks_;
+    return;
+  }
+
+  size_t size = (size_t)width_ * height_ * 4;
+  if (!readback.buffer) {
+    GL_CALL(glGenBuffers(1, &readback.buffer));
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer));
+  if (readback.size < size) {
+    GL_CALL(
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ));
+    readback.size = size;
+  }
+  framebuffer_->Activate();
+  // Into the bound buffer, returning before the GPU has drawn the frame
+  GL_CALL(glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
+                       nullptr));
+  framebuffer_->Deactivate();
+  GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+
+  readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  readback.width = width_;
+  readback.height = height_;
+  readback.frame = frame_count_;
+  next_readback_ = (next_readback_ + 1) % readback_ring_.size();
+#endif
+}
+
+void SinkRawData::DeliverReadbacks(bool wait) {
+  for (size_t i = 0; i < readback_ring_.size(); ++i) {
+    ReadbackBuffer& readback =
+        readback_ring_[(next_readback_ + i) % readback_ring_.size()];
+    if (readback.fence && !DeliverReadback(readback, wait)) {
+      return;
+    }
+  }
+}
+
+bool SinkRawData::DeliverReadback(ReadbackBuffer& readback, bool wait) {
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+  GLsync fence = (GLsync)readback.fence;
+  // Flushing makes sure the fence reaches the GPU, or it would never signal
+  GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                   wait ? kReadbackWaitNs : 0);
+  while (wait && status == GL_TIMEOUT_EXPIRED) {
+    status = glClientWaitSync(fence, 0, kReadbackWaitNs);
+  }
+  if (status == GL_TIMEOUT_EXPIRED) {
+    return false;
+  }
+  if (status == GL_WAIT_FAILED) {
+    LOG_ERROR("SinkRawData: waiting for readback fence failed");
+  }
+  glDeleteSync(fence);
+  readback.fence = nullptr;
+
+  TraceScope deliver("readback delivery", "io");
+  GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer));
+  auto rgba = (const uint8_t*)glMapBufferRange(
+      GL_PIXEL_PACK_BUFFER, 0, (size_t)readback.width * readback.height * 4,
+      GL_MAP_READ_BIT);
+  if (rgba) {
+    readback_callback_(rgba, readback.width, readback.height, readback.frame);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  } else {
+    LOG_ERROR("SinkRawData: mapping readback buffer failed");
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+#endif
+  return true;
+}
+
+void SinkRawData::ReleaseReadbackRing() {
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+  for (ReadbackBuffer& readback : readback_ring_) {
+    if (readback.fence) {
+      glDeleteSync((GLsync)readback.fence);
+    }
+    if (readback.buffer) {
+      glDeleteBuffers(1, &readback.buffer);
+    }
+  }
+#endif
+  readback_ring_.clear();
+  next_readback_ = 0;
 }
 
 bool SinkRawData::InitWithShaderString(
@@ -132,6 +359,7 @@ bool SinkRawData::InitWithShaderString(
 }
 
 int SinkRawData::RenderToOutput() {
+  TraceScope readback("readback", "io");
   framebuffer_->Activate();
 
   // Read pixel data directly using glReadPixels
@@ -143,22 +371,73 @@ int SinkRawData::RenderToOutput() {
 }
 
 const uint8_t* SinkRawData::GetRgbaBuffer() {
-  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext(
-      [&] { RenderToOutput(); });
+  context_->SyncRunWithContext([&] { RenderToOutput(); });
   return rgba_buffer_;
 }
 
 const uint8_t* SinkRawData::GetI420Buffer() {
-  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext(
-      [=] { RenderToOutput(); });
+  context_->SyncRunWithContext([=] {
+    if (ConvertToYUV(false, yuv_buffer_)) {
+      return;
+    }
+    RenderToOutput();
+    // libyuv's ABGR is R, G, B, A in memory
+    libyuv::ABGRToI420(rgba_buffer_, width_ * 4, yuv_buffer_, width_,
+                       yuv_buffer_ + width_ * height_, width_ / 2,
+                       yuv_buffer_ + width_ * height_ * 5 / 4, width_ / 2,
+                       width_, height_);
+  });
+  return yuv_buffer_;
+}
 
-  // Convert RGBA to I420 format
-  libyuv::ARGBToI420(rgba_buffer_, width_ * 4, yuv_buffer_, width_,
-                     yuv_buffer_ + width_ * height_, width_ / 2,
-                     yuv_buffer_ + width_ * height_ * 5 / 4, width_ / 2, width_,
-                     height_);
+const uint8_t* SinkRawData::GetNV12Buffer() {
+  context_->SyncRunWithContext([=] {
+    if (ConvertToYUV(true, nv12_buffer_)) {
+      return;
+    }
+    RenderToOutput();
+    libyuv::ABGRToNV12(rgba_buffer_, width_ * 4, nv12_buffer_, width_,
+                       nv12_buffer_ + width_ * height_, width_, width_,
+                       height_);
+  });
+  return nv12_buffer_;
+}
 
-  return yuv_buffer_;
+bool SinkRawData::ConvertToYUV(bool nv12, uint8_t* output) {
+  if (!yuv_program_ || !framebuffer_ || width_ % 8 != 0 ||
+      height_ % 4 != 0) {
+    return false;
+  }
+  TraceScope readback("yuv readback", "io");
+  int target_width = width_ / 4;
+  int target_height = height_ * 3 / 2;
+  if (!yuv_framebuffer_ || yuv_framebuffer_->GetWidth() != target_width ||
+      yuv_framebuffer_->GetHeight() != target_height) {
+    yuv_framebuffer_ = context_->GetFramebufferFactory()->CreateFramebuffer(
+        target_width, target_height);
+  }
+
+  context_->SetActiveGlProgram(yuv_program_);
+  yuv_framebuffer_->Activate();
+
+  float image_vertices[] = {
+      -1.0, -1.0, 1.0, -1.0, -1.0, 1.0, 1.0, 1.0,
+  };
+  context_->EnableVertexAttribArray(yuv_position_attribute_);
+  GL_CALL(glVertexAttribPointer(yuv_position_attribute_, 2, GL_FLOAT, 0, 0,
+                                image_vertices));
+
+  context_->BindTexture(0, framebuffer_->GetTexture());
+  yuv_program_->SetUniformValue("inputImageTexture", 0);
+  yuv_program_->SetUniformValue("size", Vector2(width_, height_));
+  yuv_program_->SetUniformValue("interleaved", nv12 ? 1.0f : 0.0f);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  // 1.5 bytes a pixel rather than the 4 of RGBA
+  GL_CALL(glReadPixels(0, 0, target_width, target_height, GL_RGBA,
+                       GL_UNSIGNED_BYTE, output));
+  yuv_framebuffer_->Deactivate();
+  return true;
 }
 
 void SinkRawData::InitOutputBuffer(int width, int height) {
@@ -178,6 +457,13 @@ void SinkRawData::InitOutputBuffer(int width, int height) {
   }
   yuv_buffer_ = new uint8_t[yuv_size];
   std::memset(yuv_buffer_, 0, yuv_size);
+
+  // Allocate NV12 frame buffer
+  if (nv12_buffer_ != nullptr) {
+    delete[] nv12_buffer_;
+  }
+  nv12_buffer_ = new uint8_t[yuv_size];
+  std::memset(nv12_buffer_, 0, yuv_size);
 }
 
 void SinkRawData::InitFramebuffer(int width, int height) {
@@ -49,9 +49,10 @@ void SinkRender::Init() {
       display_program_->GetAttribLocation("inputTextureCoordinate");
   color_map_uniform_location_ =
       display_program_->GetUniformLocation("textureCoordinate");
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(display_program_);
-  GL_CALL(glEnableVertexAttribArray(position_attribute_location_));
-  GL_CALL(glEnableVertexAttribArray(tex_coord_attribute_location_));
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->SetActiveGlProgram(display_program_);
+  context->EnableVertexAttribArray(position_attribute_location_);
+  context->EnableVertexAttribArray(tex_coord_attribute_location_);
 };
 
 void SinkRender::SetInputFramebuffer(
@@ -98,21 +99,20 @@ void SinkRender::SetRenderSize(int width, int height) {
 }
 
 void SinkRender::Render() {
-  GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+  GPUPixelContext* context = GPUPixelContext::GetInstance();
+  context->BindFramebuffer(0);
 
   if (view_width_ == 0 || view_height_ == 0) {
     LOG_WARN("SinkRender: view_width_ or view_height_ is 0");
     return;
   }
-  GL_CALL(glViewport(0, 0, view_width_, view_height_));
-  GL_CALL(glClearColor(background_color_.r, background_color_.g,
-                       background_color_.b, background_color_.a));
+  context->SetViewport(0, 0, view_width_, view_height_);
+  context->SetClearColor(background_color_.r, background_color_.g,
+                         background_color_.b, background_color_.a);
   GL_CALL(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(display_program_);
-  GL_CALL(glActiveTexture(GL_TEXTURE0));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D,
-                        input_framebuffers_[0].frame_buffer->GetTexture()));
-  GL_CALL(glUniform1i(color_map_uniform_location_, 0));
+  context->SetActiveGlProgram(display_program_);
+  context->BindTexture(0, input_framebuffers_[0].frame_buffer->GetTexture());
+  display_program_->SetUniformValue(color_map_uniform_location_, 0);
   GL_CALL(glVertexAttribPointer(position_attribute_location_, 2, GL_FLOAT, 0, 0,
                                 display_vertices_));
   GL_CALL(glVertexAttribPointer(
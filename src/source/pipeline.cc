@@ -0,0 +1,290 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "gpupixel/source/pipeline.h"
+#include <algorithm>
+#include <map>
+#include "core/gpupixel_context.h"
+#include "filter/fused_color_filter.h"
+#include "gpupixel/filter/filter_group.h"
+#include "utils/util.h"
+
+namespace gpupixel {
+
+namespace {
+
+// Node whose DoUpdateSinks hands on the output of `node`: a filter group
+// passes the output of its terminal filter through. Null for a group without
+// one, which has no sinks.
+Source* OutputNode(Source* node) {
+  while (auto group = dynamic_cast<FilterGroup*>(node)) {
+    node = group->GetTerminalFilter().get();
+  }
+  return node;
+}
+
+// Reversed, so that reverse postorder renders siblings in the order the
+// recursive push does
+std::vector<std::shared_ptr<Sink>> SinksOf(Source* node) {
+  std::vector<std::shared_ptr<Sink>> sinks;
+  if (Source* output = OutputNode(node)) {
+    for (const auto& it : output->GetSinks()) {
+      sinks.push_back(it.first);
+    }
+  }
+  std::reverse(sinks.begin(), sinks.end());
+  return sinks;
+}
+
+bool IsColorFilter(Sink* sink) {
+  auto filter = dynamic_cast<Filter*>(sink);
+  std::string glsl;
+  std::vector<std::string> names;
+  return filter && !dynamic_cast<FilterGroup*>(filter) &&
+         filter->GetColorFunction(glsl, names);
+}
+
+}  // namespace
+
+std::shared_ptr<Pipeline> Pipeline::Create(std::shared_ptr<Source> source) {
+  if (!source) {
+    return nullptr;
+  }
+  return std::shared_ptr<Pipeline>(new Pipeline(source));
+}
+
+Pipeline::Pipeline(std::shared_ptr<Source> source)
+    : source_(source),
+      fusion_enabled_(true),
+      context_(GPUPixelContext::GetInstance()) {}
+
+Pipeline::~Pipeline() {
+  context_->SyncRunWithContext([this] { Release(); });
+}
+
+bool Pipeline::Compile() {
+  bool compiled = false;
+  context_->SyncRunWithContext([&] { compiled = CompileOnContext(); });
+  return compiled;
+}
+
+bool Pipeline::CompileOnContext() {
+  Release();
+  Watch(source_);
+
+  // Depth first from the source, without recursing so that deep graphs do
+  // not exhaust the stack. Reverse postorder puts every node after all the
+  // nodes that feed it, and in the order the recursive push would render a
+  // chain.
+  enum State { kVisiting = 1, kDone };
+  std::map<Sink*, State> states;
+  std::vector<std::shared_ptr<Sink>> postorder;
+  struct Frame {
+    std::shared_ptr<Sink> node;
+    std::vector<std::shared_ptr<Sink>> sinks;
+    size_t next;
+  };
+  std::vector<Frame> stack;
+  stack.push_back({nullptr, SinksOf(source_.get()), 0});
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    if (frame.next == frame.sinks.size()) {
+      if (frame.node) {
+        states[frame.node.get()] = kDone;
+        postorder.push_back(frame.node);
+      }
+      stack.pop_back();
+      continue;
+    }
+    std::shared_ptr<Sink> sink = frame.sinks[frame.next++];
+    Source* source = dynamic_cast<Source*>(sink.get());
+    auto state = states.find(sink.get());
+    if (source == source_.get() ||
+        (state != states.end() && state->second == kVisiting)) {
+      LOG_ERROR("Pipeline: the graph has a cycle");
+      Release();
+      return false;
+    }
+    if (state != states.end()) {
+      continue;
+    }
+    states[sink.get()] = kVisiting;
+    if (source) {
+      Watch(std::dynamic_pointer_cast<Source>(sink));
+    }
+    stack.push_back(
+        {sink, source ? SinksOf(source) : std::vector<std::shared_ptr<Sink>>(),
+         0});
+  }
+
+  passes_.push_back({nullptr, nullptr, {}});
+  for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+    passes_.push_back({*it, it->get(), {}});
+  }
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    if (Source* output = OutputNode(SourceOf(i))) {
+      for (const auto& it : output->GetSinks()) {
+        passes_[i].outputs.push_back({it.first.get(), it.second});
+      }
+    }
+  }
+
+  if (fusion_enabled_) {
+    FuseColorFilters();
+  }
+
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    Source* member = OutputNode(SourceOf(i));
+    if (!member) {
+      continue;
+    }
+    if (member->pipeline_ && member->pipeline_ != this) {
+      LOG_ERROR("Pipeline: a node already belongs to another pipeline");
+      Release();
+      return false;
+    }
+    member->pipeline_ = this;
+    member->pipeline_pass_ = (int)i;
+    members_.push_back(member);
+  }
+  return true;
+}
+
+Source* Pipeline::SourceOf(size_t pass) const {
+  return pass == 0 ? source_.get() : dynamic_cast<Source*>(passes_[pass].sink);
+}
+
+void Pipeline::Watch(std::shared_ptr<Source> node) {
+  while (node) {
+    watched_.push_back({node, node->GetGraphVersion()});
+    auto group = std::dynamic_pointer_cast<FilterGroup>(node);
+    node = group ? group->GetTerminalFilter() : nullptr;
+  }
+}
+
+bool Pipeline::IsGraphChanged() const {
+  for (const Watched& watched : watched_) {
+    if (watched.node->GetGraphVersion() != watched.graph_version) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Pipeline::FuseColorFilters() {
+  std::map<Sink*, size_t> indices;
+  std::map<Sink*, int> inputs;
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    indices[passes_[i].sink] = i;
+    for (const Output& output : passes_[i].outputs) {
+      ++inputs[output.sink];
+    }
+  }
+
+  std::vector<bool> fused(passes_.size(), false);
+  for (size_t i = 1; i < passes_.size(); ++i) {
+    if (fused[i] || !IsColorFilter(passes_[i].sink)) {
+      continue;
+    }
+    // Follows the chain while a stage feeds only the next, which has no other
+    // input
+    std::vector<size_t> run{i};
+    while (passes_[run.back()].outputs.size() == 1) {
+      const Output& output = passes_[run.back()].outputs[0];
+      if (output.tex_idx != 0 || inputs[output.sink] != 1 ||
+          !IsColorFilter(output.sink) ||
+          dynamic_cast<Source*>(output.sink)->framebuffer_scale_ != 1.0) {
+        break;
+      }
+      run.push_back(indices[output.sink]);
+    }
+    if (run.size() < 2) {
+      continue;
+    }
+
+    std::vector<std::shared_ptr<Filter>> stages;
+    for (size_t stage : run) {
+      stages.push_back(std::dynamic_pointer_cast<Filter>(passes_[stage].node));
+    }
+    auto filter = FusedColorFilter::Create(stages);
+    if (!filter) {
+      continue;
+    }
+    filter->SetFramebufferScale(stages[0]->framebuffer_scale_);
+
+    // Takes the place of the first stage, with the outputs of the last
+    for (Pass& pass : passes_) {
+      for (Output& output : pass.outputs) {
+        if (output.sink == passes_[i].sink) {
+          output.sink = filter.get();
+        }
+      }
+    }
+    passes_[i].outputs = passes_[run.back()].outputs;
+    passes_[i].node = filter;
+    passes_[i].sink = filter.get();
+    for (size_t j = 1; j < run.size(); ++j) {
+      fused[run[j]] = true;
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    if (fused[i]) {
+      continue;
+    }
+    if (kept != i) {
+      passes_[kept] = std::move(passes_[i]);
+    }
+    ++kept;
+  }
+  passes_.resize(kept);
+}
+
+void Pipeline::Release() {
+  for (Source* member : members_) {
+    if (member->pipeline_ == this) {
+      member->pipeline_ = nullptr;
+      member->pipeline_pass_ = 0;
+    }
+  }
+  members_.clear();
+  passes_.clear();
+  watched_.clear();
+}
+
+bool Pipeline::UpdateSinks(Source* node, int pass) {
+  if (pass == 0 && IsGraphChanged()) {
+    // The node may have stopped handing on the output of the source
+    if (!CompileOnContext() || node->pipeline_ != this ||
+        node->pipeline_pass_ != 0) {
+      return false;
+    }
+  }
+
+  for (const Output& output : passes_[pass].outputs) {
+    output.sink->SetInputFramebuffer(node->framebuffer_, node->output_rotation_,
+                                     output.tex_idx);
+  }
+  if (node->transient_framebuffer_) {
+    node->ReleaseTransientFramebuffer();
+  }
+  if (pass != 0) {
+    return true;
+  }
+
+  for (size_t i = 1; i < passes_.size(); ++i) {
+    Sink* sink = passes_[i].sink;
+    if (sink->IsReady()) {
+      sink->Render();
+      sink->ResetAndClean();
+    }
+  }
+  return true;
+}
+
+}  // namespace gpupixel
@@ -6,15 +6,28 @@
  */
 
 #include "gpupixel/source/source.h"
+#include <atomic>
 #include "core/gpupixel_context.h"
+#include "gpupixel/source/pipeline.h"
 #include "utils/util.h"
 
 namespace gpupixel {
 
+namespace {
+std::atomic<uint64_t> g_next_node_id{1};
+}  // namespace
+
 Source::Source()
     : framebuffer_(0),
       output_rotation_(RotationMode::NoRotation),
-      framebuffer_scale_(1.0) {}
+      framebuffer_scale_(1.0),
+      transient_framebuffer_(false),
+      released_width_(0),
+      released_height_(0),
+      node_id_(g_next_node_id++),
+      graph_version_(0),
+      pipeline_(nullptr),
+      pipeline_pass_(0) {}
 
 Source::~Source() {
   RemoveAllSinks();
@@ -29,6 +42,7 @@ std::shared_ptr<Source> Source::AddSink(std::shared_ptr<Sink> sink,
                                         int texIdx) {
   if (!HasSink(sink)) {
     sinks_[sink] = texIdx;
+    OnGraphChanged();
     sink->SetInputFramebuffer(framebuffer_, RotationMode::NoRotation, texIdx);
   }
   return std::dynamic_pointer_cast<Source>(sink);
@@ -46,11 +60,19 @@ void Source::RemoveSink(std::shared_ptr<Sink> sink) {
   auto itr = sinks_.find(sink);
   if (itr != sinks_.end()) {
     sinks_.erase(itr);
+    OnGraphChanged();
   }
 }
 
 void Source::RemoveAllSinks() {
-  sinks_.clear();
+  if (!sinks_.empty()) {
+    sinks_.clear();
+    OnGraphChanged();
+  }
+}
+
+void Source::OnGraphChanged() {
+  graph_version_.fetch_add(1, std::memory_order_relaxed);
 }
 
 bool Source::DoRender(bool updateSinks) {
@@ -61,9 +83,19 @@ bool Source::DoRender(bool updateSinks) {
 }
 
 void Source::DoUpdateSinks() {
+  // The pass ends once its draw is issued, before the sinks draw theirs
+  GPUPixelContext::GetInstance()->GetProfiler()->EndPass(this);
+  if (pipeline_ && pipeline_->UpdateSinks(this, pipeline_pass_)) {
+    return;
+  }
+  for (auto& it : sinks_) {
+    it.first->SetInputFramebuffer(framebuffer_, output_rotation_, it.second);
+  }
+  if (transient_framebuffer_) {
+    ReleaseTransientFramebuffer();
+  }
   for (auto& it : sinks_) {
     auto sink = it.first;
-    sink->SetInputFramebuffer(framebuffer_, output_rotation_, sinks_[sink]);
     if (sink->IsReady()) {
       sink->Render();
       sink->ResetAndClean();
@@ -78,34 +110,43 @@ void Source::SetFramebuffer(
   output_rotation_ = outputRotation;
 }
 
-int Source::GetRotatedFramebufferWidth() const {
+void Source::ReleaseTransientFramebuffer() {
   if (framebuffer_) {
-    if (rotationSwapsSize(output_rotation_)) {
-      return framebuffer_->GetHeight();
-    } else {
-      return framebuffer_->GetWidth();
-    }
-  } else {
-    return 0;
+    released_width_ = framebuffer_->GetWidth();
+    released_height_ = framebuffer_->GetHeight();
+    framebuffer_.reset();
   }
 }
 
+int Source::GetRotatedFramebufferWidth() const {
+  int width = framebuffer_ ? framebuffer_->GetWidth() : released_width_;
+  int height = framebuffer_ ? framebuffer_->GetHeight() : released_height_;
+  return rotationSwapsSize(output_rotation_) ? height : width;
+}
+
 int Source::GetRotatedFramebufferHeight() const {
-  if (framebuffer_) {
-    if (rotationSwapsSize(output_rotation_)) {
-      return framebuffer_->GetWidth();
-    } else {
-      return framebuffer_->GetHeight();
-    }
-  } else {
-    return 0;
-  }
+  int width = framebuffer_ ? framebuffer_->GetWidth() : released_width_;
+  int height = framebuffer_ ? framebuffer_->GetHeight() : released_height_;
+  return rotationSwapsSize(output_rotation_) ? width : height;
 }
 
 std::shared_ptr<GPUPixelFramebuffer> Source::GetFramebuffer() const {
   return framebuffer_;
 }
 
-void Source::ReleaseFramebuffer(bool returnToCache /* = true*/) {}
+void Source::ReleaseFramebuffer(bool returnToCache /* = true*/) {
+  if (!framebuffer_) {
+    return;
+  }
+  if (!returnToCache) {
+    GPUPixelContext* context = framebuffer_->GetContext();
+    context->SyncRunWithContext([&] {
+      context->GetFramebufferFactory()->RemoveFramebuffer(framebuffer_);
+    });
+  }
+  framebuffer_.reset();
+  released_width_ = 0;
+  released_height_ = 0;
+}
 
 }  // namespace gpupixel
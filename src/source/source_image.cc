@@ -21,6 +21,8 @@
 
 namespace gpupixel {
 
+SourceImage::SourceImage() : context_(GPUPixelContext::GetInstance()) {}
+
 std::shared_ptr<SourceImage> SourceImage::CreateFromBuffer(
     int width,
     int height,
@@ -65,18 +67,19 @@ void SourceImage::Init(int width,
                        ->CreateFramebuffer(width, height, true);
   }
   this->SetFramebuffer(framebuffer_);
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, this->GetFramebuffer()->GetTexture()));
+  GPUPixelContext::GetInstance()->BindTexture(
+      0, this->GetFramebuffer()->GetTexture());
 
   GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
                        GL_UNSIGNED_BYTE, pixels));
   image_bytes_.assign(pixels, pixels + width * height * 4);
-
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
 }
 
 void SourceImage::Render() {
-  gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext(
-      [&] { Source::DoRender(); });
+  context_->SyncRunWithContext([&] {
+    Source::DoRender();
+    context_->OnFrameEnd();
+  });
 }
 
 const unsigned char* SourceImage::GetRgbaImageBuffer() const {
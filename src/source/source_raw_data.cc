@@ -6,7 +6,10 @@
  */
 
 #include "gpupixel/source/source_raw_data.h"
+#include <cstring>
 #include "core/gpupixel_context.h"
+#include "utils/logging.h"
+#include "utils/trace.h"
 #include "utils/util.h"
 
 namespace gpupixel {
@@ -39,6 +42,89 @@ const std::string kFragmentShaderString = R"(
     })";
 #endif
 
+// BGRA bytes uploaded as RGBA, swapped back
+#if defined(GPUPIXEL_GLES_SHADER)
+const std::string kBGRAFragmentShaderString = R"(
+    varying mediump vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+
+    void main() {
+      gl_FragColor = texture2D(inputImageTexture, textureCoordinate).bgra;
+    })";
+#elif defined(GPUPIXEL_GL_SHADER)
+const std::string kBGRAFragmentShaderString = R"(
+    varying vec2 textureCoordinate;
+    uniform sampler2D inputImageTexture;
+
+    void main() {
+      gl_FragColor = texture2D(inputImageTexture, textureCoordinate).bgra;
+    })";
+#endif
+
+// Y, U and V planes, where U and V come from the luminance or the alpha of
+// their textures, to RGB
+const std::string kYUVFragmentShaderString = R"(
+    #ifdef GL_ES
+    #ifdef GL_FRAGMENT_PRECISION_HIGH
+    precision highp float;
+    #else
+    precision mediump float;
+    #endif
+    #endif
+    varying vec2 textureCoordinate;
+    uniform sampler2D yTexture;
+    uniform sampler2D uTexture;
+    uniform sampler2D vTexture;
+    uniform vec2 uSelect;
+    uniform vec2 vSelect;
+    uniform mat4 colorConversion;
+
+    void main() {
+      float y = texture2D(yTexture, textureCoordinate).r;
+      float u = dot(texture2D(uTexture, textureCoordinate).ra, uSelect);
+      float v = dot(texture2D(vTexture, textureCoordinate).ra, vSelect);
+      gl_FragColor = vec4((colorConversion * vec4(y, u, v, 1.0)).rgb, 1.0);
+    })";
+
+namespace {
+
+// Maps (Y, U, V, 1) as sampled to RGB, undoing the offsets and scaling of the
+// range
+Matrix4 YUVToRGBMatrix(GPUPIXEL_YUV_MATRIX matrix, GPUPIXEL_YUV_RANGE range) {
+  float kr = matrix == GPUPIXEL_YUV_MATRIX_BT709 ? 0.2126f : 0.299f;
+  float kb = matrix == GPUPIXEL_YUV_MATRIX_BT709 ? 0.0722f : 0.114f;
+  float kg = 1.0f - kr - kb;
+  bool full = range == GPUPIXEL_YUV_RANGE_FULL;
+  float y_scale = full ? 1.0f : 255.0f / 219.0f;
+  float c_scale = full ? 1.0f : 255.0f / 224.0f;
+  float y_offset = full ? 0.0f : -y_scale * 16.0f / 255.0f;
+  float c_zero = 128.0f / 255.0f;
+
+  float rv = 2.0f * (1.0f - kr) * c_scale;
+  float gu = -2.0f * kb * (1.0f - kb) / kg * c_scale;
+  float gv = -2.0f * kr * (1.0f - kr) / kg * c_scale;
+  float bu = 2.0f * (1.0f - kb) * c_scale;
+  return Matrix4(y_scale, 0.0f, rv, y_offset - rv * c_zero,  //
+                 y_scale, gu, gv, y_offset - (gu + gv) * c_zero,
+                 y_scale, bu, 0.0f, y_offset - bu * c_zero,  //
+                 0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// Bytes a frame spans, laid out as ProcessData describes
+size_t FrameSize(int height, int stride, GPUPIXEL_FRAME_TYPE type) {
+  size_t luma_size = (size_t)stride * height;
+  size_t chroma_height = (height + 1) / 2;
+  if (type == GPUPIXEL_FRAME_TYPE_I420) {
+    return luma_size + (size_t)(stride + 1) / 2 * chroma_height * 2;
+  }
+  if (type == GPUPIXEL_FRAME_TYPE_NV12 || type == GPUPIXEL_FRAME_TYPE_NV21) {
+    return luma_size + (size_t)stride * chroma_height;
+  }
+  return luma_size;
+}
+
+}  // namespace
+
 std::shared_ptr<SourceRawData> SourceRawData::Create() {
   auto ret = std::shared_ptr<SourceRawData>(new SourceRawData());
   gpupixel::GPUPixelContext::GetInstance()->SyncRunWithContext([&] {
@@ -49,11 +135,23 @@ std::shared_ptr<SourceRawData> SourceRawData::Create() {
   return ret;
 }
 
-SourceRawData::SourceRawData() {}
+SourceRawData::SourceRawData() : context_(GPUPixelContext::GetInstance()) {
+  transient_framebuffer_ = true;
+}
 
 SourceRawData::~SourceRawData() {
-  GPUPixelContext::GetInstance()->SyncRunWithContext(
-      [=] { glDeleteTextures(1, &texture_); });
+  context_->SyncRunWithContext([=] {
+    glDeleteTextures(1, &texture_);
+    context_->OnTextureDeleted(texture_);
+    glDeleteTextures(3, yuv_textures_);
+    for (uint32_t texture : yuv_textures_) {
+      context_->OnTextureDeleted(texture);
+    }
+    ReleaseUploadRing();
+    delete filter_program_;
+    delete bgra_program_;
+    delete yuv_program_;
+  });
 }
 
 bool SourceRawData::Init() {
@@ -66,17 +164,45 @@ bool SourceRawData::Init() {
   filter_tex_coord_attribute_ =
       filter_program_->GetAttribLocation("inputTextureCoordinate");
 
+  bgra_program_ = GPUPixelGLProgram::CreateWithShaderString(
+      kVertexShaderString, kBGRAFragmentShaderString);
+  bgra_position_attribute_ = bgra_program_->GetAttribLocation("position");
+  bgra_tex_coord_attribute_ =
+      bgra_program_->GetAttribLocation("inputTextureCoordinate");
+
+  yuv_program_ = GPUPixelGLProgram::CreateWithShaderString(
+      kVertexShaderString, kYUVFragmentShaderString);
+  yuv_position_attribute_ = yuv_program_->GetAttribLocation("position");
+  yuv_tex_coord_attribute_ =
+      yuv_program_->GetAttribLocation("inputTextureCoordinate");
+
   if (0 == texture_) {
     glGenTextures(1, &texture_);
   }
+  if (0 == yuv_textures_[0]) {
+    glGenTextures(3, yuv_textures_);
+  }
 
-  glBindTexture(GL_TEXTURE_2D, texture_);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  for (uint32_t texture : {texture_, yuv_textures_[0], yuv_textures_[1],
+                           yuv_textures_[2]}) {
+    // Y is drawn at its own size. Each chroma sample covers its 2x2 block of
+    // Y, as libyuv's and the usual CPU conversions replicate it, so a frame
+    // converts the same on the GPU as before it was handed in as RGBA.
+    GLint filter = texture == texture_ ? GL_LINEAR : GL_NEAREST;
+    context_->BindTexture(0, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  }
 
   glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  // Desktop GL and GLES 3 have GL_UNPACK_ROW_LENGTH, GLES 2 and WebGL 1 not
+#if defined(GL_UNPACK_ROW_LENGTH)
+  unpack_row_length_ =
+      !context_->IsGLES() || context_->GetGLMajorVersion() >= 3;
+#endif
+  pixel_buffers_supported_ = context_->SupportsPixelBuffers();
 
   return true;
 }
@@ -85,12 +211,55 @@ void SourceRawData::SetRotation(RotationMode rotation) {
   rotation_ = rotation;
 }
 
+void SourceRawData::SetYUVColorSpace(GPUPIXEL_YUV_MATRIX matrix,
+                                     GPUPIXEL_YUV_RANGE range) {
+  yuv_matrix_ = matrix;
+  yuv_range_ = range;
+}
+
+bool SourceRawData::SetUploadRingSize(int buffers) {
+  bool supported = buffers <= 0 || pixel_buffers_supported_;
+  // Queued behind the frames still using the ring
+  context_->SyncRunWithContext([&] {
+    ReleaseUploadRing();
+    if (supported && buffers > 0) {
+      upload_ring_.resize(buffers);
+    }
+  });
+  next_upload_buffer_ = 0;
+  return supported;
+}
+
 void SourceRawData::ProcessData(const uint8_t* data,
                                 int width,
                                 int height,
                                 int stride,
                                 GPUPIXEL_FRAME_TYPE type) {
-  GPUPixelContext::GetInstance()->SyncRunWithContext(
+  if (QueueRingFrame(data, width, height, stride, type, nullptr)) {
+    return;
+  }
+  context_->SyncRunWithContext(
+      [=] { GenerateTextureWithPixels(data, width, height, stride, type); });
+}
+
+std::future<void> SourceRawData::ProcessDataAsync(const uint8_t* data,
+                                                  int width,
+                                                  int height,
+                                                  int stride,
+                                                  GPUPIXEL_FRAME_TYPE type) {
+  std::future<void> rendered;
+  if (QueueRingFrame(data, width, height, stride, type, &rendered)) {
+    return rendered;
+  }
+  if (!upload_ring_.empty()) {
+    // The caller may reuse `data` once this returns, so a frame the ring did
+    // not take is rendered first
+    ProcessData(data, width, height, stride, type);
+    std::promise<void> done;
+    done.set_value();
+    return done.get_future();
+  }
+  return context_->AsyncRunWithContext(
       [=] { GenerateTextureWithPixels(data, width, height, stride, type); });
 }
 
@@ -98,52 +267,266 @@ int SourceRawData::GenerateTextureWithPixels(const uint8_t* pixels,
                                              int width,
                                              int height,
                                              int stride,
-                                             GPUPIXEL_FRAME_TYPE type) {
-  if (!framebuffer_ || (framebuffer_->GetWidth() != stride / 4 ||
-                        framebuffer_->GetHeight() != height)) {
-    framebuffer_ = GPUPixelContext::GetInstance()
-                       ->GetFramebufferFactory()
-                       ->CreateFramebuffer(stride / 4, height);
-  }
-  this->SetFramebuffer(framebuffer_, NoRotation);
+                                             GPUPIXEL_FRAME_TYPE type,
+                                             uint32_t unpack_buffer) {
+  bool yuv = type == GPUPIXEL_FRAME_TYPE_I420 ||
+             type == GPUPIXEL_FRAME_TYPE_NV12 ||
+             type == GPUPIXEL_FRAME_TYPE_NV21;
+  context_->GetProfiler()->BeginPass(this);
+  this->SetFramebuffer(GPUPixelContext::GetInstance()
+                           ->GetFramebufferFactory()
+                           ->CreateFramebuffer(width, height),
+                       NoRotation);
 
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture_));
+  GPUPixelGLProgram* program = filter_program_;
+  uint32_t position_attribute = filter_position_attribute_;
+  uint32_t tex_coord_attribute = filter_tex_coord_attribute_;
+  if (yuv) {
+    program = yuv_program_;
+    position_attribute = yuv_position_attribute_;
+    tex_coord_attribute = yuv_tex_coord_attribute_;
+  } else if (type == GPUPIXEL_FRAME_TYPE_BGRA) {
+    program = bgra_program_;
+    position_attribute = bgra_position_attribute_;
+    tex_coord_attribute = bgra_tex_coord_attribute_;
+  }
 
-  if (type == GPUPIXEL_FRAME_TYPE_BGRA) {
-#if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
-    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, stride / 4, height, 0,
-                         GL_BGRA, GL_UNSIGNED_BYTE, pixels));
+  {
+    TraceScope upload("upload", "io", GetNodeId());
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+    if (unpack_buffer) {
+      GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer));
+    }
+#endif
+    if (yuv) {
+      UploadYUV(pixels, width, height, stride, type);
+    } else {
+      UploadTexture(0, texture_, texture_storage_, GL_RGBA, 4, width, height,
+                    stride, pixels);
+    }
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+    if (unpack_buffer) {
+      GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    }
 #endif
-  } else if (type == GPUPIXEL_FRAME_TYPE_RGBA) {
-    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, stride / 4, height, 0,
-                         GL_RGBA, GL_UNSIGNED_BYTE, pixels));
   }
 
-  GPUPixelContext::GetInstance()->SetActiveGlProgram(filter_program_);
+  context_->SetActiveGlProgram(program);
   this->GetFramebuffer()->Activate();
 
   float imageVertices[]{
       -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f,
   };
 
-  GL_CALL(glEnableVertexAttribArray(filter_position_attribute_));
-  GL_CALL(glVertexAttribPointer(filter_position_attribute_, 2, GL_FLOAT, 0, 0,
+  context_->EnableVertexAttribArray(position_attribute);
+  GL_CALL(glVertexAttribPointer(position_attribute, 2, GL_FLOAT, 0, 0,
                                 imageVertices));
 
-  GL_CALL(glEnableVertexAttribArray(filter_tex_coord_attribute_));
-  GL_CALL(glVertexAttribPointer(filter_tex_coord_attribute_, 2, GL_FLOAT, 0, 0,
+  context_->EnableVertexAttribArray(tex_coord_attribute);
+  GL_CALL(glVertexAttribPointer(tex_coord_attribute, 2, GL_FLOAT, 0, 0,
                                 GetTextureCoordinate(rotation_)));
 
-  GL_CALL(glActiveTexture(GL_TEXTURE0));
-  GL_CALL(glBindTexture(GL_TEXTURE_2D, texture_));
-  filter_program_->SetUniformValue("inputImageTexture", 0);
+  if (!yuv) {
+    context_->BindTexture(0, texture_);
+    program->SetUniformValue("inputImageTexture", 0);
+  }
 
   // draw frame buffer
   glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
   this->GetFramebuffer()->Deactivate();
 
+  // Handed to the sinks, which return it to the pool once they have drawn
   Source::DoRender(true);
+  context_->OnFrameEnd();
   return 0;
 }
 
+bool SourceRawData::QueueRingFrame(const uint8_t* data,
+                                   int width,
+                                   int height,
+                                   int stride,
+                                   GPUPIXEL_FRAME_TYPE type,
+                                   std::future<void>* rendered) {
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+  if (upload_ring_.empty()) {
+    return false;
+  }
+  // Rows GL cannot skip would have to be packed from the buffer on the CPU
+  int texel_size = type == GPUPIXEL_FRAME_TYPE_RGBA ||
+                           type == GPUPIXEL_FRAME_TYPE_BGRA
+                       ? 4
+                       : type == GPUPIXEL_FRAME_TYPE_I420 ? 1 : 2;
+  if (stride % texel_size != 0) {
+    return false;
+  }
+
+  size_t index = next_upload_buffer_;
+  UploadBuffer& upload = upload_ring_[index];
+  if (upload.pending.valid()) {
+    TraceScope wait("upload ring wait", "io", GetNodeId());
+    upload.pending.wait();
+  }
+  size_t size = FrameSize(height, stride, type);
+  if (!upload.mapped || upload.size < size) {
+    context_->SyncRunWithContext([&] { MapUploadBuffer(upload, size); });
+    if (!upload.mapped) {
+      return false;
+    }
+  }
+  next_upload_buffer_ = (index + 1) % upload_ring_.size();
+
+  {
+    TraceScope copy("upload copy", "io", GetNodeId());
+    memcpy(upload.mapped, data, size);
+  }
+  std::shared_ptr<std::promise<void>> done;
+  if (rendered) {
+    done = std::make_shared<std::promise<void>>();
+    *rendered = done->get_future();
+  }
+  upload.pending = context_->AsyncRunWithContext([=] {
+    UploadBuffer& upload = upload_ring_[index];
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffer));
+    GLboolean intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+    upload.mapped = nullptr;
+    if (intact) {
+      GenerateTextureWithPixels(nullptr, width, height, stride, type,
+                                upload.buffer);
+    } else {
+      LOG_WARN("SourceRawData: upload buffer contents lost, frame dropped");
+    }
+    MapUploadBuffer(upload, upload.size);
+    if (done) {
+      done->set_value();
+    }
+  });
+  return true;
+#else
+  return false;
+#endif
+}
+
+void SourceRawData::MapUploadBuffer(UploadBuffer& upload, size_t size) {
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+  if (!upload.buffer) {
+    GL_CALL(glGenBuffers(1, &upload.buffer));
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, upload.buffer));
+  if (upload.mapped) {
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    upload.mapped = nullptr;
+  }
+  if (upload.size < size) {
+    GL_CALL(glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr,
+                         GL_STREAM_DRAW));
+    upload.size = size;
+  }
+  // Invalidating lets the driver hand out fresh memory rather than wait for
+  // the upload still reading the buffer
+  upload.mapped = (uint8_t*)glMapBufferRange(
+      GL_PIXEL_UNPACK_BUFFER, 0, upload.size,
+      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+  if (!upload.mapped) {
+    LOG_ERROR("SourceRawData: mapping upload buffer failed");
+  }
+  GL_CALL(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+#endif
+}
+
+void SourceRawData::ReleaseUploadRing() {
+#if GPUPIXEL_GL_HAS_PIXEL_BUFFERS
+  // Deleting a mapped buffer unmaps it
+  for (UploadBuffer& upload : upload_ring_) {
+    if (upload.buffer) {
+      glDeleteBuffers(1, &upload.buffer);
+    }
+  }
+#endif
+  upload_ring_.clear();
+}
+
+void SourceRawData::UploadTexture(uint32_t unit,
+                                  uint32_t texture,
+                                  TextureStorage& storage,
+                                  uint32_t format,
+                                  int texel_size,
+                                  int width,
+                                  int height,
+                                  int stride,
+                                  const uint8_t* pixels) {
+  context_->BindTexture(unit, texture);
+  // Mutable storage, reallocated only when the frame changes: immutable
+  // glTexStorage2D needs GL 4.2 or GLES 3.0, and the luminance formats of the
+  // YUV planes have no sized equivalent
+  if (storage.width != width || storage.height != height ||
+      storage.format != format) {
+    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
+                         GL_UNSIGNED_BYTE, nullptr));
+    storage = {width, height, format};
+  }
+
+  int row_size = width * texel_size;
+  if (stride == row_size) {
+    GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format,
+                            GL_UNSIGNED_BYTE, pixels));
+    return;
+  }
+#if defined(GL_UNPACK_ROW_LENGTH)
+  if (unpack_row_length_ && stride % texel_size == 0) {
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / texel_size);
+    GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format,
+                            GL_UNSIGNED_BYTE, pixels));
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    return;
+  }
+#endif
+  staging_.resize((size_t)row_size * height);
+  for (int y = 0; y < height; ++y) {
+    memcpy(&staging_[(size_t)y * row_size], pixels + (size_t)y * stride,
+           row_size);
+  }
+  GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format,
+                          GL_UNSIGNED_BYTE, staging_.data()));
+}
+
+void SourceRawData::UploadYUV(const uint8_t* pixels,
+                              int width,
+                              int height,
+                              int stride,
+                              GPUPIXEL_FRAME_TYPE type) {
+  int chroma_width = (width + 1) / 2;
+  int chroma_height = (height + 1) / 2;
+  const uint8_t* chroma = pixels + (size_t)stride * height;
+
+  UploadTexture(0, yuv_textures_[0], yuv_texture_storage_[0], GL_LUMINANCE, 1,
+                width, height, stride, pixels);
+  if (type == GPUPIXEL_FRAME_TYPE_I420) {
+    int chroma_stride = (stride + 1) / 2;
+    UploadTexture(1, yuv_textures_[1], yuv_texture_storage_[1], GL_LUMINANCE,
+                  1, chroma_width, chroma_height, chroma_stride, chroma);
+    UploadTexture(2, yuv_textures_[2], yuv_texture_storage_[2], GL_LUMINANCE,
+                  1, chroma_width, chroma_height, chroma_stride,
+                  chroma + (size_t)chroma_stride * chroma_height);
+    yuv_program_->SetUniformValue("vTexture", 2);
+    yuv_program_->SetUniformValue("uSelect", Vector2(1.0f, 0.0f));
+    yuv_program_->SetUniformValue("vSelect", Vector2(1.0f, 0.0f));
+  } else {
+    // U and V in the luminance and alpha of one texture
+    UploadTexture(1, yuv_textures_[1], yuv_texture_storage_[1],
+                  GL_LUMINANCE_ALPHA, 2, chroma_width, chroma_height, stride,
+                  chroma);
+    bool nv12 = type == GPUPIXEL_FRAME_TYPE_NV12;
+    yuv_program_->SetUniformValue("vTexture", 1);
+    yuv_program_->SetUniformValue("uSelect", nv12 ? Vector2(1.0f, 0.0f)
+                                                  : Vector2(0.0f, 1.0f));
+    yuv_program_->SetUniformValue("vSelect", nv12 ? Vector2(0.0f, 1.0f)
+                                                  : Vector2(1.0f, 0.0f));
+  }
+  yuv_program_->SetUniformValue("yTexture", 0);
+  yuv_program_->SetUniformValue("uTexture", 1);
+  yuv_program_->SetUniformValue("colorConversion",
+                                YUVToRGBMatrix(yuv_matrix_, yuv_range_));
+}
+
 }  // namespace gpupixel
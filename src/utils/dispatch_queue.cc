@@ -1,24 +1,70 @@
 #include "utils/dispatch_queue.h"
 
-DispatchQueue::DispatchQueue() : running(true) {
-  worker = std::thread([this]() {
-    workerId = std::this_thread::get_id();
-    while (running) {
-      std::function<void()> task;
-      {
-        std::unique_lock<std::mutex> lk(m);
-        cv.wait(lk, [this]() { return !taskQueue.empty() || !running; });
-
-        if (!running && taskQueue.empty()) {
-          return;
-        }
-
-        task = taskQueue.front();
-        taskQueue.pop();
-      }
-      task();
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#include <immintrin.h>
+#define GPUPIXEL_CPU_RELAX() _mm_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+#define GPUPIXEL_CPU_RELAX() __asm__ __volatile__("yield")
+#else
+#define GPUPIXEL_CPU_RELAX() \
+  do {                       \
+  } while (0)
+#endif
+
+namespace {
+
+// Spinning only helps when the other side can run concurrently; on a single
+// core it just burns the time slice the other thread needs
+size_t SpinCount(size_t spins) {
+  static const bool multi_core = std::thread::hardware_concurrency() > 1;
+  return multi_core ? spins : 0;
+}
+
+}  // namespace
+
+void DispatchQueue::Completion::signal() {
+  // Set under the lock so the waiter cannot return (and reuse or destroy this
+  // object) while the worker is still touching it
+  std::lock_guard<std::mutex> lk(m_);
+  done_.store(true, std::memory_order_release);
+  cv_.notify_one();
+}
+
+void DispatchQueue::Completion::wait() {
+  const size_t spins = SpinCount(kSpinCount);
+  for (size_t i = 0; i < spins; ++i) {
+    if (done_.load(std::memory_order_acquire)) {
+      break;
     }
-  });
+    GPUPIXEL_CPU_RELAX();
+  }
+  std::unique_lock<std::mutex> lk(m_);
+  cv_.wait(lk, [this]() { return done_.load(std::memory_order_acquire); });
+}
+
+void DispatchQueue::InlineTask::run() {
+  try {
+    invoke_(storage_);
+  } catch (...) {
+    // Exceptions are not propagated to synchronous or fire-and-forget callers
+  }
+  destroy_(storage_);
+  Completion* completion = completion_;
+  completion_ = nullptr;
+  if (completion) {
+    completion->signal();
+  }
+}
+
+DispatchQueue::DispatchQueue() {
+  for (size_t i = 0; i < kCapacity; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  worker_ = std::thread([this]() { workerLoop(); });
+  worker_id_ = worker_.get_id();
 }
 
 DispatchQueue::~DispatchQueue() {
@@ -26,21 +72,100 @@ DispatchQueue::~DispatchQueue() {
 }
 
 void DispatchQueue::stop() {
+  running_.store(false);
   {
-    std::unique_lock<std::mutex> lk(m);
-    running = false;
+    std::lock_guard<std::mutex> lk(wake_m_);
+    wake_cv_.notify_one();
   }
-  cv.notify_one();
-  if (worker.joinable()) {
-    worker.join();
+  if (worker_.joinable()) {
+    worker_.join();
   }
 }
 
 bool DispatchQueue::isWorkerThread() const {
-  return std::this_thread::get_id() == workerId;
+  return std::this_thread::get_id() == worker_id_;
+}
+
+DispatchQueue::Slot* DispatchQueue::claimSlot(size_t& position) {
+  position = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    Slot* slot = &slots_[position & (kCapacity - 1)];
+    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(position, position + 1,
+                                             std::memory_order_relaxed)) {
+        return slot;
+      }
+    } else if (diff < 0) {
+      return nullptr;
+    } else {
+      position = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void DispatchQueue::publishSlot(Slot* slot, size_t position) {
+  slot->sequence.store(position + 1, std::memory_order_release);
+  wakeWorker();
+}
+
+void DispatchQueue::wakeWorker() {
+  // Pairs with the fence in workerLoop: either the worker sees the new slot
+  // before sleeping, or we see it sleeping and wake it
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    // Taking the lock guarantees the worker is already blocked in wait();
+    // notifying after releasing it lets the worker run without contending
+    { std::lock_guard<std::mutex> lk(wake_m_); }
+    wake_cv_.notify_one();
+  }
 }
 
-void DispatchQueue::runTask(std::function<void()> task) {
+bool DispatchQueue::hasWork() const {
+  const Slot& slot = slots_[dequeue_pos_ & (kCapacity - 1)];
+  return slot.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+}
+
+bool DispatchQueue::runOne() {
+  if (!hasWork()) {
+    return false;
+  }
+  Slot& slot = slots_[dequeue_pos_ & (kCapacity - 1)];
+  slot.task.run();
+  slot.sequence.store(dequeue_pos_ + kCapacity, std::memory_order_release);
+  ++dequeue_pos_;
+  return true;
+}
+
+void DispatchQueue::workerLoop() {
+  while (true) {
+    if (runOne()) {
+      continue;
+    }
+
+    const size_t spins = SpinCount(kSpinCount);
+    for (size_t i = 0; i < spins && !hasWork(); ++i) {
+      GPUPIXEL_CPU_RELAX();
+    }
+    if (hasWork()) {
+      continue;
+    }
+
+    // Drain queued tasks before exiting so posted work is not dropped
+    if (!running_.load()) {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lk(wake_m_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wake_cv_.wait(lk, [this]() { return hasWork() || !running_.load(); });
+    sleeping_.store(false, std::memory_order_relaxed);
+  }
+}
+
+void DispatchQueue::runTask(TaskRef task) {
   // If current thread is the worker thread, execute the task directly to avoid
   // deadlock
   if (isWorkerThread()) {
@@ -48,31 +173,31 @@ void DispatchQueue::runTask(std::function<void()> task) {
     return;
   }
 
-  // Create a promise and future for synchronization
-  std::promise<void> promise;
-  std::future<void> future = promise.get_future();
+  // Each submitting thread reuses one completion object, and the task is only
+  // referenced since this call blocks until it has run
+  static thread_local Completion completion;
+  completion.reset();
+  push(task, &completion);
+  completion.wait();
+}
+
+std::future<void> DispatchQueue::runTaskAsync(std::function<void()> task) {
+  // The promise must outlive this call, so it is shared with the queued task
+  auto promise = std::make_shared<std::promise<void>>();
+  std::future<void> future = promise->get_future();
 
-  // Wrap the original task to set the promise when completed
-  auto wrappedTask = [task, &promise]() {
+  postTask([task = std::move(task), promise]() {
     try {
       task();
-      promise.set_value();
+      promise->set_value();
     } catch (...) {
       try {
-        promise.set_exception(std::current_exception());
+        promise->set_exception(std::current_exception());
       } catch (...) {
         // Ignore exceptions when the promise is already set
       }
     }
-  };
-
-  // Add the wrapped task to the queue
-  {
-    std::unique_lock<std::mutex> lk(m);
-    taskQueue.push(wrappedTask);
-  }
-  cv.notify_one();
+  });
 
-  // Wait for the task to complete
-  future.wait();
+  return future;
 }
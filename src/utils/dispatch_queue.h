@@ -1,29 +1,55 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
+#include <cstddef>
+#include <exception>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <new>
 #include <thread>
-#include <vector>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Non-owning reference to a callable.
+ *
+ * Used for synchronous submission, where the caller blocks until the task has
+ * run and the referenced callable therefore outlives its execution. Binding a
+ * lambda to a TaskRef never allocates.
+ */
+class TaskRef {
+ public:
+  template <typename F,
+            typename = typename std::enable_if<!std::is_same<
+                typename std::decay<F>::type,
+                TaskRef>::value>::type>
+  TaskRef(F&& callable)
+      : object_(const_cast<void*>(
+            static_cast<const void*>(std::addressof(callable)))),
+        invoke_([](void* object) {
+          (*static_cast<typename std::remove_reference<F>::type*>(object))();
+        }) {}
+
+  void operator()() const { invoke_(object_); }
+
+ private:
+  void* object_;
+  void (*invoke_)(void*);
+};
 
 /**
  * @brief Task queue that is executed on a background thread.
  *
- * Tasks are automatically processed by a background thread.
- * The thread waits when the queue is empty and is notified when new tasks are
- * added.
+ * Producers push into a bounded multi-producer / single-consumer ring of
+ * fixed-size task slots, so submitting work does not take a lock and does not
+ * allocate as long as the callable fits in a slot. Synchronous callers block on
+ * a per-thread completion object that is reused across calls. The worker
+ * thread spins briefly when the ring is empty before going to sleep.
  */
 class DispatchQueue {
- protected:
-  std::queue<std::function<void()>> taskQueue;
-  std::mutex m;
-  std::condition_variable cv;
-  std::thread worker;
-  bool running;
-  std::thread::id workerId;
-
  public:
   /**
    * Constructor starts the worker thread
@@ -37,12 +63,29 @@ class DispatchQueue {
 
   /**
    * Execute a task synchronously
+   * @param task The function to execute, referenced (not copied) until it has
+   * run
+   */
+  void runTask(TaskRef task);
+
+  /**
+   * Execute a task asynchronously
+   * @param task The function to execute
+   * @return Future that becomes ready once the task has run, carrying any
+   * exception thrown by the task
+   */
+  std::future<void> runTaskAsync(std::function<void()> task);
+
+  /**
+   * Queue a task without waiting for it (fire-and-forget). Callables larger
+   * than a slot fall back to one heap allocation.
    * @param task The function to execute
    */
-  void runTask(std::function<void()> task);
+  template <typename F>
+  void postTask(F&& task);
 
   /**
-   * Stop the worker thread
+   * Stop the worker thread, running any tasks that are still queued
    */
   void stop();
 
@@ -51,4 +94,122 @@ class DispatchQueue {
    * @return true if current thread is the worker thread
    */
   bool isWorkerThread() const;
+
+ private:
+  // Completion flag a synchronous caller waits on; one per submitting thread
+  class Completion {
+   public:
+    void reset() { done_.store(false, std::memory_order_relaxed); }
+    void signal();
+    void wait();
+
+   private:
+    std::atomic<bool> done_{false};
+    std::mutex m_;
+    std::condition_variable cv_;
+  };
+
+  // Type-erased callable stored inline in a ring slot
+  class InlineTask {
+   public:
+    static constexpr size_t kInlineSize = 48;
+
+    template <typename F>
+    void set(F&& callable, Completion* completion);
+    // Runs the callable, destroys it and signals the completion, if any
+    void run();
+
+   private:
+    template <typename Fn>
+    static constexpr bool fitsInline() {
+      return sizeof(Fn) <= kInlineSize &&
+             alignof(Fn) <= alignof(std::max_align_t);
+    }
+    template <typename Fn>
+    static Fn* stored(void* storage);
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    void (*invoke_)(void*) = nullptr;
+    void (*destroy_)(void*) = nullptr;
+    Completion* completion_ = nullptr;
+  };
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    InlineTask task;
+  };
+
+  static constexpr size_t kCapacity = 256;
+  static constexpr size_t kSpinCount = 2000;
+
+  // Claims a free slot and returns it, or nullptr if the ring is full
+  Slot* claimSlot(size_t& position);
+  void publishSlot(Slot* slot, size_t position);
+  template <typename F>
+  void push(F&& task, Completion* completion);
+  bool hasWork() const;
+  bool runOne();
+  void workerLoop();
+  void wakeWorker();
+
+  Slot slots_[kCapacity];
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  // Only touched by the worker thread
+  alignas(64) size_t dequeue_pos_ = 0;
+
+  std::atomic<bool> running_{true};
+  std::atomic<bool> sleeping_{false};
+  std::mutex wake_m_;
+  std::condition_variable wake_cv_;
+  std::thread worker_;
+  std::thread::id worker_id_;
 };
+
+template <typename Fn>
+Fn* DispatchQueue::InlineTask::stored(void* storage) {
+  if constexpr (fitsInline<Fn>()) {
+    return std::launder(reinterpret_cast<Fn*>(storage));
+  } else {
+    return *reinterpret_cast<Fn**>(storage);
+  }
+}
+
+template <typename F>
+void DispatchQueue::InlineTask::set(F&& callable, Completion* completion) {
+  using Fn = typename std::decay<F>::type;
+  if constexpr (fitsInline<Fn>()) {
+    new (storage_) Fn(std::forward<F>(callable));
+    destroy_ = [](void* storage) { stored<Fn>(storage)->~Fn(); };
+  } else {
+    *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(callable));
+    destroy_ = [](void* storage) { delete stored<Fn>(storage); };
+  }
+  invoke_ = [](void* storage) { (*stored<Fn>(storage))(); };
+  completion_ = completion;
+}
+
+template <typename F>
+void DispatchQueue::push(F&& task, Completion* completion) {
+  size_t position;
+  Slot* slot;
+  while (!(slot = claimSlot(position))) {
+    // A full ring can only drain through the worker, which must not wait on
+    // itself
+    if (isWorkerThread()) {
+      typename std::decay<F>::type inline_task(std::forward<F>(task));
+      inline_task();
+      if (completion) {
+        completion->signal();
+      }
+      return;
+    }
+    std::this_thread::yield();
+  }
+  slot->task.set(std::forward<F>(task), completion);
+  publishSlot(slot, position);
+}
+
+template <typename F>
+void DispatchQueue::postTask(F&& task) {
+  push(std::forward<F>(task), nullptr);
+}
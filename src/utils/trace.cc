@@ -0,0 +1,248 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#include "utils/trace.h"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "utils/util.h"
+
+namespace gpupixel {
+
+namespace {
+
+// A slot is written by its thread only. Its sequence is 0 while the write is
+// in progress and the event's index + 1 afterwards, so a reader copying the
+// slot concurrently can tell a torn copy from a consistent one.
+struct Slot {
+  std::atomic<uint64_t> sequence{0};
+  std::atomic<const char*> name{nullptr};
+  std::atomic<const char*> category{nullptr};
+  std::atomic<uint64_t> begin_ns{0};
+  std::atomic<uint64_t> end_ns{0};
+  std::atomic<uint64_t> arg{0};
+  std::atomic<bool> type_name{false};
+};
+
+struct Event {
+  const char* name;
+  const char* category;
+  uint64_t begin_ns;
+  uint64_t end_ns;
+  uint64_t arg;
+  bool type_name;
+};
+
+struct Ring {
+  uint32_t tid = 0;
+  std::atomic<const char*> thread_name{nullptr};
+  std::atomic<bool> exited{false};
+  // Events written so far, also the index of the next one
+  std::atomic<uint64_t> head{0};
+  // Events before this index are cleared
+  std::atomic<uint64_t> tail{0};
+  Slot slots[Trace::kRingSize];
+
+  void Add(const Event& event) {
+    uint64_t index = head.load(std::memory_order_relaxed);
+    Slot& slot = slots[index % Trace::kRingSize];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(event.name, std::memory_order_relaxed);
+    slot.category.store(event.category, std::memory_order_relaxed);
+    slot.begin_ns.store(event.begin_ns, std::memory_order_relaxed);
+    slot.end_ns.store(event.end_ns, std::memory_order_relaxed);
+    slot.arg.store(event.arg, std::memory_order_relaxed);
+    slot.type_name.store(event.type_name, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+    head.store(index + 1, std::memory_order_release);
+  }
+
+  // False if the slot is being rewritten
+  bool Read(uint64_t index, Event* event) const {
+    const Slot& slot = slots[index % Trace::kRingSize];
+    if (slot.sequence.load(std::memory_order_acquire) != index + 1) {
+      return false;
+    }
+    event->name = slot.name.load(std::memory_order_relaxed);
+    event->category = slot.category.load(std::memory_order_relaxed);
+    event->begin_ns = slot.begin_ns.load(std::memory_order_relaxed);
+    event->end_ns = slot.end_ns.load(std::memory_order_relaxed);
+    event->arg = slot.arg.load(std::memory_order_relaxed);
+    event->type_name = slot.type_name.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+  }
+};
+
+// Rings of all threads that have recorded. The mutex is only taken when a
+// thread records for the first time, on export and on clear.
+std::mutex g_rings_mutex;
+std::vector<std::shared_ptr<Ring>> g_rings;
+uint32_t g_next_tid = 1;
+
+// Keeps the thread's ring registered after the thread exits, so that its
+// events can still be exported
+struct ThreadRing {
+  std::shared_ptr<Ring> ring;
+
+  ~ThreadRing() {
+    if (ring) {
+      ring->exited = true;
+    }
+  }
+
+  Ring* Get() {
+    if (!ring) {
+      ring = std::make_shared<Ring>();
+      std::lock_guard<std::mutex> lock(g_rings_mutex);
+      ring->tid = g_next_tid++;
+      g_rings.push_back(ring);
+    }
+    return ring.get();
+  }
+};
+
+thread_local ThreadRing g_thread_ring;
+
+const std::chrono::steady_clock::time_point g_epoch =
+    std::chrono::steady_clock::now();
+
+void AppendEscaped(std::string& json, const char* text) {
+  for (const char* c = text; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      json += '\\';
+      json += *c;
+    } else if ((unsigned char)*c < 0x20) {
+      json += ' ';
+    } else {
+      json += *c;
+    }
+  }
+}
+
+}  // namespace
+
+std::atomic<bool> Trace::enabled_{false};
+
+void Trace::SetEnabled(bool enabled) {
+  enabled_ = enabled;
+}
+
+uint64_t Trace::Now() {
+  // Never 0, which TraceScope takes as "not recording"
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - g_epoch)
+             .count() +
+         1;
+}
+
+void Trace::AddEvent(const char* name,
+                     const char* category,
+                     uint64_t begin_ns,
+                     uint64_t end_ns,
+                     uint64_t arg,
+                     bool type_name) {
+  if (!IsEnabled()) {
+    return;
+  }
+  g_thread_ring.Get()->Add({name, category, begin_ns, end_ns, arg, type_name});
+}
+
+void Trace::SetThreadName(const char* name) {
+  g_thread_ring.Get()->thread_name = name;
+}
+
+std::string Trace::ToJson() {
+  std::vector<std::shared_ptr<Ring>> rings;
+  {
+    std::lock_guard<std::mutex> lock(g_rings_mutex);
+    rings = g_rings;
+  }
+
+  std::unordered_map<const char*, std::string> type_names;
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  auto separate = [&] {
+    if (!first) {
+      json += ",\n";
+    }
+    first = false;
+  };
+  for (const auto& ring : rings) {
+    const char* thread_name = ring->thread_name.load();
+    if (thread_name) {
+      separate();
+      json += Util::StringFormat(
+          "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+          "\"args\":{\"name\":\"",
+          ring->tid);
+      AppendEscaped(json, thread_name);
+      json += "\"}}";
+    }
+
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    uint64_t begin = ring->tail.load();
+    if (head > kRingSize && begin < head - kRingSize) {
+      begin = head - kRingSize;
+    }
+    for (uint64_t index = begin; index < head; ++index) {
+      Event event;
+      if (!ring->Read(index, &event)) {
+        continue;
+      }
+      separate();
+      json += "{\"name\":\"";
+      if (event.type_name) {
+        auto it = type_names.find(event.name);
+        if (it == type_names.end()) {
+          it = type_names.emplace(event.name, Util::DemangleTypeName(event.name)).first;
+        }
+        AppendEscaped(json, it->second.c_str());
+      } else {
+        AppendEscaped(json, event.name);
+      }
+      json += "\",\"cat\":\"";
+      AppendEscaped(json, event.category);
+      // Microseconds, the unit of the format
+      json += Util::StringFormat(
+          "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+          ring->tid, event.begin_ns / 1e3,
+          (event.end_ns - event.begin_ns) / 1e3);
+      if (event.arg) {
+        json += Util::StringFormat(",\"args\":{\"id\":%llu}",
+                                   (unsigned long long)event.arg);
+      }
+      json += "}";
+    }
+  }
+  json += "]}\n";
+  return json;
+}
+
+bool Trace::WriteJson(const std::string& path) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  std::string json = ToJson();
+  return file && file.write(json.data(), json.size());
+}
+
+void Trace::Clear() {
+  std::lock_guard<std::mutex> lock(g_rings_mutex);
+  std::vector<std::shared_ptr<Ring>> rings;
+  for (auto& ring : g_rings) {
+    if (!ring->exited) {
+      ring->tail = ring->head.load();
+      rings.push_back(ring);
+    }
+  }
+  g_rings.swap(rings);
+}
+
+}  // namespace gpupixel
@@ -0,0 +1,79 @@
+/*
+ * GPUPixel
+ *
+ * Created by PixPark on 2021/6/24.
+ * Copyright © 2021 PixPark. All rights reserved.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "gpupixel/gpupixel_define.h"
+
+namespace gpupixel {
+
+// Timeline of what each thread did, exported as Chrome trace-event JSON for
+// chrome://tracing or Perfetto. Every thread records complete events into a
+// ring of its own, so recording takes no lock and only the most recent
+// kRingSize events of a thread are kept. Disabled by default; while disabled
+// recording costs one relaxed atomic load.
+class GPUPIXEL_API Trace {
+ public:
+  static constexpr uint32_t kRingSize = 8192;
+
+  static void SetEnabled(bool enabled);
+  static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // Nanoseconds on the clock events are recorded with
+  static uint64_t Now();
+
+  // name and category must be string literals or otherwise outlive the trace.
+  // With type_name set, name is a std::type_info::name() and is shown
+  // demangled. arg, when not 0, is shown as the event's "id" argument.
+  static void AddEvent(const char* name,
+                       const char* category,
+                       uint64_t begin_ns,
+                       uint64_t end_ns,
+                       uint64_t arg = 0,
+                       bool type_name = false);
+
+  // Names the calling thread in the exported trace; name must outlive it
+  static void SetThreadName(const char* name);
+
+  // Events of all threads, oldest first per thread
+  static std::string ToJson();
+  static bool WriteJson(const std::string& path);
+  // Drops the recorded events and the rings of threads that have exited
+  static void Clear();
+
+ private:
+  static std::atomic<bool> enabled_;
+};
+
+// Records the lifetime of the scope as one event; a null name records nothing
+class TraceScope {
+ public:
+  TraceScope(const char* name, const char* category, uint64_t arg = 0)
+      : name_(name),
+        category_(category),
+        arg_(arg),
+        begin_ns_(name && Trace::IsEnabled() ? Trace::Now() : 0) {}
+  ~TraceScope() {
+    if (begin_ns_ && Trace::IsEnabled()) {
+      Trace::AddEvent(name_, category_, begin_ns_, Trace::Now(), arg_);
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  const char* name_;
+  const char* category_;
+  uint64_t arg_;
+  uint64_t begin_ns_;
+};
+
+}  // namespace gpupixel
@@ -7,6 +7,7 @@
 
 #include "utils/util.h"
 #include <cstdarg>
+#include <mutex>
 #include "core/gpupixel_context.h"
 #if defined(GPUPIXEL_ANDROID)
 #include <android/log.h>
@@ -19,6 +20,10 @@
 #include <stdio.h>
 #endif
 #include <chrono>
+#include <cstring>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cxxabi.h>
+#endif
 
 #if defined(GPUPIXEL_IOS) || defined(GPUPIXEL_MAC)
 @interface GPXObjcHelper : NSObject
@@ -100,6 +105,24 @@ void Util::SetResourcePath(const fs::path& path) {
   resource_root_path_ = path;
 }
 
+fs::path Util::program_cache_path_ = "";
+
+namespace {
+// Set from the caller's thread, read on context threads
+std::mutex g_program_cache_path_mutex;
+}  // namespace
+
+fs::path Util::GetProgramCachePath() {
+  std::lock_guard<std::mutex> lock(g_program_cache_path_mutex);
+  return program_cache_path_;
+}
+
+void Util::SetProgramCachePath(const fs::path& path) {
+  LOG_INFO("SetProgramCachePath: {}", path.string());
+  std::lock_guard<std::mutex> lock(g_program_cache_path_mutex);
+  program_cache_path_ = path;
+}
+
 #ifdef GPUPIXEL_WIN
 int vasprintf(char** strp, const char* fmt, va_list ap) {
   // _vscprintf tells you how big the buffer needs to be
@@ -156,6 +179,25 @@ int64_t Util::NowTimeMs() {
   return ts;
 }
 
+std::string Util::DemangleTypeName(const char* name) {
+  std::string result = name;
+#if defined(__GNUC__) || defined(__clang__)
+  int status = 0;
+  char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+  if (status == 0 && demangled) {
+    result = demangled;
+  }
+  free(demangled);
+#endif
+  // MSVC names are readable already, apart from the class keyword
+  for (const char* prefix : {"class ", "gpupixel::"}) {
+    if (result.compare(0, strlen(prefix), prefix) == 0) {
+      result.erase(0, strlen(prefix));
+    }
+  }
+  return result;
+}
+
 bool Util::IsAppleAppActive() {
 #if defined(GPUPIXEL_IOS)
   return [GPXObjcHelper isAppActive];
@@ -23,13 +23,22 @@ class GPUPIXEL_API Util {
  public:
   static std::string StringFormat(const char* fmt, ...);
   static int64_t NowTimeMs();
+  // Readable form of a std::type_info::name(), without the gpupixel
+  // namespace
+  static std::string DemangleTypeName(const char* name);
 
   static void SetResourcePath(const fs::path& path);
   static fs::path GetResourcePath();
 
+  // Directory for linked shader program binaries. Empty, the default,
+  // disables the on-disk program cache.
+  static void SetProgramCachePath(const fs::path& path);
+  static fs::path GetProgramCachePath();
+
   static bool IsAppleAppActive();
 
  private:
   static fs::path resource_root_path_;
+  static fs::path program_cache_path_;
 };
 }  // namespace gpupixel